@@ -40,6 +40,8 @@
 #include <cstdio>
 #include "rgy_version.h"
 #include "rgy_util.h"
+#include "cpu_info.h"
+#include "ram_speed.h"
 #include "NVEncDevice.h"
 #include "NVEncParam.h"
 #include "NVEncUtil.h"
@@ -107,6 +109,117 @@ static void show_nvenc_features(int deviceid) {
     }
 }
 
+static void show_csp_speed(const TCHAR *format) {
+    //出力形式 (txt / csv / json)
+    enum { CSP_SPEED_TXT, CSP_SPEED_CSV, CSP_SPEED_JSON };
+    int output_format = CSP_SPEED_TXT;
+    if (format && format[0] != '-') {
+        if (0 == _tcsicmp(format, _T("csv"))) {
+            output_format = CSP_SPEED_CSV;
+        } else if (0 == _tcsicmp(format, _T("json"))) {
+            output_format = CSP_SPEED_JSON;
+        }
+    }
+    if (output_format == CSP_SPEED_TXT) {
+        show_version();
+        _ftprintf(stdout, _T("\n%s\n"), getEnviromentInfo(false).c_str());
+    }
+
+    //計測するスレッド数 (1, 2, 4, ... 物理コア数)
+    const auto cpuinfo = get_cpu_info();
+    const int max_threads = std::max(1, (int)cpuinfo.physical_cores);
+    std::vector<int> thread_list;
+    for (int i = 1; i < max_threads; i *= 2) {
+        thread_list.push_back(i);
+    }
+    thread_list.push_back(max_threads);
+
+    //スレッド数ごとのメモリ帯域 (roofline) を計測する
+    //変換は読み込みと書き込みが混在するので、読み書きそれぞれの帯域から転送量に応じた合成帯域を求める
+    const int ram_test_size = (cpuinfo.max_cache_level) ? cpuinfo.caches[cpuinfo.max_cache_level-1].size / 1024 * 8 : 96 * 1024;
+    std::vector<std::pair<double, double>> ram_speed; //read, write (MB/s)
+    for (const auto thread_n : thread_list) {
+        ram_speed.push_back(std::make_pair(
+            ram_speed_mt(ram_test_size, RAM_SPEED_MODE_READ,  thread_n),
+            ram_speed_mt(ram_test_size, RAM_SPEED_MODE_WRITE, thread_n)));
+    }
+
+    static const std::pair<int, int> resolution_list[] = { { 1920, 1080 }, { 3840, 2160 }, { 7680, 4320 } };
+    if (output_format == CSP_SPEED_TXT) {
+        _ftprintf(stdout, _T("colorspace conversion speed (GB/s, roofline = memory bandwidth for the conversion's read/write ratio)\n"));
+        _ftprintf(stdout, _T("%-16s -> %-14s %-3s %-9s %-5s %-9s %7s %9s %9s %6s\n"),
+            _T("from"), _T("to"), _T("uv"), _T("simd"), _T("field"), _T("size"), _T("threads"), _T("speed"), _T("roofline"), _T("ratio"));
+    } else if (output_format == CSP_SPEED_CSV) {
+        _ftprintf(stdout, _T("from,to,uv_only,simd,interlaced,width,height,threads,speed_gbps,roofline_gbps,ratio\n"));
+    } else {
+        TCHAR cpu_name[256] = { 0 };
+        getCPUInfo(cpu_name);
+        _ftprintf(stdout, _T("{\n  \"version\": \"%s\",\n  \"cpu\": \"%s\",\n  \"results\": ["), VER_STR_FILEVERSION_TCHAR, cpu_name);
+    }
+    bool first = true;
+    for (const auto uv_only : { false, true }) {
+        for (const auto convert : get_convert_csp_func_list(RGY_CSP_NA, RGY_CSP_NA, uv_only, (uint32_t)-1)) {
+            double read_bytes = 0.0, write_bytes = 0.0;
+            convert_csp_frame_bytes(convert, 1, 1, &read_bytes, &write_bytes);
+            //インタレ用の関数が別に用意されている場合のみ、インタレも計測する
+            const int field_n = (convert->func[1] != convert->func[0]) ? 2 : 1;
+            for (int interlaced = 0; interlaced < field_n; interlaced++) {
+                for (const auto& res : resolution_list) {
+                    for (size_t ith = 0; ith < thread_list.size(); ith++) {
+                        const int thread_n = thread_list[ith];
+                        const double speed = convert_csp_speed(convert, res.first, res.second, interlaced != 0, thread_n) / 1024.0;
+                        const double roofline = (read_bytes + write_bytes) / (read_bytes / ram_speed[ith].first + write_bytes / ram_speed[ith].second) / 1024.0;
+                        const double ratio = (roofline > 0.0) ? speed / roofline : 0.0;
+                        if (speed < 0.0) {
+                            //計測用のバッファを確保できなかった
+                            if (output_format == CSP_SPEED_TXT) {
+                                _ftprintf(stdout, _T("%-16s -> %-14s %-3s %-9s %-5s %4dx%-4d %7d %9s %9.2f %6s\n"),
+                                    RGY_CSP_NAMES[convert->csp_from], RGY_CSP_NAMES[convert->csp_to], uv_only ? _T("yes") : _T("no"),
+                                    get_simd_str(convert->simd), interlaced ? _T("i") : _T("p"), res.first, res.second,
+                                    thread_n, _T("n/a"), roofline, _T("n/a"));
+                            } else if (output_format == CSP_SPEED_CSV) {
+                                _ftprintf(stdout, _T("%s,%s,%d,%s,%d,%d,%d,%d,,%.3f,\n"),
+                                    RGY_CSP_NAMES[convert->csp_from], RGY_CSP_NAMES[convert->csp_to], uv_only ? 1 : 0,
+                                    get_simd_str(convert->simd), interlaced, res.first, res.second,
+                                    thread_n, roofline);
+                            } else {
+                                _ftprintf(stdout, _T("%s\n    { \"from\": \"%s\", \"to\": \"%s\", \"uv_only\": %s, \"simd\": \"%s\", \"interlaced\": %s, ")
+                                    _T("\"width\": %d, \"height\": %d, \"threads\": %d, \"speed_gbps\": null, \"roofline_gbps\": %.3f, \"ratio\": null }"),
+                                    first ? _T("") : _T(","),
+                                    RGY_CSP_NAMES[convert->csp_from], RGY_CSP_NAMES[convert->csp_to], uv_only ? _T("true") : _T("false"),
+                                    get_simd_str(convert->simd), interlaced ? _T("true") : _T("false"), res.first, res.second,
+                                    thread_n, roofline);
+                            }
+                        } else if (output_format == CSP_SPEED_TXT) {
+                            _ftprintf(stdout, _T("%-16s -> %-14s %-3s %-9s %-5s %4dx%-4d %7d %9.2f %9.2f %5.1f%%\n"),
+                                RGY_CSP_NAMES[convert->csp_from], RGY_CSP_NAMES[convert->csp_to], uv_only ? _T("yes") : _T("no"),
+                                get_simd_str(convert->simd), interlaced ? _T("i") : _T("p"), res.first, res.second,
+                                thread_n, speed, roofline, ratio * 100.0);
+                        } else if (output_format == CSP_SPEED_CSV) {
+                            _ftprintf(stdout, _T("%s,%s,%d,%s,%d,%d,%d,%d,%.3f,%.3f,%.4f\n"),
+                                RGY_CSP_NAMES[convert->csp_from], RGY_CSP_NAMES[convert->csp_to], uv_only ? 1 : 0,
+                                get_simd_str(convert->simd), interlaced, res.first, res.second,
+                                thread_n, speed, roofline, ratio);
+                        } else {
+                            _ftprintf(stdout, _T("%s\n    { \"from\": \"%s\", \"to\": \"%s\", \"uv_only\": %s, \"simd\": \"%s\", \"interlaced\": %s, ")
+                                _T("\"width\": %d, \"height\": %d, \"threads\": %d, \"speed_gbps\": %.3f, \"roofline_gbps\": %.3f, \"ratio\": %.4f }"),
+                                first ? _T("") : _T(","),
+                                RGY_CSP_NAMES[convert->csp_from], RGY_CSP_NAMES[convert->csp_to], uv_only ? _T("true") : _T("false"),
+                                get_simd_str(convert->simd), interlaced ? _T("true") : _T("false"), res.first, res.second,
+                                thread_n, speed, roofline, ratio);
+                        }
+                        first = false;
+                        fflush(stdout);
+                    }
+                }
+            }
+        }
+    }
+    if (output_format == CSP_SPEED_JSON) {
+        _ftprintf(stdout, _T("\n  ]\n}\n"));
+    }
+}
+
 int parse_print_options(const TCHAR *option_name, const TCHAR *arg1) {
 
 #define IS_OPTION(x) (0 == _tcscmp(option_name, _T(x)))
@@ -139,6 +252,10 @@ int parse_print_options(const TCHAR *option_name, const TCHAR *arg1) {
         show_environment_info();
         return 1;
     }
+    if (IS_OPTION("check-csp-speed")) {
+        show_csp_speed(arg1);
+        return 1;
+    }
     if (IS_OPTION("check-features")) {
         int deviceid = 0;
         if (arg1 && arg1[0] != '-') {
@@ -132,6 +132,10 @@ tstring encoder_help() {
         _T("   --check-features [<int>]     check for NVEnc Features for specified DeviceId\n")
         _T("                                  if unset, will check DeviceId #0\n")
         _T("   --check-environment          check for Environment Info\n")
+        _T("   --check-csp-speed [<string>] check speed of colorspace conversion\n")
+        _T("                                  for each resolution and thread count,\n")
+        _T("                                  compared with memory bandwidth.\n")
+        _T("                                  output format: txt(default), csv, json\n")
 #if ENABLE_AVSW_READER
         _T("   --check-avversion            show dll version\n")
         _T("   --check-codecs               show codecs available\n")
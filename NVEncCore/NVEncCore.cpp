@@ -64,6 +64,7 @@
 #include "rgy_output_avcodec.h"
 #include "NVEncParam.h"
 #include "NVEncUtil.h"
+#include "rgy_host_frame_pool.h"
 #include "NVEncFilter.h"
 #include "NVEncFilterDelogo.h"
 #include "NVEncFilterDenoiseKnn.h"
@@ -259,6 +260,7 @@ NVEncCore::NVEncCore() :
     m_appliedDynamicRC(DYNAMIC_PARAM_NOT_SELECTED),
     m_pipelineDepth(PIPELINE_DEPTH),
     m_inputHostBuffer(),
+    m_inputHostPad(),
     m_trimParam(),
     m_pFileReader(),
     m_AudioReaders(),
@@ -275,6 +277,8 @@ NVEncCore::NVEncCore() :
     m_hdr10plusCopy(false),
 #endif //#if ENABLE_AVSW_READER
     m_hdr10plus(),
+    m_seiWriter(),
+    m_seiPayloads(),
     m_hdrsei(),
     m_vpFilters(),
     m_pLastFilterParam(),
@@ -450,8 +454,10 @@ NVENCSTATUS NVEncCore::InitInput(InEncodeVideoParam *inputParam, const std::vect
         }
     }
     if (inputParam->vpp.smooth.enable && inputParam->vpp.smooth.qp <= 0) {
-        m_qpTable = std::make_unique<RGYListRef<RGYFrameDataQP>>();
+        m_qpTable = std::make_unique<RGYObjectPool<RGYFrameDataQP>>();
     }
+    //読み込み用のバッファの確保前に設定しておく
+    RGYHostFramePool::get()->setHugePage(inputParam->ctrl.hostHugePage);
 
     if (initReaders(m_pFileReader, m_AudioReaders, &inputParam->input,
         m_pStatus, &inputParam->common, &inputParam->ctrl, HWDecCodecCsp, subburnTrackId,
@@ -471,8 +477,9 @@ NVENCSTATUS NVEncCore::InitInput(InEncodeVideoParam *inputParam, const std::vect
 #if ENABLE_AVSW_READER
         std::dynamic_pointer_cast<RGYInputAvcodec>(m_pFileReader) == nullptr &&
 #endif
+        m_pFileReader->GetTrimParam().list.size() == 0 &&
         inputParam->common.pTrimList && inputParam->common.nTrimCount > 0) {
-        //avhw/avswリーダー以外は、trimは自分ではセットされないので、ここでセットする
+        //avhw/avsw/raw/y4mリーダー以外は、trimは自分ではセットされないので、ここでセットする
         sTrimParam trimParam;
         trimParam.list = make_vector(inputParam->common.pTrimList, inputParam->common.nTrimCount);
         trimParam.offset = 0;
@@ -896,6 +903,8 @@ NVENCSTATUS NVEncCore::ProcessOutput(const EncodeBuffer *pEncodeBuffer) {
         }
         PrintMes(RGY_LOG_TRACE, _T("Output frame %d: size %zu, pts %lld, dts %lld\n"), m_pStatus->m_sData.frameOut, bitstream.size(), bitstream.pts(), bitstream.dts());
         auto outErr = m_pFileWriter->WriteNextFrame(&bitstream);
+        //出力側で作成されたNAL unitの一覧のキャッシュを解放する (データはエンコーダのバッファを参照しているだけ)
+        bitstream.clear();
         nvStatus = m_dev->encoder()->NvEncUnlockBitstream(pEncodeBuffer->stOutputBfr.hBitstreamBuffer);
         if (nvStatus == NV_ENC_SUCCESS && outErr != RGY_ERR_NONE) {
             nvStatus = NV_ENC_ERR_GENERIC;
@@ -949,6 +958,12 @@ NVENCSTATUS NVEncCore::Deinitialize() {
         ReleaseIOBuffers();
     }
     m_inputHostBuffer.clear();
+    if (m_dev) {
+        //ページロックしたバッファは、デバイスの破棄前にunpinして解放する
+        NVEncCtxAutoLock(ctxlock(m_dev->vidCtxLock()));
+        RGYHostFramePool::get()->clear();
+        RGYHostFramePool::get()->setPinFunc(nullptr, nullptr);
+    }
     m_cuvidDec.reset();
     if (m_dev) {
         m_dev->close_device();
@@ -1072,14 +1087,16 @@ NVENCSTATUS NVEncCore::AllocateIOBuffers(uint32_t uInputWidth, uint32_t uInputHe
         m_inputHostBuffer.resize(m_pipelineDepth);
         //このアライメントは読み込み時の色変換の並列化のために必要
         const int align = 64 * (RGY_CSP_BIT_DEPTH[pInputInfo->csp] > 8 ? 2 : 1);
-        const int bufWidth  = pInputInfo->srcWidth  - pInputInfo->crop.e.left - pInputInfo->crop.e.right;
-        const int bufHeight = pInputInfo->srcHeight - pInputInfo->crop.e.bottom - pInputInfo->crop.e.up;
+        const int bufWidth  = pInputInfo->srcWidth  - pInputInfo->crop.e.left - pInputInfo->crop.e.right + m_inputHostPad.e.left + m_inputHostPad.e.right;
+        const int bufHeight = pInputInfo->srcHeight - pInputInfo->crop.e.bottom - pInputInfo->crop.e.up + m_inputHostPad.e.up + m_inputHostPad.e.bottom;
+        //読み込み時にpaddingする場合、色変換の行末のはみ出しが次の行に及ばないよう余裕を持たせる
+        const int bufPitchWidth = bufWidth + (cropEnabled(m_inputHostPad) ? 64 : 0);
         int bufPitch = 0;
         int bufSize = 0;
         switch (pInputInfo->csp) {
         case RGY_CSP_NV12:
         case RGY_CSP_YV12:
-            bufPitch  = ALIGN(bufWidth, align);
+            bufPitch  = ALIGN(bufPitchWidth, align);
             bufSize = bufPitch * bufHeight * 3 / 2; break;
         case RGY_CSP_P010:
         case RGY_CSP_YV12_09:
@@ -1087,12 +1104,12 @@ NVENCSTATUS NVEncCore::AllocateIOBuffers(uint32_t uInputWidth, uint32_t uInputHe
         case RGY_CSP_YV12_12:
         case RGY_CSP_YV12_14:
         case RGY_CSP_YV12_16:
-            bufPitch = ALIGN(bufWidth * 2, align);
+            bufPitch = ALIGN(bufPitchWidth * 2, align);
             bufSize = bufPitch * bufHeight * 3 / 2; break;
         case RGY_CSP_NV16:
         case RGY_CSP_YUY2:
         case RGY_CSP_YUV422:
-            bufPitch  = ALIGN(bufWidth, align);
+            bufPitch  = ALIGN(bufPitchWidth, align);
             bufSize = bufPitch * bufHeight * 2; break;
         case RGY_CSP_P210:
         case RGY_CSP_YUV422_09:
@@ -1100,38 +1117,54 @@ NVENCSTATUS NVEncCore::AllocateIOBuffers(uint32_t uInputWidth, uint32_t uInputHe
         case RGY_CSP_YUV422_12:
         case RGY_CSP_YUV422_14:
         case RGY_CSP_YUV422_16:
-            bufPitch = ALIGN(bufWidth * 2, align);
+            bufPitch = ALIGN(bufPitchWidth * 2, align);
             bufSize = bufPitch * bufHeight * 2; break;
         case RGY_CSP_YUV444:
-            bufPitch  = ALIGN(bufWidth, align);
+            bufPitch  = ALIGN(bufPitchWidth, align);
             bufSize = bufPitch * bufHeight * 3; break;
         case RGY_CSP_YUV444_09:
         case RGY_CSP_YUV444_10:
         case RGY_CSP_YUV444_12:
         case RGY_CSP_YUV444_14:
         case RGY_CSP_YUV444_16:
-            bufPitch = ALIGN(bufWidth * 2, align);
+            bufPitch = ALIGN(bufPitchWidth * 2, align);
             bufSize = bufPitch * bufHeight * 3; break;
         case RGY_CSP_RGB24:
         case RGY_CSP_RGB24R:
-            bufPitch = ALIGN(bufWidth * 3, align);
+            bufPitch = ALIGN(bufPitchWidth * 3, align);
             bufSize = bufPitch * bufHeight; break;
         case RGY_CSP_RGB32:
         case RGY_CSP_RGB32R:
-            bufPitch = ALIGN(bufWidth * 4, align);
+            bufPitch = ALIGN(bufPitchWidth * 4, align);
             bufSize = bufPitch * bufHeight; break;
         case RGY_CSP_RGB:
         case RGY_CSP_GBR:
-            bufPitch  = ALIGN(bufWidth, align);
+            bufPitch  = ALIGN(bufPitchWidth, align);
             bufSize = bufPitch * bufHeight * 3; break;
         case RGY_CSP_RGBA:
         case RGY_CSP_GBRA:
-            bufPitch  = ALIGN(bufWidth, align);
+            bufPitch  = ALIGN(bufPitchWidth, align);
             bufSize = bufPitch * bufHeight * 4; break;
         default:
             PrintMes(RGY_LOG_ERROR, _T("Unsupported csp at AllocateIOBuffers.\n"));
             return NV_ENC_ERR_UNSUPPORTED_PARAM;
         }
+        //入力フレームのバッファはページロックしてプールから取得し、GPUへの転送をDMAで直接行えるようにする
+        auto hostPool = RGYHostFramePool::get();
+        hostPool->setPinFunc([](void *ptr, size_t size) {
+            return cudaHostRegister(ptr, size, cudaHostRegisterPortable) == cudaSuccess;
+        }, [](void *ptr) {
+            cudaHostUnregister(ptr);
+        });
+        {
+#if ENABLE_AVSW_READER
+            CCtxAutoLock ctxLock(m_dev->vidCtxLock());
+#endif //#if ENABLE_AVSW_READER
+            if (!hostPool->reserve(bufSize, (int)m_inputHostBuffer.size(), true)) {
+                PrintMes(RGY_LOG_ERROR, _T("Failed to allocate input host buffer.\n"));
+                return NV_ENC_ERR_OUT_OF_MEMORY;
+            }
+        }
         for (uint32_t i = 0; i < m_inputHostBuffer.size(); i++) {
             m_inputHostBuffer[i].frameInfo.width = bufWidth;
             m_inputHostBuffer[i].frameInfo.height = bufHeight;
@@ -1147,12 +1180,17 @@ NVENCSTATUS NVEncCore::AllocateIOBuffers(uint32_t uInputWidth, uint32_t uInputHe
 #if ENABLE_AVSW_READER
             CCtxAutoLock ctxLock(m_dev->vidCtxLock());
 #endif //#if ENABLE_AVSW_READER
-            auto cudaret = cudaMallocHost(&m_inputHostBuffer[i].frameInfo.ptr, bufSize);
-            if (cudaret != cudaSuccess) {
-                PrintMes(RGY_LOG_ERROR, _T("Error cudaEventRecord: %d (%s).\n"), cudaret, char_to_tstring(_cudaGetErrorEnum(cudaret)).c_str());
-                return NV_ENC_ERR_GENERIC;
+            m_inputHostBuffer[i].hostBuf = hostPool->alloc(bufSize, true);
+            if (!m_inputHostBuffer[i].hostBuf) {
+                PrintMes(RGY_LOG_ERROR, _T("Failed to allocate input host buffer.\n"));
+                return NV_ENC_ERR_OUT_OF_MEMORY;
             }
+            m_inputHostBuffer[i].frameInfo.ptr = m_inputHostBuffer[i].hostBuf.get();
         }
+        const auto hostPoolStats = hostPool->stats();
+        PrintMes(RGY_LOG_DEBUG, _T("Allocated input host buffer: %d x %d bytes (huge page %.1f MB, pinned %.1f MB).\n"),
+            (int)m_inputHostBuffer.size(), bufSize,
+            hostPoolStats.hugepage_bytes / (1024.0 * 1024.0), hostPoolStats.pinned_bytes / (1024.0 * 1024.0));
     }
 
     m_stEOSOutputBfr.bEOSFlag = TRUE;
@@ -1914,6 +1952,46 @@ RGY_ERR NVEncCore::InitFilters(const InEncodeVideoParam *inputParam) {
         inputFrame.height = inputParam->input.dstHeight;
         resizeRequired = false;
     }
+    //raw/y4m読みでpadding以外のフィルタが不要な場合は、読み込み時の色変換と同時にCPUでpaddingを行い、
+    //NVEncFilterPadを使用しないようにする
+    bool padOnInput = false;
+#if ENABLE_RAW_READER
+    if (inputParam->vpp.pad.enable
+        && !resizeRequired
+        && !cropRequired
+        && inputParam->vpp.deinterlace == cudaVideoDeinterlaceMode_Weave
+        && !inputParam->vpp.delogo.enable
+        && inputParam->vpp.gaussMaskSize <= 0
+        && !inputParam->vpp.unsharp.enable
+        && !inputParam->vpp.knn.enable
+        && !inputParam->vpp.pmd.enable
+        && !inputParam->vpp.smooth.enable
+        && !inputParam->vpp.deband.enable
+        && !inputParam->vpp.edgelevel.enable
+        && !inputParam->vpp.afs.enable
+        && !inputParam->vpp.nnedi.enable
+        && !inputParam->vpp.yadif.enable
+        && !inputParam->vpp.tweak.enable
+        && !inputParam->vpp.transform.enable
+        && !inputParam->vpp.colorspace.enable
+        && inputParam->vpp.subburn.size() == 0
+        && !inputParam->vpp.rff
+        && !inputParam->vpp.selectevery.enable) {
+        auto pRawReader = std::dynamic_pointer_cast<RGYInputRaw>(m_pFileReader);
+        sInputCrop pad;
+        pad.e.left   = inputParam->vpp.pad.left;
+        pad.e.up     = inputParam->vpp.pad.top;
+        pad.e.right  = inputParam->vpp.pad.right;
+        pad.e.bottom = inputParam->vpp.pad.bottom;
+        if (pRawReader && pRawReader->SetPadding(pad)) {
+            padOnInput = true;
+            m_inputHostPad = pad;
+            inputFrame.width  += pad.e.left + pad.e.right;
+            inputFrame.height += pad.e.up + pad.e.bottom;
+            PrintMes(RGY_LOG_DEBUG, _T("InitFilters: padding will be done while reading input.\n"));
+        }
+    }
+#endif //#if ENABLE_RAW_READER
 
     //picStructの設定
     m_stPicStruct = picstruct_rgy_to_enc(inputParam->input.picstruct);
@@ -1971,7 +2049,7 @@ RGY_ERR NVEncCore::InitFilters(const InEncodeVideoParam *inputParam) {
         || inputParam->vpp.tweak.enable
         || inputParam->vpp.transform.enable
         || inputParam->vpp.colorspace.enable
-        || inputParam->vpp.pad.enable
+        || (inputParam->vpp.pad.enable && !padOnInput)
         || inputParam->vpp.subburn.size() > 0
         || inputParam->vpp.rff
         || inputParam->vpp.selectevery.enable
@@ -2248,7 +2326,6 @@ RGY_ERR NVEncCore::InitFilters(const InEncodeVideoParam *inputParam) {
             unique_ptr<NVEncFilter> filter(new NVEncFilterSmooth());
             shared_ptr<NVEncFilterParamSmooth> param(new NVEncFilterParamSmooth());
             param->smooth = inputParam->vpp.smooth;
-            param->qpTableRef = m_qpTable.get();
             param->compute_capability = m_dev->cc();
             param->frameIn = inputFrame;
             param->frameOut = inputFrame;
@@ -2514,7 +2591,7 @@ RGY_ERR NVEncCore::InitFilters(const InEncodeVideoParam *inputParam) {
             m_encFps = param->baseFps;
         }
         //padding
-        if (inputParam->vpp.pad.enable) {
+        if (inputParam->vpp.pad.enable && !padOnInput) {
             unique_ptr<NVEncFilter> filter(new NVEncFilterPad());
             shared_ptr<NVEncFilterParamPad> param(new NVEncFilterParamPad());
             param->pad = inputParam->vpp.pad;
@@ -3083,14 +3160,15 @@ NVENCSTATUS NVEncCore::NvEncEncodeFrame(EncodeBuffer *pEncodeBuffer, int id, uin
         encPicParams.encodePicFlags |= NV_ENC_PIC_FLAG_FORCEIDR;
     }
 #endif //#if ENABLE_AVSW_READER
-    vector<uint8_t> dhdr10plus_sei;
-    vector<NV_ENC_SEI_PAYLOAD> sei_payload;
+    //SEIのpayloadはm_seiWriterのバッファにまとめ、フレームごとの確保を避ける
+    m_seiWriter.clear();
+    m_seiPayloads.clear();
     const int codec = get_value_from_guid(m_stCodecGUID, list_nvenc_codecs);
     if (codec == NV_ENC_HEVC) {
         if (m_hdr10plus) {
             const auto data = m_hdr10plus->getData(inputFrameId);
             if (data && data->size() > 0) {
-                dhdr10plus_sei = *data;
+                m_seiWriter.addT35(data->data(), data->size());
             }
         } else if (frameDataList.size() > 0) {
             auto data = std::find_if(frameDataList.begin(), frameDataList.end(), [](const std::shared_ptr<RGYFrameData>& frameData) {
@@ -3099,21 +3177,21 @@ NVENCSTATUS NVEncCore::NvEncEncodeFrame(EncodeBuffer *pEncodeBuffer, int id, uin
             if (data != frameDataList.end()) {
                 auto hdr10plus = dynamic_cast<RGYFrameDataHDR10plus *>(data->get());
                 if (hdr10plus && hdr10plus->getData().size() > 0) {
-                    dhdr10plus_sei = hdr10plus->getData();
+                    m_seiWriter.addT35(hdr10plus->getData().data(), hdr10plus->getData().size());
                 }
             }
         }
-        if (dhdr10plus_sei.size() > 0) {
+        for (const auto& seiPayload : m_seiWriter.payloads()) {
             NV_ENC_SEI_PAYLOAD payload;
-            payload.payload = dhdr10plus_sei.data();
-            payload.payloadSize = (uint32_t)dhdr10plus_sei.size();
-            payload.payloadType = USER_DATA_REGISTERED_ITU_T_T35;
-            sei_payload.push_back(payload);
+            payload.payload = (uint8_t *)m_seiWriter.payloadData(seiPayload);
+            payload.payloadSize = (uint32_t)seiPayload.size;
+            payload.payloadType = (uint32_t)seiPayload.type;
+            m_seiPayloads.push_back(payload);
         }
     }
-    if (sei_payload.size() > 0) {
-        encPicParams.codecPicParams.hevcPicParams.seiPayloadArrayCnt = (uint32_t)sei_payload.size();
-        encPicParams.codecPicParams.hevcPicParams.seiPayloadArray = sei_payload.data();
+    if (m_seiPayloads.size() > 0) {
+        encPicParams.codecPicParams.hevcPicParams.seiPayloadArrayCnt = (uint32_t)m_seiPayloads.size();
+        encPicParams.codecPicParams.hevcPicParams.seiPayloadArray = m_seiPayloads.data();
     }
 
     encPicParams.inputBuffer = pEncodeBuffer->stInputBfr.hInputSurface;
@@ -3264,16 +3342,19 @@ NVENCSTATUS NVEncCore::Encode() {
         }
     }
 
+    //パケットの配列は毎フレーム確保しなおさず、使いまわす
+    vector<AVPacket> packetList;
     auto extract_audio = [&](int inputFrames) {
         auto sts = RGY_ERR_NONE;
         if ((m_pFileWriterListAudio.size() + pFilterForStreams.size()) > 0) {
             RGYInputSM *pReaderSM = dynamic_cast<RGYInputSM *>(m_pFileReader.get());
             const int droppedInAviutl = (pReaderSM != nullptr) ? pReaderSM->droppedFrames() : 0;
-            vector<AVPacket> packetList = m_pFileReader->GetStreamDataPackets(inputFrames + droppedInAviutl);
+            packetList.clear();
+            m_pFileReader->GetStreamDataPackets(inputFrames + droppedInAviutl, packetList);
 
             //音声ファイルリーダーからのトラックを結合する
             for (const auto& reader : m_AudioReaders) {
-                vector_cat(packetList, reader->GetStreamDataPackets(inputFrames + droppedInAviutl));
+                reader->GetStreamDataPackets(inputFrames + droppedInAviutl, packetList);
             }
             //パケットを各Writerに分配する
             for (uint32_t i = 0; i < packetList.size(); i++) {
@@ -3970,6 +4051,17 @@ NVENCSTATUS NVEncCore::Encode() {
     if (m_ssim) {
         m_ssim->showResult();
     }
+    {
+        const auto slabStats = rgy_slab_alloc_stats();
+        PrintMes(RGY_LOG_DEBUG, _T("bitstream buffers: %llu allocs, %llu reused from cache, %llu allocated from system (%.1f MB).\n"),
+            (unsigned long long)slabStats.alloc_count, (unsigned long long)slabStats.reuse_count,
+            (unsigned long long)slabStats.sys_alloc_count, slabStats.sys_alloc_bytes / (1024.0 * 1024.0));
+        const auto hostPoolStats = RGYHostFramePool::get()->stats();
+        PrintMes(RGY_LOG_DEBUG, _T("host frame buffers: %llu allocs, %llu reused from pool, %llu allocated from system (%.1f MB, huge page %.1f MB, pinned %.1f MB).\n"),
+            (unsigned long long)hostPoolStats.alloc_count, (unsigned long long)hostPoolStats.reuse_count,
+            (unsigned long long)hostPoolStats.sys_alloc_count, hostPoolStats.sys_alloc_bytes / (1024.0 * 1024.0),
+            hostPoolStats.hugepage_bytes / (1024.0 * 1024.0), hostPoolStats.pinned_bytes / (1024.0 * 1024.0));
+    }
     queueHDR10plusMetadata.close([](RGYFrameDataHDR10plus **ptr) { if (*ptr) { delete *ptr; *ptr = nullptr; }; });
     vector<std::pair<tstring, double>> filter_result;
     for (auto& filter : m_vpFilters) {
@@ -4023,19 +4115,20 @@ NVENCSTATUS NVEncCore::Encode() {
         }
     }
 
+    vector<AVPacket> packetList;
     auto extract_audio =[&]() {
         int sts = 0;
         if (m_pFileWriterListAudio.size()) {
             auto pAVCodecReader = std::dynamic_pointer_cast<RGYInputAvcodec>(m_pFileReader);
-            vector<AVPacket> packetList;
+            packetList.clear();
             if (pAVCodecReader != nullptr) {
-                packetList = pAVCodecReader->GetStreamDataPackets();
+                pAVCodecReader->GetStreamDataPackets(0, packetList);
             }
             //音声ファイルリーダーからのトラックを結合する
             for (const auto& reader : m_AudioReaders) {
                 auto pReader = std::dynamic_pointer_cast<RGYInputAvcodec>(reader);
                 if (pReader != nullptr) {
-                    vector_cat(packetList, pReader->GetStreamDataPackets());
+                    pReader->GetStreamDataPackets(0, packetList);
                 }
             }
             //パケットを各Writerに分配する
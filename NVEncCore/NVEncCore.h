@@ -59,6 +59,7 @@ using std::vector;
 
 struct InputFrameBufInfo {
     FrameInfo frameInfo; //入力フレームへのポインタと情報
+    std::shared_ptr<uint8_t> hostBuf; //frameInfo.ptrの指すバッファ (RGYHostFramePoolから取得)
     std::unique_ptr<void, handle_deleter> heTransferFin; //入力フレームに関連付けられたイベント、このフレームが不要になったらSetする
 };
 
@@ -187,6 +188,7 @@ protected:
 
     int                          m_pipelineDepth;
     vector<InputFrameBufInfo>    m_inputHostBuffer;
+    sInputCrop                   m_inputHostPad;          //読み込み時に付加するpadding
 
     sTrimParam                    m_trimParam;
     shared_ptr<RGYInput>          m_pFileReader;           //動画読み込み
@@ -204,13 +206,15 @@ protected:
     bool                          m_hdr10plusCopy;
 #endif //#if ENABLE_AVSW_READER
     unique_ptr<RGYHDR10Plus>      m_hdr10plus;
+    RGYSEIWriter                  m_seiWriter;           //フレームごとのSEIの組み立て (使いまわす)
+    vector<NV_ENC_SEI_PAYLOAD>    m_seiPayloads;         //エンコーダに渡すSEIの一覧 (使いまわす)
     unique_ptr<HEVCHDRSei>        m_hdrsei;
 
     vector<unique_ptr<NVEncFilter>> m_vpFilters;
     shared_ptr<NVEncFilterParam>    m_pLastFilterParam;
     unique_ptr<NVEncFilterSsim>  m_ssim;
 
-    unique_ptr<RGYListRef<RGYFrameDataQP>> m_qpTable;
+    unique_ptr<RGYObjectPool<RGYFrameDataQP>> m_qpTable;
 
     GUID                         m_stCodecGUID;           //出力コーデック
     int                          m_uEncWidth;             //出力縦解像度
@@ -597,7 +597,7 @@ cudaError_t run_set_qp(
     return cudaerr;
 }
 
-NVEncFilterSmooth::NVEncFilterSmooth() : m_qp(), m_qpSrc(), m_qpSrcB(), m_qpTableRef(nullptr), m_qpTableErrCount(0) {
+NVEncFilterSmooth::NVEncFilterSmooth() : m_qp(), m_qpSrc(), m_qpSrcB(), m_qpTableErrCount(0) {
     m_sFilterName = _T("smooth");
 }
 
@@ -675,7 +675,6 @@ RGY_ERR NVEncFilterSmooth::init(shared_ptr<NVEncFilterParam> pParam, shared_ptr<
 
         setFilterInfo(pParam->print());
     }
-    m_qpTableRef = prm->qpTableRef;
     m_pParam = pParam;
     return sts;
 }
@@ -736,14 +735,10 @@ RGY_ERR NVEncFilterSmooth::run_filter(const FrameInfo *pInputFrame, FrameInfo **
     if (prm->smooth.useQPTable) {
         for (auto &data : pInputFrame->dataList) {
             if (data->dataType() == RGY_FRAME_DATA_QP) {
-                auto ptr = dynamic_cast<RGYFrameDataQP *>(data.get());
-                if (ptr == nullptr) {
-                    AddMessage(RGY_LOG_ERROR, _T("Failed to get RGYFrameDataQP.\n"));
-                    return RGY_ERR_UNSUPPORTED;
-                }
-                auto ptrRef = m_qpTableRef->get(ptr);
+                //dataListのshared_ptrから参照を取得する (参照がなくなるとプールに返却される)
+                auto ptrRef = std::dynamic_pointer_cast<RGYFrameDataQP>(data);
                 if (!ptrRef) {
-                    AddMessage(RGY_LOG_ERROR, _T("Failed to get ref to RGYFrameDataQP.\n"));
+                    AddMessage(RGY_LOG_ERROR, _T("Failed to get RGYFrameDataQP.\n"));
                     return RGY_ERR_UNSUPPORTED;
                 }
                 qpInput = std::move(ptrRef);
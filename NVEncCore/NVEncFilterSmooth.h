@@ -38,9 +38,8 @@ class NVEncFilterParamSmooth : public NVEncFilterParam {
 public:
     VppSmooth smooth;
     std::pair<int, int> compute_capability;
-    RGYListRef<RGYFrameDataQP> *qpTableRef;
 
-    NVEncFilterParamSmooth() : smooth(), compute_capability(), qpTableRef(nullptr) {
+    NVEncFilterParamSmooth() : smooth(), compute_capability() {
 
     };
     virtual ~NVEncFilterParamSmooth() {};
@@ -62,6 +61,5 @@ protected:
     CUFrameBuf m_qp;
     std::shared_ptr<RGYFrameDataQP> m_qpSrc;
     std::shared_ptr<RGYFrameDataQP> m_qpSrcB;
-    RGYListRef<RGYFrameDataQP> *m_qpTableRef;
     int m_qpTableErrCount;
 };
@@ -182,6 +182,45 @@ std::vector<RGYFrameData *> RGYBitstream::getFrameDataList() {
     return make_vector(frameDataList, frameDataNum);
 }
 
+void RGYBitstream::nalList(RGY_CODEC codec, std::vector<nal_info>& nal_list) const {
+    nal_list.clear();
+    if (codec != RGY_CODEC_UNKNOWN && nalIndexCodec == codec) {
+        nal_list.insert(nal_list.end(), nalIndex, nalIndex + nalIndexNum);
+        return;
+    }
+    invalidateNalList();
+    if (codec == RGY_CODEC_HEVC) {
+        parse_nal_unit_hevc(data(), size(), nal_list);
+    } else if (codec == RGY_CODEC_H264) {
+        parse_nal_unit_h264(data(), size(), nal_list);
+    } else {
+        return;
+    }
+    //領域はclear()まで解放せず、次のフレームでも再利用する
+    if ((int)nal_list.size() > nalIndexAlloc) {
+        const int newAlloc = std::max((int)nal_list.size(), nalIndexAlloc * 2);
+        auto newIndex = (nal_info *)realloc(nalIndex, newAlloc * sizeof(nalIndex[0]));
+        if (newIndex == nullptr) {
+            return;
+        }
+        nalIndex = newIndex;
+        nalIndexAlloc = newAlloc;
+    }
+    std::copy(nal_list.begin(), nal_list.end(), nalIndex);
+    nalIndexNum = (int)nal_list.size();
+    nalIndexCodec = codec;
+}
+
+void RGYBitstream::clearNalList() {
+    if (nalIndex) {
+        free(nalIndex);
+        nalIndex = nullptr;
+    }
+    nalIndexNum = 0;
+    nalIndexAlloc = 0;
+    nalIndexCodec = RGY_CODEC_UNKNOWN;
+}
+
 __declspec(noinline)
 VideoInfo videooutputinfo(
     const GUID& encCodecGUID,
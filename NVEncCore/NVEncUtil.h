@@ -43,6 +43,8 @@
 #include "convert_csp.h"
 #include "rgy_util.h"
 #include "rgy_err.h"
+#include "rgy_slab_alloc.h"
+#include "rgy_bitstream.h"
 
 MAP_PAIR_0_1_PROTO(codec, rgy, RGY_CODEC, enc, cudaVideoCodec);
 MAP_PAIR_0_1_PROTO(chromafmt, rgy, RGY_CHROMAFMT, enc, cudaVideoChromaFormat);
@@ -83,6 +85,11 @@ private:
     int64_t dataDuration;
     RGYFrameData **frameDataList;
     int frameDataNum;
+    //NAL unitの一覧のキャッシュ (nalList()の初回呼び出し時に確保し、clear()で解放する)
+    mutable nal_info *nalIndex;
+    mutable int nalIndexNum;
+    mutable int nalIndexAlloc;       //nalIndexに確保済みの要素数
+    mutable RGY_CODEC nalIndexCodec; //キャッシュを作成したコーデック (RGY_CODEC_UNKNOWNならキャッシュなし)
 public:
     uint8_t *bufptr() const {
         return dataptr;
@@ -138,6 +145,7 @@ public:
 
     void setSize(size_t size) {
         dataLength = size;
+        invalidateNalList();
     }
 
     size_t offset() const {
@@ -146,10 +154,12 @@ public:
 
     void addOffset(size_t add) {
         dataOffset += add;
+        invalidateNalList();
     }
 
     void setOffset(size_t offset) {
         dataOffset = offset;
+        invalidateNalList();
     }
 
     size_t bufsize() const {
@@ -182,24 +192,24 @@ public:
 
     void clear() {
         if (dataptr && maxLength) {
-            _aligned_free(dataptr);
+            rgy_slab_free(dataptr, maxLength);
         }
         dataptr = nullptr;
         clearFrameDataList();
         dataLength = 0;
         dataOffset = 0;
         maxLength = 0;
+        clearNalList();
     }
 
     RGY_ERR init(size_t nSize) {
         clear();
 
         if (nSize > 0) {
-            if (nullptr == (dataptr = (uint8_t *)_aligned_malloc(nSize, 32))) {
+            //バッファはサイズクラスに切り上げて確保されるので、maxLengthには実際に確保されたサイズが入る
+            if (nullptr == (dataptr = (uint8_t *)rgy_slab_alloc(nSize, &maxLength))) {
                 return RGY_ERR_NULL_PTR;
             }
-
-            maxLength = nSize;
         }
         return RGY_ERR_NONE;
     }
@@ -208,6 +218,7 @@ public:
         if (dataOffset > 0 && dataLength > 0) {
             memmove(dataptr, dataptr + dataOffset, dataLength);
             dataOffset = 0;
+            invalidateNalList();
         }
     }
 
@@ -225,6 +236,7 @@ public:
         dataLength = setSize;
         dataOffset = 0;
         memcpy(dataptr, setData, setSize);
+        invalidateNalList();
         return RGY_ERR_NONE;
     }
 
@@ -266,7 +278,8 @@ public:
     }
 
     RGY_ERR changeSize(size_t nNewSize) {
-        uint8_t *pData = (uint8_t *)_aligned_malloc(nNewSize, 32);
+        size_t nAllocatedSize = 0;
+        uint8_t *pData = (uint8_t *)rgy_slab_alloc(nNewSize, &nAllocatedSize);
         if (pData == nullptr) {
             return RGY_ERR_NULL_PTR;
         }
@@ -280,7 +293,7 @@ public:
         dataptr       = pData;
         dataOffset = 0;
         dataLength = nDataLen;
-        maxLength  = nNewSize;
+        maxLength  = nAllocatedSize;
 
         return RGY_ERR_NONE;
     }
@@ -301,6 +314,7 @@ public:
             }
             memcpy(dataptr + dataLength + dataOffset, appendData, appendSize);
             dataLength = new_data_length;
+            invalidateNalList();
         }
         return RGY_ERR_NONE;
     }
@@ -311,6 +325,16 @@ public:
     void addFrameData(RGYFrameData *frameData);
     void clearFrameDataList();
     std::vector<RGYFrameData *> getFrameDataList();
+
+    //NAL unitの一覧をnal_listに取得する
+    //最初の呼び出し時のみ解析を行い、以降はデータが変更されるまで結果を再利用する
+    void nalList(RGY_CODEC codec, std::vector<nal_info>& nal_list) const;
+    void clearNalList();
+
+    //data()の指す内容を直接書き換えた場合は、これを呼んでNAL unitの一覧のキャッシュを破棄する
+    void invalidateNalList() const {
+        nalIndexCodec = RGY_CODEC_UNKNOWN;
+    }
 };
 
 static inline RGYBitstream RGYBitstreamInit() {
@@ -29,11 +29,14 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <chrono>
 #include "rgy_tchar.h"
 #include "rgy_simd.h"
 #include "rgy_version.h"
 #include "convert_csp.h"
 #include "rgy_osdep.h"
+#include "rgy_util.h"
+#include "rgy_thread_pool.h"
 
 void copy_nv12_to_nv12_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
 void copy_p010_to_p010_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
@@ -98,27 +101,45 @@ void convert_yv12_to_p010_avx2(void **dst, const void **src, int width, int src_
 void convert_yv12_to_p010_avx(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
 void convert_yv12_to_p010_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
 
-void convert_yv12_16_to_nv12_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_16_to_nv12_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_14_to_nv12_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_14_to_nv12_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_12_to_nv12_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_12_to_nv12_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_10_to_nv12_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_10_to_nv12_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_09_to_nv12_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_09_to_nv12_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-
-void convert_yv12_16_to_p010_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_16_to_p010_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_14_to_p010_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_14_to_p010_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_12_to_p010_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_12_to_p010_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_10_to_p010_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_10_to_p010_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_09_to_p010_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yv12_09_to_p010_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yv12_high_to_nv12_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yv12_high_to_nv12_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+
+template<int in_bit_depth> void convert_yv12_high_to_p010_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yv12_high_to_p010_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+
+void convert_yv12_to_nv12_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+void convert_uv_yv12_to_nv12_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+void convert_yv12_to_p010_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yv12_high_to_nv12_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yv12_high_to_p010_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_nv12_p_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_nv12_i_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_p010_p_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_p010_i_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+
+void convert_yuv444_to_nv12_p_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+void convert_yuv444_to_nv12_p_sse41(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+void convert_yuv444_to_nv12_i_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+void convert_yuv444_to_nv12_i_sse41(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_nv12_p_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_nv12_p_sse41(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_nv12_i_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_nv12_i_sse41(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+void convert_yuv444_to_p010_p_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+void convert_yuv444_to_p010_p_sse41(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+void convert_yuv444_to_p010_i_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+void convert_yuv444_to_p010_i_sse41(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_p010_p_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_p010_p_sse41(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_p010_i_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_p010_i_sse41(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+
+//AVX512のintrinsicと/arch:AVX512はVS2017 (15.3)以降でないと使用できない
+#if (defined(_MSC_VER) && _MSC_VER >= 1911) || (defined(__AVX512BW__) && defined(__AVX512VL__))
+#define FUNC_AVX512(from, to, uv_only, funcp, funci, simd) { from, to, uv_only, { funcp, funci }, simd },
+#else
+#define FUNC_AVX512(from, to, uv_only, funcp, funci, simd)
+#endif
 
 #if defined(_MSC_VER) || defined(__AVX2__)
 #define FUNC_AVX2(from, to, uv_only, funcp, funci, simd) { from, to, uv_only, { funcp, funci }, simd },
@@ -128,39 +149,22 @@ void convert_yv12_09_to_p010_sse2(void **dst, const void **src, int width, int s
 
 void convert_yuv422_to_nv16_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
 void convert_yuv422_to_p210_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv422_09_to_p210_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv422_10_to_p210_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv422_12_to_p210_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv422_14_to_p210_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv422_16_to_p210_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+void convert_yuv422_to_nv16_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+void convert_yuv422_to_p210_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv422_high_to_p210_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv422_high_to_p210_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
 
 void copy_yuv444_to_yuv444_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
 void copy_yuv444_to_yuv444_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
 
-void convert_yuv444_16_to_yuv444_16_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_16_to_yuv444_16_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_14_to_yuv444_16_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_14_to_yuv444_16_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_12_to_yuv444_16_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_12_to_yuv444_16_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_10_to_yuv444_16_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_10_to_yuv444_16_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_09_to_yuv444_16_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_09_to_yuv444_16_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_yuv444_16_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_yuv444_16_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
 
 void convert_yuv444_to_yuv444_16_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
 void convert_yuv444_to_yuv444_16_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
 
-void convert_yuv444_16_to_yuv444_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_16_to_yuv444_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_14_to_yuv444_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_14_to_yuv444_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_12_to_yuv444_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_12_to_yuv444_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_10_to_yuv444_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_10_to_yuv444_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_09_to_yuv444_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
-void convert_yuv444_09_to_yuv444_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_yuv444_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+template<int in_bit_depth> void convert_yuv444_high_to_yuv444_sse2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
 
 void convert_yc48_to_yuv444_avx(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
 void convert_yc48_to_yuv444_sse41(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
@@ -956,10 +960,12 @@ static const ConvertCSP funcList[] = {
     FUNC_SSE( RGY_CSP_YUV444_16,  RGY_CSP_YC48,      false,  convert_yuv444_16bit_to_yc48_sse2,   convert_yuv444_16bit_to_yc48_sse2,   SSE2 )
 #endif
 #if ENABLE_AVSW_READER || ENABLE_AVI_READER || ENABLE_AVISYNTH_READER || ENABLE_VAPOURSYNTH_READER || ENABLE_AVI_READER || ENABLE_RAW_READER
+    FUNC_AVX512(RGY_CSP_YV12,      RGY_CSP_NV12,      false, convert_yv12_to_nv12_avx512,         convert_yv12_to_nv12_avx512,         AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
     FUNC_AVX2( RGY_CSP_YV12, RGY_CSP_NV12, false, convert_yv12_to_nv12_avx2,     convert_yv12_to_nv12_avx2,     AVX2|AVX)
     FUNC_AVX(  RGY_CSP_YV12, RGY_CSP_NV12, false, convert_yv12_to_nv12_avx,      convert_yv12_to_nv12_avx,      AVX )
     FUNC_SSE(  RGY_CSP_YV12, RGY_CSP_NV12, false, convert_yv12_to_nv12_sse2,     convert_yv12_to_nv12_sse2,     SSE2 )
     FUNC_SSE(  RGY_CSP_YV12, RGY_CSP_YUV444, false, convert_yv12_p_to_yuv444,    convert_yv12_i_to_yuv444,      NONE )
+    FUNC_AVX512(RGY_CSP_YV12,      RGY_CSP_NV12,      true,  convert_uv_yv12_to_nv12_avx512,      convert_uv_yv12_to_nv12_avx512,      AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
     FUNC_AVX2( RGY_CSP_YV12, RGY_CSP_NV12, true,  convert_uv_yv12_to_nv12_avx2,  convert_uv_yv12_to_nv12_avx2,  AVX2|AVX )
     FUNC_AVX(  RGY_CSP_YV12, RGY_CSP_NV12, true,  convert_uv_yv12_to_nv12_avx,   convert_uv_yv12_to_nv12_avx,   AVX )
     FUNC_SSE(  RGY_CSP_YV12, RGY_CSP_NV12, true,  convert_uv_yv12_to_nv12_sse2,  convert_uv_yv12_to_nv12_sse2,  SSE2 )
@@ -999,31 +1005,42 @@ static const ConvertCSP funcList[] = {
     FUNC_SSE(  RGY_CSP_RGB24,  RGY_CSP_RGB24, false, convert_rgb24_to_rgb24_sse2,      convert_rgb24_to_rgb24_sse2,      SSE2 )
     FUNC_SSE(  RGY_CSP_RGB24R, RGY_CSP_RGB24, false, convert_rgb24r_to_rgb24_sse2,     convert_rgb24r_to_rgb24_sse2,     SSE2 )
 
+    FUNC_AVX512(RGY_CSP_YV12,      RGY_CSP_P010,      false, convert_yv12_to_p010_avx512,         convert_yv12_to_p010_avx512,         AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
     FUNC_AVX2( RGY_CSP_YV12,      RGY_CSP_P010,      false, convert_yv12_to_p010_avx2,           convert_yv12_to_p010_avx2,    AVX2|AVX )
     FUNC_AVX(  RGY_CSP_YV12,      RGY_CSP_P010,      false, convert_yv12_to_p010_avx,            convert_yv12_to_p010_avx,     AVX )
     FUNC_SSE(  RGY_CSP_YV12,      RGY_CSP_P010,      false, convert_yv12_to_p010_sse2,           convert_yv12_to_p010_sse2,    SSE2 )
     FUNC_SSE(  RGY_CSP_YV12,      RGY_CSP_P010,      false, convert_yv12_to_p010,                convert_yv12_to_p010,         NONE )
     FUNC_SSE(  RGY_CSP_YV12,      RGY_CSP_YUV444_16, false, convert_yv12_p_to_yuv444_16bit,      convert_yv12_i_to_yuv444_16bit, NONE )
-    FUNC_AVX2( RGY_CSP_YV12_16,   RGY_CSP_NV12,      false, convert_yv12_16_to_nv12_avx2,        convert_yv12_16_to_nv12_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YV12_16,   RGY_CSP_NV12,      false, convert_yv12_16_to_nv12_sse2,        convert_yv12_16_to_nv12_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YV12_14,   RGY_CSP_NV12,      false, convert_yv12_14_to_nv12_avx2,        convert_yv12_14_to_nv12_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YV12_14,   RGY_CSP_NV12,      false, convert_yv12_14_to_nv12_sse2,        convert_yv12_14_to_nv12_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YV12_12,   RGY_CSP_NV12,      false, convert_yv12_12_to_nv12_avx2,        convert_yv12_12_to_nv12_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YV12_12,   RGY_CSP_NV12,      false, convert_yv12_12_to_nv12_sse2,        convert_yv12_12_to_nv12_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YV12_10,   RGY_CSP_NV12,      false, convert_yv12_10_to_nv12_avx2,        convert_yv12_10_to_nv12_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YV12_10,   RGY_CSP_NV12,      false, convert_yv12_10_to_nv12_sse2,        convert_yv12_10_to_nv12_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YV12_09,   RGY_CSP_NV12,      false, convert_yv12_09_to_nv12_avx2,        convert_yv12_09_to_nv12_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YV12_09,   RGY_CSP_NV12,      false, convert_yv12_09_to_nv12_sse2,        convert_yv12_09_to_nv12_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YV12_16,   RGY_CSP_P010,      false, convert_yv12_16_to_p010_avx2,        convert_yv12_16_to_p010_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YV12_16,   RGY_CSP_P010,      false, convert_yv12_16_to_p010_sse2,        convert_yv12_16_to_p010_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YV12_14,   RGY_CSP_P010,      false, convert_yv12_14_to_p010_avx2,        convert_yv12_14_to_p010_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YV12_14,   RGY_CSP_P010,      false, convert_yv12_14_to_p010_sse2,        convert_yv12_14_to_p010_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YV12_12,   RGY_CSP_P010,      false, convert_yv12_12_to_p010_avx2,        convert_yv12_12_to_p010_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YV12_12,   RGY_CSP_P010,      false, convert_yv12_12_to_p010_sse2,        convert_yv12_12_to_p010_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YV12_10,   RGY_CSP_P010,      false, convert_yv12_10_to_p010_avx2,        convert_yv12_10_to_p010_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YV12_10,   RGY_CSP_P010,      false, convert_yv12_10_to_p010_sse2,        convert_yv12_10_to_p010_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YV12_09,   RGY_CSP_P010,      false, convert_yv12_09_to_p010_avx2,        convert_yv12_09_to_p010_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YV12_09,   RGY_CSP_P010,      false, convert_yv12_09_to_p010_sse2,        convert_yv12_09_to_p010_sse2, SSE2 )
+    FUNC_AVX512(RGY_CSP_YV12_16,   RGY_CSP_NV12,      false, convert_yv12_high_to_nv12_avx512<16>, convert_yv12_high_to_nv12_avx512<16>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YV12_16,   RGY_CSP_NV12,      false, convert_yv12_high_to_nv12_avx2<16>,  convert_yv12_high_to_nv12_avx2<16>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YV12_16,   RGY_CSP_NV12,      false, convert_yv12_high_to_nv12_sse2<16>,  convert_yv12_high_to_nv12_sse2<16>, SSE2 )
+    FUNC_AVX512(RGY_CSP_YV12_14,   RGY_CSP_NV12,      false, convert_yv12_high_to_nv12_avx512<14>, convert_yv12_high_to_nv12_avx512<14>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YV12_14,   RGY_CSP_NV12,      false, convert_yv12_high_to_nv12_avx2<14>,  convert_yv12_high_to_nv12_avx2<14>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YV12_14,   RGY_CSP_NV12,      false, convert_yv12_high_to_nv12_sse2<14>,  convert_yv12_high_to_nv12_sse2<14>, SSE2 )
+    FUNC_AVX512(RGY_CSP_YV12_12,   RGY_CSP_NV12,      false, convert_yv12_high_to_nv12_avx512<12>, convert_yv12_high_to_nv12_avx512<12>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YV12_12,   RGY_CSP_NV12,      false, convert_yv12_high_to_nv12_avx2<12>,  convert_yv12_high_to_nv12_avx2<12>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YV12_12,   RGY_CSP_NV12,      false, convert_yv12_high_to_nv12_sse2<12>,  convert_yv12_high_to_nv12_sse2<12>, SSE2 )
+    FUNC_AVX512(RGY_CSP_YV12_10,   RGY_CSP_NV12,      false, convert_yv12_high_to_nv12_avx512<10>, convert_yv12_high_to_nv12_avx512<10>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YV12_10,   RGY_CSP_NV12,      false, convert_yv12_high_to_nv12_avx2<10>,  convert_yv12_high_to_nv12_avx2<10>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YV12_10,   RGY_CSP_NV12,      false, convert_yv12_high_to_nv12_sse2<10>,  convert_yv12_high_to_nv12_sse2<10>, SSE2 )
+    FUNC_AVX512(RGY_CSP_YV12_09,   RGY_CSP_NV12,      false, convert_yv12_high_to_nv12_avx512<9>, convert_yv12_high_to_nv12_avx512<9>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YV12_09,   RGY_CSP_NV12,      false, convert_yv12_high_to_nv12_avx2<9>,   convert_yv12_high_to_nv12_avx2<9>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YV12_09,   RGY_CSP_NV12,      false, convert_yv12_high_to_nv12_sse2<9>,   convert_yv12_high_to_nv12_sse2<9>, SSE2 )
+    FUNC_AVX512(RGY_CSP_YV12_16,   RGY_CSP_P010,      false, convert_yv12_high_to_p010_avx512<16>, convert_yv12_high_to_p010_avx512<16>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YV12_16,   RGY_CSP_P010,      false, convert_yv12_high_to_p010_avx2<16>,  convert_yv12_high_to_p010_avx2<16>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YV12_16,   RGY_CSP_P010,      false, convert_yv12_high_to_p010_sse2<16>,  convert_yv12_high_to_p010_sse2<16>, SSE2 )
+    FUNC_AVX512(RGY_CSP_YV12_14,   RGY_CSP_P010,      false, convert_yv12_high_to_p010_avx512<14>, convert_yv12_high_to_p010_avx512<14>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YV12_14,   RGY_CSP_P010,      false, convert_yv12_high_to_p010_avx2<14>,  convert_yv12_high_to_p010_avx2<14>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YV12_14,   RGY_CSP_P010,      false, convert_yv12_high_to_p010_sse2<14>,  convert_yv12_high_to_p010_sse2<14>, SSE2 )
+    FUNC_AVX512(RGY_CSP_YV12_12,   RGY_CSP_P010,      false, convert_yv12_high_to_p010_avx512<12>, convert_yv12_high_to_p010_avx512<12>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YV12_12,   RGY_CSP_P010,      false, convert_yv12_high_to_p010_avx2<12>,  convert_yv12_high_to_p010_avx2<12>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YV12_12,   RGY_CSP_P010,      false, convert_yv12_high_to_p010_sse2<12>,  convert_yv12_high_to_p010_sse2<12>, SSE2 )
+    FUNC_AVX512(RGY_CSP_YV12_10,   RGY_CSP_P010,      false, convert_yv12_high_to_p010_avx512<10>, convert_yv12_high_to_p010_avx512<10>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YV12_10,   RGY_CSP_P010,      false, convert_yv12_high_to_p010_avx2<10>,  convert_yv12_high_to_p010_avx2<10>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YV12_10,   RGY_CSP_P010,      false, convert_yv12_high_to_p010_sse2<10>,  convert_yv12_high_to_p010_sse2<10>, SSE2 )
+    FUNC_AVX512(RGY_CSP_YV12_09,   RGY_CSP_P010,      false, convert_yv12_high_to_p010_avx512<9>, convert_yv12_high_to_p010_avx512<9>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YV12_09,   RGY_CSP_P010,      false, convert_yv12_high_to_p010_avx2<9>,   convert_yv12_high_to_p010_avx2<9>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YV12_09,   RGY_CSP_P010,      false, convert_yv12_high_to_p010_sse2<9>,   convert_yv12_high_to_p010_sse2<9>, SSE2 )
     FUNC_AVX2( RGY_CSP_YV12_16,   RGY_CSP_YUV444,    false, convert_yv12_16_p_to_yuv444,         convert_yv12_16_i_to_yuv444,  NONE )
     FUNC_SSE(  RGY_CSP_YV12_14,   RGY_CSP_YUV444,    false, convert_yv12_14_p_to_yuv444,         convert_yv12_14_i_to_yuv444,  NONE )
     FUNC_SSE(  RGY_CSP_YV12_12,   RGY_CSP_YUV444,    false, convert_yv12_12_p_to_yuv444,         convert_yv12_12_i_to_yuv444,  NONE )
@@ -1035,49 +1052,90 @@ static const ConvertCSP funcList[] = {
     FUNC_SSE(  RGY_CSP_YV12_10,   RGY_CSP_YUV444_16, false, convert_yv12_10_p_to_yuv444_16bit,   convert_yv12_10_i_to_yuv444_16bit, NONE )
     FUNC_SSE(  RGY_CSP_YV12_09,   RGY_CSP_YUV444_16, false, convert_yv12_09_p_to_yuv444_16bit,   convert_yv12_09_i_to_yuv444_16bit, NONE )
     FUNC_SSE(  RGY_CSP_YUV422,    RGY_CSP_YUV444,    false, convert_yuv422_to_yuv444,            convert_yuv422_to_yuv444,  NONE )
+    FUNC_AVX2( RGY_CSP_YUV422,    RGY_CSP_NV16,      false, convert_yuv422_to_nv16_avx2,         convert_yuv422_to_nv16_avx2,    AVX2|AVX)
     FUNC_SSE(  RGY_CSP_YUV422,    RGY_CSP_NV16,      false, convert_yuv422_to_nv16_sse2,         convert_yuv422_to_nv16_sse2,    SSE2)
+    FUNC_AVX2( RGY_CSP_YUV422,    RGY_CSP_P210,      false, convert_yuv422_to_p210_avx2,         convert_yuv422_to_p210_avx2,    AVX2|AVX)
     FUNC_SSE(  RGY_CSP_YUV422,    RGY_CSP_P210,      false, convert_yuv422_to_p210_sse2,         convert_yuv422_to_p210_sse2,    SSE2)
-    FUNC_SSE(  RGY_CSP_YUV422_16, RGY_CSP_P210,      false, convert_yuv422_16_to_p210_sse2,      convert_yuv422_16_to_p210_sse2, SSE2)
-    FUNC_SSE(  RGY_CSP_YUV422_14, RGY_CSP_P210,      false, convert_yuv422_14_to_p210_sse2,      convert_yuv422_14_to_p210_sse2, SSE2)
-    FUNC_SSE(  RGY_CSP_YUV422_12, RGY_CSP_P210,      false, convert_yuv422_12_to_p210_sse2,      convert_yuv422_12_to_p210_sse2, SSE2)
-    FUNC_SSE(  RGY_CSP_YUV422_10, RGY_CSP_P210,      false, convert_yuv422_10_to_p210_sse2,      convert_yuv422_10_to_p210_sse2, SSE2)
-    FUNC_SSE(  RGY_CSP_YUV422_09, RGY_CSP_P210,      false, convert_yuv422_09_to_p210_sse2,      convert_yuv422_09_to_p210_sse2, SSE2)
+    FUNC_AVX2( RGY_CSP_YUV422_16, RGY_CSP_P210,      false, convert_yuv422_high_to_p210_avx2<16>, convert_yuv422_high_to_p210_avx2<16>, AVX2|AVX)
+    FUNC_SSE(  RGY_CSP_YUV422_16, RGY_CSP_P210,      false, convert_yuv422_high_to_p210_sse2<16>, convert_yuv422_high_to_p210_sse2<16>, SSE2)
+    FUNC_AVX2( RGY_CSP_YUV422_14, RGY_CSP_P210,      false, convert_yuv422_high_to_p210_avx2<14>, convert_yuv422_high_to_p210_avx2<14>, AVX2|AVX)
+    FUNC_SSE(  RGY_CSP_YUV422_14, RGY_CSP_P210,      false, convert_yuv422_high_to_p210_sse2<14>, convert_yuv422_high_to_p210_sse2<14>, SSE2)
+    FUNC_AVX2( RGY_CSP_YUV422_12, RGY_CSP_P210,      false, convert_yuv422_high_to_p210_avx2<12>, convert_yuv422_high_to_p210_avx2<12>, AVX2|AVX)
+    FUNC_SSE(  RGY_CSP_YUV422_12, RGY_CSP_P210,      false, convert_yuv422_high_to_p210_sse2<12>, convert_yuv422_high_to_p210_sse2<12>, SSE2)
+    FUNC_AVX2( RGY_CSP_YUV422_10, RGY_CSP_P210,      false, convert_yuv422_high_to_p210_avx2<10>, convert_yuv422_high_to_p210_avx2<10>, AVX2|AVX)
+    FUNC_SSE(  RGY_CSP_YUV422_10, RGY_CSP_P210,      false, convert_yuv422_high_to_p210_sse2<10>, convert_yuv422_high_to_p210_sse2<10>, SSE2)
+    FUNC_AVX2( RGY_CSP_YUV422_09, RGY_CSP_P210,      false, convert_yuv422_high_to_p210_avx2<9>, convert_yuv422_high_to_p210_avx2<9>, AVX2|AVX)
+    FUNC_SSE(  RGY_CSP_YUV422_09, RGY_CSP_P210,      false, convert_yuv422_high_to_p210_sse2<9>, convert_yuv422_high_to_p210_sse2<9>, SSE2)
+    FUNC_AVX2( RGY_CSP_YUV444,    RGY_CSP_NV12,      false, convert_yuv444_to_nv12_p_avx2,       convert_yuv444_to_nv12_i_avx2,       AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444,    RGY_CSP_NV12,      false, convert_yuv444_to_nv12_p_sse41,      convert_yuv444_to_nv12_i_sse41,      SSE41|SSSE3|SSE2 )
     FUNC_SSE(  RGY_CSP_YUV444,    RGY_CSP_NV12,      false, convert_yuv444_to_nv12_p,            convert_yuv444_to_nv12_i, NONE )
+    FUNC_AVX2( RGY_CSP_YUV444,    RGY_CSP_P010,      false, convert_yuv444_to_p010_p_avx2,       convert_yuv444_to_p010_i_avx2,       AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444,    RGY_CSP_P010,      false, convert_yuv444_to_p010_p_sse41,      convert_yuv444_to_p010_i_sse41,      SSE41|SSSE3|SSE2 )
     FUNC_SSE(  RGY_CSP_YUV444,    RGY_CSP_P010,      false, convert_yuv444_to_p010_p,            convert_yuv444_to_p010_i, NONE )
     FUNC_AVX2( RGY_CSP_YUV444,    RGY_CSP_YUV444,    false, copy_yuv444_to_yuv444_avx2,          copy_yuv444_to_yuv444_avx2, AVX2|AVX )
     FUNC_SSE(  RGY_CSP_YUV444,    RGY_CSP_YUV444,    false, copy_yuv444_to_yuv444_sse2,          copy_yuv444_to_yuv444_sse2, SSE2 )
+    FUNC_AVX512(RGY_CSP_YUV444_16, RGY_CSP_NV12,      false, convert_yuv444_high_to_nv12_p_avx512<16>, convert_yuv444_high_to_nv12_i_avx512<16>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YUV444_16, RGY_CSP_NV12,      false, convert_yuv444_high_to_nv12_p_avx2<16>, convert_yuv444_high_to_nv12_i_avx2<16>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_16, RGY_CSP_NV12,      false, convert_yuv444_high_to_nv12_p_sse41<16>, convert_yuv444_high_to_nv12_i_sse41<16>, SSE41|SSSE3|SSE2 )
     FUNC_SSE(  RGY_CSP_YUV444_16, RGY_CSP_NV12,      false, convert_yuv444_16_to_nv12_p,         convert_yuv444_16_to_nv12_i, NONE )
+    FUNC_AVX512(RGY_CSP_YUV444_14, RGY_CSP_NV12,      false, convert_yuv444_high_to_nv12_p_avx512<14>, convert_yuv444_high_to_nv12_i_avx512<14>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YUV444_14, RGY_CSP_NV12,      false, convert_yuv444_high_to_nv12_p_avx2<14>, convert_yuv444_high_to_nv12_i_avx2<14>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_14, RGY_CSP_NV12,      false, convert_yuv444_high_to_nv12_p_sse41<14>, convert_yuv444_high_to_nv12_i_sse41<14>, SSE41|SSSE3|SSE2 )
     FUNC_SSE(  RGY_CSP_YUV444_14, RGY_CSP_NV12,      false, convert_yuv444_14_to_nv12_p,         convert_yuv444_14_to_nv12_i, NONE )
+    FUNC_AVX512(RGY_CSP_YUV444_12, RGY_CSP_NV12,      false, convert_yuv444_high_to_nv12_p_avx512<12>, convert_yuv444_high_to_nv12_i_avx512<12>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YUV444_12, RGY_CSP_NV12,      false, convert_yuv444_high_to_nv12_p_avx2<12>, convert_yuv444_high_to_nv12_i_avx2<12>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_12, RGY_CSP_NV12,      false, convert_yuv444_high_to_nv12_p_sse41<12>, convert_yuv444_high_to_nv12_i_sse41<12>, SSE41|SSSE3|SSE2 )
     FUNC_SSE(  RGY_CSP_YUV444_12, RGY_CSP_NV12,      false, convert_yuv444_12_to_nv12_p,         convert_yuv444_12_to_nv12_i, NONE )
+    FUNC_AVX512(RGY_CSP_YUV444_10, RGY_CSP_NV12,      false, convert_yuv444_high_to_nv12_p_avx512<10>, convert_yuv444_high_to_nv12_i_avx512<10>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YUV444_10, RGY_CSP_NV12,      false, convert_yuv444_high_to_nv12_p_avx2<10>, convert_yuv444_high_to_nv12_i_avx2<10>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_10, RGY_CSP_NV12,      false, convert_yuv444_high_to_nv12_p_sse41<10>, convert_yuv444_high_to_nv12_i_sse41<10>, SSE41|SSSE3|SSE2 )
     FUNC_SSE(  RGY_CSP_YUV444_10, RGY_CSP_NV12,      false, convert_yuv444_10_to_nv12_p,         convert_yuv444_10_to_nv12_i, NONE )
+    FUNC_AVX512(RGY_CSP_YUV444_09, RGY_CSP_NV12,      false, convert_yuv444_high_to_nv12_p_avx512<9>, convert_yuv444_high_to_nv12_i_avx512<9>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YUV444_09, RGY_CSP_NV12,      false, convert_yuv444_high_to_nv12_p_avx2<9>, convert_yuv444_high_to_nv12_i_avx2<9>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_09, RGY_CSP_NV12,      false, convert_yuv444_high_to_nv12_p_sse41<9>, convert_yuv444_high_to_nv12_i_sse41<9>, SSE41|SSSE3|SSE2 )
     FUNC_SSE(  RGY_CSP_YUV444_09, RGY_CSP_NV12,      false, convert_yuv444_09_to_nv12_p,         convert_yuv444_09_to_nv12_i, NONE )
+    FUNC_AVX512(RGY_CSP_YUV444_16, RGY_CSP_P010,      false, convert_yuv444_high_to_p010_p_avx512<16>, convert_yuv444_high_to_p010_i_avx512<16>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YUV444_16, RGY_CSP_P010,      false, convert_yuv444_high_to_p010_p_avx2<16>, convert_yuv444_high_to_p010_i_avx2<16>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_16, RGY_CSP_P010,      false, convert_yuv444_high_to_p010_p_sse41<16>, convert_yuv444_high_to_p010_i_sse41<16>, SSE41|SSSE3|SSE2 )
     FUNC_SSE(  RGY_CSP_YUV444_16, RGY_CSP_P010,      false, convert_yuv444_16_to_p010_p,         convert_yuv444_16_to_p010_i, NONE )
+    FUNC_AVX512(RGY_CSP_YUV444_14, RGY_CSP_P010,      false, convert_yuv444_high_to_p010_p_avx512<14>, convert_yuv444_high_to_p010_i_avx512<14>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YUV444_14, RGY_CSP_P010,      false, convert_yuv444_high_to_p010_p_avx2<14>, convert_yuv444_high_to_p010_i_avx2<14>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_14, RGY_CSP_P010,      false, convert_yuv444_high_to_p010_p_sse41<14>, convert_yuv444_high_to_p010_i_sse41<14>, SSE41|SSSE3|SSE2 )
     FUNC_SSE(  RGY_CSP_YUV444_14, RGY_CSP_P010,      false, convert_yuv444_14_to_p010_p,         convert_yuv444_14_to_p010_i, NONE )
+    FUNC_AVX512(RGY_CSP_YUV444_12, RGY_CSP_P010,      false, convert_yuv444_high_to_p010_p_avx512<12>, convert_yuv444_high_to_p010_i_avx512<12>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YUV444_12, RGY_CSP_P010,      false, convert_yuv444_high_to_p010_p_avx2<12>, convert_yuv444_high_to_p010_i_avx2<12>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_12, RGY_CSP_P010,      false, convert_yuv444_high_to_p010_p_sse41<12>, convert_yuv444_high_to_p010_i_sse41<12>, SSE41|SSSE3|SSE2 )
     FUNC_SSE(  RGY_CSP_YUV444_12, RGY_CSP_P010,      false, convert_yuv444_12_to_p010_p,         convert_yuv444_12_to_p010_i, NONE )
+    FUNC_AVX512(RGY_CSP_YUV444_10, RGY_CSP_P010,      false, convert_yuv444_high_to_p010_p_avx512<10>, convert_yuv444_high_to_p010_i_avx512<10>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YUV444_10, RGY_CSP_P010,      false, convert_yuv444_high_to_p010_p_avx2<10>, convert_yuv444_high_to_p010_i_avx2<10>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_10, RGY_CSP_P010,      false, convert_yuv444_high_to_p010_p_sse41<10>, convert_yuv444_high_to_p010_i_sse41<10>, SSE41|SSSE3|SSE2 )
     FUNC_SSE(  RGY_CSP_YUV444_10, RGY_CSP_P010,      false, convert_yuv444_10_to_p010_p,         convert_yuv444_10_to_p010_i, NONE )
+    FUNC_AVX512(RGY_CSP_YUV444_09, RGY_CSP_P010,      false, convert_yuv444_high_to_p010_p_avx512<9>, convert_yuv444_high_to_p010_i_avx512<9>, AVX512BW|AVX512VL|AVX512F|AVX2|AVX )
+    FUNC_AVX2( RGY_CSP_YUV444_09, RGY_CSP_P010,      false, convert_yuv444_high_to_p010_p_avx2<9>, convert_yuv444_high_to_p010_i_avx2<9>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_09, RGY_CSP_P010,      false, convert_yuv444_high_to_p010_p_sse41<9>, convert_yuv444_high_to_p010_i_sse41<9>, SSE41|SSSE3|SSE2 )
     FUNC_SSE(  RGY_CSP_YUV444_09, RGY_CSP_P010,      false, convert_yuv444_09_to_p010_p,         convert_yuv444_09_to_p010_i, NONE )
-    FUNC_AVX2( RGY_CSP_YUV444_16, RGY_CSP_YUV444_16, false, convert_yuv444_16_to_yuv444_16_avx2, convert_yuv444_16_to_yuv444_16_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YUV444_16, RGY_CSP_YUV444_16, false, convert_yuv444_16_to_yuv444_16_sse2, convert_yuv444_16_to_yuv444_16_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YUV444_14, RGY_CSP_YUV444_16, false, convert_yuv444_14_to_yuv444_16_avx2, convert_yuv444_14_to_yuv444_16_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YUV444_14, RGY_CSP_YUV444_16, false, convert_yuv444_14_to_yuv444_16_sse2, convert_yuv444_14_to_yuv444_16_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YUV444_12, RGY_CSP_YUV444_16, false, convert_yuv444_12_to_yuv444_16_avx2, convert_yuv444_12_to_yuv444_16_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YUV444_12, RGY_CSP_YUV444_16, false, convert_yuv444_12_to_yuv444_16_sse2, convert_yuv444_12_to_yuv444_16_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YUV444_10, RGY_CSP_YUV444_16, false, convert_yuv444_10_to_yuv444_16_avx2, convert_yuv444_10_to_yuv444_16_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YUV444_10, RGY_CSP_YUV444_16, false, convert_yuv444_10_to_yuv444_16_sse2, convert_yuv444_10_to_yuv444_16_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YUV444_09, RGY_CSP_YUV444_16, false, convert_yuv444_09_to_yuv444_16_avx2, convert_yuv444_09_to_yuv444_16_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YUV444_09, RGY_CSP_YUV444_16, false, convert_yuv444_09_to_yuv444_16_sse2, convert_yuv444_09_to_yuv444_16_sse2, SSE2 )
+    FUNC_AVX2( RGY_CSP_YUV444_16, RGY_CSP_YUV444_16, false, convert_yuv444_high_to_yuv444_16_avx2<16>, convert_yuv444_high_to_yuv444_16_avx2<16>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_16, RGY_CSP_YUV444_16, false, convert_yuv444_high_to_yuv444_16_sse2<16>, convert_yuv444_high_to_yuv444_16_sse2<16>, SSE2 )
+    FUNC_AVX2( RGY_CSP_YUV444_14, RGY_CSP_YUV444_16, false, convert_yuv444_high_to_yuv444_16_avx2<14>, convert_yuv444_high_to_yuv444_16_avx2<14>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_14, RGY_CSP_YUV444_16, false, convert_yuv444_high_to_yuv444_16_sse2<14>, convert_yuv444_high_to_yuv444_16_sse2<14>, SSE2 )
+    FUNC_AVX2( RGY_CSP_YUV444_12, RGY_CSP_YUV444_16, false, convert_yuv444_high_to_yuv444_16_avx2<12>, convert_yuv444_high_to_yuv444_16_avx2<12>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_12, RGY_CSP_YUV444_16, false, convert_yuv444_high_to_yuv444_16_sse2<12>, convert_yuv444_high_to_yuv444_16_sse2<12>, SSE2 )
+    FUNC_AVX2( RGY_CSP_YUV444_10, RGY_CSP_YUV444_16, false, convert_yuv444_high_to_yuv444_16_avx2<10>, convert_yuv444_high_to_yuv444_16_avx2<10>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_10, RGY_CSP_YUV444_16, false, convert_yuv444_high_to_yuv444_16_sse2<10>, convert_yuv444_high_to_yuv444_16_sse2<10>, SSE2 )
+    FUNC_AVX2( RGY_CSP_YUV444_09, RGY_CSP_YUV444_16, false, convert_yuv444_high_to_yuv444_16_avx2<9>, convert_yuv444_high_to_yuv444_16_avx2<9>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_09, RGY_CSP_YUV444_16, false, convert_yuv444_high_to_yuv444_16_sse2<9>, convert_yuv444_high_to_yuv444_16_sse2<9>, SSE2 )
     FUNC_AVX2( RGY_CSP_YUV444,    RGY_CSP_YUV444_16, false, convert_yuv444_to_yuv444_16_avx2,    convert_yuv444_to_yuv444_16_avx2, AVX2|AVX )
     FUNC_SSE(  RGY_CSP_YUV444,    RGY_CSP_YUV444_16, false, convert_yuv444_to_yuv444_16_sse2,    convert_yuv444_to_yuv444_16_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YUV444_16, RGY_CSP_YUV444,    false, convert_yuv444_16_to_yuv444_avx2,    convert_yuv444_16_to_yuv444_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YUV444_16, RGY_CSP_YUV444,    false, convert_yuv444_16_to_yuv444_sse2,    convert_yuv444_16_to_yuv444_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YUV444_14, RGY_CSP_YUV444,    false, convert_yuv444_14_to_yuv444_avx2,    convert_yuv444_14_to_yuv444_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YUV444_14, RGY_CSP_YUV444,    false, convert_yuv444_14_to_yuv444_sse2,    convert_yuv444_14_to_yuv444_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YUV444_12, RGY_CSP_YUV444,    false, convert_yuv444_12_to_yuv444_avx2,    convert_yuv444_12_to_yuv444_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YUV444_12, RGY_CSP_YUV444,    false, convert_yuv444_12_to_yuv444_sse2,    convert_yuv444_12_to_yuv444_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YUV444_10, RGY_CSP_YUV444,    false, convert_yuv444_10_to_yuv444_avx2,    convert_yuv444_10_to_yuv444_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YUV444_10, RGY_CSP_YUV444,    false, convert_yuv444_10_to_yuv444_sse2,    convert_yuv444_10_to_yuv444_sse2, SSE2 )
-    FUNC_AVX2( RGY_CSP_YUV444_09, RGY_CSP_YUV444,    false, convert_yuv444_09_to_yuv444_avx2,    convert_yuv444_09_to_yuv444_avx2, AVX2|AVX )
-    FUNC_SSE(  RGY_CSP_YUV444_09, RGY_CSP_YUV444,    false, convert_yuv444_09_to_yuv444_sse2,    convert_yuv444_09_to_yuv444_sse2, SSE2 )
+    FUNC_AVX2( RGY_CSP_YUV444_16, RGY_CSP_YUV444,    false, convert_yuv444_high_to_yuv444_avx2<16>, convert_yuv444_high_to_yuv444_avx2<16>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_16, RGY_CSP_YUV444,    false, convert_yuv444_high_to_yuv444_sse2<16>, convert_yuv444_high_to_yuv444_sse2<16>, SSE2 )
+    FUNC_AVX2( RGY_CSP_YUV444_14, RGY_CSP_YUV444,    false, convert_yuv444_high_to_yuv444_avx2<14>, convert_yuv444_high_to_yuv444_avx2<14>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_14, RGY_CSP_YUV444,    false, convert_yuv444_high_to_yuv444_sse2<14>, convert_yuv444_high_to_yuv444_sse2<14>, SSE2 )
+    FUNC_AVX2( RGY_CSP_YUV444_12, RGY_CSP_YUV444,    false, convert_yuv444_high_to_yuv444_avx2<12>, convert_yuv444_high_to_yuv444_avx2<12>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_12, RGY_CSP_YUV444,    false, convert_yuv444_high_to_yuv444_sse2<12>, convert_yuv444_high_to_yuv444_sse2<12>, SSE2 )
+    FUNC_AVX2( RGY_CSP_YUV444_10, RGY_CSP_YUV444,    false, convert_yuv444_high_to_yuv444_avx2<10>, convert_yuv444_high_to_yuv444_avx2<10>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_10, RGY_CSP_YUV444,    false, convert_yuv444_high_to_yuv444_sse2<10>, convert_yuv444_high_to_yuv444_sse2<10>, SSE2 )
+    FUNC_AVX2( RGY_CSP_YUV444_09, RGY_CSP_YUV444,    false, convert_yuv444_high_to_yuv444_avx2<9>, convert_yuv444_high_to_yuv444_avx2<9>, AVX2|AVX )
+    FUNC_SSE(  RGY_CSP_YUV444_09, RGY_CSP_YUV444,    false, convert_yuv444_high_to_yuv444_sse2<9>, convert_yuv444_high_to_yuv444_sse2<9>, SSE2 )
 #endif
 };
 
@@ -1117,8 +1175,106 @@ const ConvertCSP *get_convert_csp_func(RGY_CSP csp_from, RGY_CSP csp_to, bool uv
     return convert;
 }
 
+std::vector<const ConvertCSP *> get_convert_csp_func_list(RGY_CSP csp_from, RGY_CSP csp_to, bool uv_only, uint32_t simd) {
+    uint32_t availableSIMD = get_availableSIMD() & simd;
+    std::vector<const ConvertCSP *> list;
+    for (int i = 0; i < _countof(funcList); i++) {
+        if (csp_from != RGY_CSP_NA && csp_from != funcList[i].csp_from)
+            continue;
+
+        if (csp_to != RGY_CSP_NA && csp_to != funcList[i].csp_to)
+            continue;
+
+        if (uv_only != funcList[i].uv_only)
+            continue;
+
+        if (funcList[i].simd != (availableSIMD & funcList[i].simd))
+            continue;
+
+        list.push_back(&funcList[i]);
+    }
+    return list;
+}
+
+//計測用のフレームバッファの1ラインあたりのバイト数
+static int convert_csp_speed_line_bytes(RGY_CSP csp, int width) {
+    if (RGY_CSP_CHROMA_FORMAT[csp] == RGY_CHROMAFMT_RGB_PACKED) {
+        //RGB24/RGB32は最大で4byte/pixel
+        return width * 4;
+    }
+    if (RGY_CSP_PLANES[csp] == 1) {
+        //YUY2, YC48, Y8, Y16
+        return width * ((RGY_CSP_BIT_PER_PIXEL[csp] + 7) / 8);
+    }
+    return width * ((RGY_CSP_BIT_DEPTH[csp] > 8) ? 2 : 1);
+}
+
+void convert_csp_frame_bytes(const ConvertCSP *convert, int width, int height, double *read_bytes, double *write_bytes) {
+    //uv_onlyの場合は色差のみを読み書きする
+    const double read_bpp  = (convert->uv_only) ? RGY_CSP_BIT_PER_PIXEL[convert->csp_from] - ((RGY_CSP_BIT_DEPTH[convert->csp_from] > 8) ? 16 : 8) : RGY_CSP_BIT_PER_PIXEL[convert->csp_from];
+    const double write_bpp = (convert->uv_only) ? RGY_CSP_BIT_PER_PIXEL[convert->csp_to]   - ((RGY_CSP_BIT_DEPTH[convert->csp_to]   > 8) ? 16 : 8) : RGY_CSP_BIT_PER_PIXEL[convert->csp_to];
+    if (read_bytes)  *read_bytes  = (double)width * height * read_bpp  / 8.0;
+    if (write_bytes) *write_bytes = (double)width * height * write_bpp / 8.0;
+}
+
+double convert_csp_speed(const ConvertCSP *convert, int width, int height, bool interlaced, int thread_n) {
+    if (convert == nullptr || width <= 0 || height <= 0 || thread_n <= 0) {
+        return -1.0;
+    }
+    //SIMD版は行末を越えて読み書きすることがあるので、幅と高さに余裕を持たせる
+    const int src_pitch = ALIGN(convert_csp_speed_line_bytes(convert->csp_from, width) + 256, 64);
+    const int dst_pitch = ALIGN(convert_csp_speed_line_bytes(convert->csp_to,   width) + 256, 64);
+    //変換関数によっては色差の位置を輝度の先頭から計算するので、各planeを高さ分ずつ連続して配置する
+    const int src_planes = std::max<int>(1, RGY_CSP_PLANES[convert->csp_from]);
+    const int dst_planes = std::max<int>(1, RGY_CSP_PLANES[convert->csp_to]);
+    const size_t src_size = (size_t)src_pitch * (height * src_planes + 4);
+    const size_t dst_size = (size_t)dst_pitch * (height * dst_planes + 4);
+    std::unique_ptr<uint8_t, aligned_malloc_deleter> src_buf((uint8_t *)_aligned_malloc(src_size, 64));
+    std::unique_ptr<uint8_t, aligned_malloc_deleter> dst_buf((uint8_t *)_aligned_malloc(dst_size, 64));
+    if (!src_buf || !dst_buf) {
+        return -1.0;
+    }
+    memset(src_buf.get(), 0x40, src_size);
+    void *dst[4] = { 0 };
+    const void *src[4] = { 0 };
+    for (int i = 0; i < 4; i++) {
+        src[i] = src_buf.get() + (size_t)src_pitch * height * std::min(i, src_planes - 1);
+        dst[i] = dst_buf.get() + (size_t)dst_pitch * height * std::min(i, dst_planes - 1);
+    }
+
+    const auto func = convert->func[interlaced ? 1 : 0];
+    int crop[4] = { 0 };
+    const int band_n = (thread_n > 1) ? thread_n * RGY_CONVERT_CSP_BANDS_PER_THREAD : 1;
+    auto run = [&]() {
+        if (band_n <= 1) {
+            func(dst, src, width, src_pitch, src_pitch, dst_pitch, height, height, 0, 1, crop);
+            return;
+        }
+        RGYThreadPool::get()->parallel_for(band_n, thread_n, [&](int band_id) {
+            func(dst, src, width, src_pitch, src_pitch, dst_pitch, height, height, band_id, band_n, crop);
+        });
+    };
+    //ウォームアップ
+    run();
+
+    int loops = 0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    auto elapsed = std::chrono::duration<double>(0.0);
+    do {
+        run();
+        loops++;
+        elapsed = std::chrono::high_resolution_clock::now() - start;
+    } while (elapsed.count() < 0.25 && loops < 10000);
+
+    //入力と出力のデータ量の合計から処理速度を計算する
+    double read_bytes = 0.0, write_bytes = 0.0;
+    convert_csp_frame_bytes(convert, width, height, &read_bytes, &write_bytes);
+    return (read_bytes + write_bytes) * loops / elapsed.count() / (1024.0 * 1024.0);
+}
+
 const TCHAR *get_simd_str(unsigned int simd) {
     static std::vector<std::pair<uint32_t, const TCHAR*>> simd_str_list = {
+        { AVX512BW, _T("AVX512BW") },
         { AVX2,  _T("AVX2")   },
         { AVX,   _T("AVX")    },
         { SSE42, _T("SSE4.2") },
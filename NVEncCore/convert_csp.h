@@ -46,6 +46,17 @@ enum RGY_PLANE {
 
 typedef void (*funcConvertCSP) (void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
 
+//入力のビット深度(9～16bit)ごとの変換関数は、各SIMD版のソースにビット深度を
+//テンプレート引数とする関数として実装し、以下のマクロで明示的に実体化して関数表から func<10> のように参照する
+#define CONVERT_CSP_INSTANTIATE(func, bit_depth) \
+    template void func<bit_depth>(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop);
+#define CONVERT_CSP_INSTANTIATE_HIGHBIT(func) \
+    CONVERT_CSP_INSTANTIATE(func, 16) \
+    CONVERT_CSP_INSTANTIATE(func, 14) \
+    CONVERT_CSP_INSTANTIATE(func, 12) \
+    CONVERT_CSP_INSTANTIATE(func, 10) \
+    CONVERT_CSP_INSTANTIATE(func, 9)
+
 enum RGY_CSP {
     RGY_CSP_NA = 0,
     RGY_CSP_NV12,
@@ -352,6 +363,16 @@ typedef struct ConvertCSP {
 
 const ConvertCSP *get_convert_csp_func(RGY_CSP csp_from, RGY_CSP csp_to, bool uv_only, uint32_t simd);
 const TCHAR *get_simd_str(unsigned int simd);
+//csp_from, csp_toにRGY_CSP_NAを指定すると、すべての変換元/変換先を対象とする
+std::vector<const ConvertCSP *> get_convert_csp_func_list(RGY_CSP csp_from, RGY_CSP csp_to, bool uv_only, uint32_t simd);
+//マルチスレッドで変換する際に1スレッドあたりに割り当てるバンド数
+static const int RGY_CONVERT_CSP_BANDS_PER_THREAD = 4;
+//変換関数の処理速度を計測する
+//thread_n>1の場合は、RGYConvertCSPと同様にフレームをバンドに分割して共有のスレッドプールで処理する
+//戻り値は入力と出力のデータ量の合計から計算した処理速度 (MB/s)、失敗時は負の値
+double convert_csp_speed(const ConvertCSP *convert, int width, int height, bool interlaced, int thread_n = 1);
+//変換関数が1フレームあたりに読み込むバイト数と書き込むバイト数
+void convert_csp_frame_bytes(const ConvertCSP *convert, int width, int height, double *read_bytes, double *write_bytes);
 
 enum RGY_FRAME_FLAGS : uint64_t {
     RGY_FRAME_FLAG_NONE     = 0x00u,
@@ -35,6 +35,7 @@
 #include "rgy_simd.h"
 #include <stdint.h>
 #include <string.h>
+#include <algorithm>
 #include "convert_csp.h"
 
 #if _MSC_VER >= 1800 && !defined(__AVX__) && !defined(_DEBUG)
@@ -600,25 +601,11 @@ static void convert_yv12_high_to_nv12_avx2_base(void **dst, const void **src, in
 }
 #pragma warning (pop)
 
-void convert_yv12_16_to_nv12_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yv12_high_to_nv12_avx2_base<16, false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
-}
-
-void convert_yv12_14_to_nv12_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yv12_high_to_nv12_avx2_base<14, false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
-}
-
-void convert_yv12_12_to_nv12_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yv12_high_to_nv12_avx2_base<12, false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
-}
-
-void convert_yv12_10_to_nv12_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yv12_high_to_nv12_avx2_base<10, false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
-}
-
-void convert_yv12_09_to_nv12_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yv12_high_to_nv12_avx2_base<9, false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+template<int in_bit_depth>
+void convert_yv12_high_to_nv12_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yv12_high_to_nv12_avx2_base<in_bit_depth, false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
 }
+CONVERT_CSP_INSTANTIATE_HIGHBIT(convert_yv12_high_to_nv12_avx2)
 
 #pragma warning (push)
 #pragma warning (disable: 4100)
@@ -686,25 +673,170 @@ static void __forceinline convert_yv12_high_to_p010_avx2_base(void **dst, const
 }
 #pragma warning (pop)
 
-void convert_yv12_16_to_p010_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yv12_high_to_p010_avx2_base<16, false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+template<int in_bit_depth>
+void convert_yv12_high_to_p010_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yv12_high_to_p010_avx2_base<in_bit_depth, false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
 }
+CONVERT_CSP_INSTANTIATE_HIGHBIT(convert_yv12_high_to_p010_avx2)
 
-void convert_yv12_14_to_p010_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yv12_high_to_p010_avx2_base<14, false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
-}
+#pragma warning (push)
+#pragma warning (disable: 4100)
+#pragma warning (disable: 4127)
+void convert_yuv422_to_nv16_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    const int crop_left   = crop[0];
+    const int crop_up     = crop[1];
+    const int crop_right  = crop[2];
+    const int crop_bottom = crop[3];
+    //Y成分のコピー
+    const auto y_range = thread_y_range(crop_up, height - crop_bottom, thread_id, thread_n);
+    uint8_t *srcYLine = (uint8_t *)src[0] + src_y_pitch_byte * y_range.start_src + crop_left;
+    uint8_t *dstLine = (uint8_t *)dst[0] + dst_y_pitch_byte * y_range.start_dst;
+    const int y_width = width - crop_right - crop_left;
+    for (int y = 0; y < y_range.len; y++, srcYLine += src_y_pitch_byte, dstLine += dst_y_pitch_byte) {
+        avx2_memcpy<false>(dstLine, srcYLine, y_width);
+    }
+    //UV成分のコピー
+    uint8_t *srcULine = (uint8_t *)src[1] + ((src_uv_pitch_byte * y_range.start_src) + (crop_left >> 1));
+    uint8_t *srcVLine = (uint8_t *)src[2] + ((src_uv_pitch_byte * y_range.start_src) + (crop_left >> 1));
+    dstLine = (uint8_t *)dst[1] + dst_y_pitch_byte * y_range.start_dst;
+    for (int y = 0; y < y_range.len; y++, srcULine += src_uv_pitch_byte, srcVLine += src_uv_pitch_byte, dstLine += dst_y_pitch_byte) {
+        const int x_fin = width - crop_right;
+        uint8_t *src_u_ptr = srcULine;
+        uint8_t *src_v_ptr = srcVLine;
+        uint8_t *dst_ptr = dstLine;
+        __m256i y0, y1, y2;
+        for (int x = crop_left; x < x_fin; x += 64, src_u_ptr += 32, src_v_ptr += 32, dst_ptr += 64) {
+            y0 = _mm256_loadu_si256((const __m256i *)src_u_ptr);
+            y1 = _mm256_loadu_si256((const __m256i *)src_v_ptr);
+
+            y0 = _mm256_permute4x64_epi64(y0, _MM_SHUFFLE(3,1,2,0));
+            y1 = _mm256_permute4x64_epi64(y1, _MM_SHUFFLE(3,1,2,0));
+
+            y2 = _mm256_unpackhi_epi8(y0, y1);
+            y0 = _mm256_unpacklo_epi8(y0, y1);
 
-void convert_yv12_12_to_p010_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yv12_high_to_p010_avx2_base<12, false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+            _mm256_storeu_si256((__m256i *)(dst_ptr +  0), y0);
+            _mm256_storeu_si256((__m256i *)(dst_ptr + 32), y2);
+        }
+    }
+    _mm256_zeroupper();
 }
 
-void convert_yv12_10_to_p010_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yv12_high_to_p010_avx2_base<10, false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+void convert_yuv422_to_p210_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    const int crop_left   = crop[0];
+    const int crop_up     = crop[1];
+    const int crop_right  = crop[2];
+    const int crop_bottom = crop[3];
+    const int src_y_pitch = src_y_pitch_byte;
+    const int dst_y_pitch = dst_y_pitch_byte >> 1;
+    //Y成分のコピー
+    const auto y_range = thread_y_range(crop_up, height - crop_bottom, thread_id, thread_n);
+    uint8_t *srcYLine = (uint8_t *)src[0] + src_y_pitch * y_range.start_src + crop_left;
+    uint16_t *dstLine = (uint16_t *)dst[0] + dst_y_pitch * y_range.start_dst;
+    const int y_width = width - crop_right - crop_left;
+    for (int y = 0; y < y_range.len; y++, srcYLine += src_y_pitch, dstLine += dst_y_pitch) {
+        uint8_t *src_ptr = srcYLine;
+        uint16_t *dst_ptr = dstLine;
+        for (int x = 0; x < y_width; x += 32, dst_ptr += 32, src_ptr += 32) {
+            __m256i y0, y1;
+            y0 = _mm256_loadu_si256((const __m256i *)src_ptr);
+            y0 = _mm256_permute4x64_epi64(y0, _MM_SHUFFLE(3,1,2,0));
+            y1 = _mm256_unpackhi_epi8(_mm256_setzero_si256(), y0);
+            y0 = _mm256_unpacklo_epi8(_mm256_setzero_si256(), y0);
+            _mm256_storeu_si256((__m256i *)(dst_ptr +  0), y0);
+            _mm256_storeu_si256((__m256i *)(dst_ptr + 16), y1);
+        }
+    }
+    //UV成分のコピー
+    const int src_uv_pitch = src_uv_pitch_byte;
+    uint8_t *srcULine = (uint8_t *)src[1] + ((src_uv_pitch * y_range.start_src) + (crop_left >> 1));
+    uint8_t *srcVLine = (uint8_t *)src[2] + ((src_uv_pitch * y_range.start_src) + (crop_left >> 1));
+    dstLine = (uint16_t *)dst[1] + dst_y_pitch * y_range.start_dst;
+    for (int y = 0; y < y_range.len; y++, srcULine += src_uv_pitch, srcVLine += src_uv_pitch, dstLine += dst_y_pitch) {
+        const int x_fin = width - crop_right;
+        uint8_t *src_u_ptr = srcULine;
+        uint8_t *src_v_ptr = srcVLine;
+        uint16_t *dst_ptr = dstLine;
+        __m256i y0, y1, y2;
+        for (int x = crop_left; x < x_fin; x += 32, src_u_ptr += 16, src_v_ptr += 16, dst_ptr += 32) {
+            //16bitに拡張して上位に詰める
+            y0 = _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)src_u_ptr)), 8);
+            y1 = _mm256_slli_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)src_v_ptr)), 8);
+
+            y0 = _mm256_permute4x64_epi64(y0, _MM_SHUFFLE(3,1,2,0));
+            y1 = _mm256_permute4x64_epi64(y1, _MM_SHUFFLE(3,1,2,0));
+
+            y2 = _mm256_unpackhi_epi16(y0, y1);
+            y0 = _mm256_unpacklo_epi16(y0, y1);
+
+            _mm256_storeu_si256((__m256i *)(dst_ptr +  0), y0);
+            _mm256_storeu_si256((__m256i *)(dst_ptr + 16), y2);
+        }
+    }
+    _mm256_zeroupper();
 }
 
-void convert_yv12_09_to_p010_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yv12_high_to_p010_avx2_base<9, false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+template<int in_bit_depth>
+void convert_yuv422_high_to_p210_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    static_assert(8 < in_bit_depth && in_bit_depth <= 16, "in_bit_depth must be 9-16.");
+    const int crop_left   = crop[0];
+    const int crop_up     = crop[1];
+    const int crop_right  = crop[2];
+    const int crop_bottom = crop[3];
+    const int src_y_pitch = src_y_pitch_byte >> 1;
+    const int dst_y_pitch = dst_y_pitch_byte >> 1;
+    //Y成分のコピー
+    const auto y_range = thread_y_range(crop_up, height - crop_bottom, thread_id, thread_n);
+    uint16_t *srcYLine = (uint16_t *)src[0] + src_y_pitch * y_range.start_src + crop_left;
+    uint16_t *dstLine = (uint16_t *)dst[0] + dst_y_pitch * y_range.start_dst;
+    const int y_width = width - crop_right - crop_left;
+    for (int y = 0; y < y_range.len; y++, srcYLine += src_y_pitch, dstLine += dst_y_pitch) {
+        if (in_bit_depth == 16) {
+            avx2_memcpy<false>((uint8_t *)dstLine, (uint8_t *)srcYLine, y_width * (int)sizeof(uint16_t));
+        } else {
+            uint16_t *src_ptr = srcYLine;
+            uint16_t *dst_ptr = dstLine;
+            for (int x = 0; x < y_width; x += 16, dst_ptr += 16, src_ptr += 16) {
+                __m256i y0 = _mm256_loadu_si256((const __m256i *)src_ptr);
+                y0 = _mm256_slli_epi16(y0, 16 - in_bit_depth);
+                _mm256_storeu_si256((__m256i *)dst_ptr, y0);
+            }
+        }
+    }
+    //UV成分のコピー
+    const int src_uv_pitch = src_uv_pitch_byte >> 1;
+    uint16_t *srcULine = (uint16_t *)src[1] + ((src_uv_pitch * y_range.start_src) + (crop_left >> 1));
+    uint16_t *srcVLine = (uint16_t *)src[2] + ((src_uv_pitch * y_range.start_src) + (crop_left >> 1));
+    dstLine = (uint16_t *)dst[1] + dst_y_pitch * y_range.start_dst;
+    for (int y = 0; y < y_range.len; y++, srcULine += src_uv_pitch, srcVLine += src_uv_pitch, dstLine += dst_y_pitch) {
+        const int x_fin = width - crop_right;
+        uint16_t *src_u_ptr = srcULine;
+        uint16_t *src_v_ptr = srcVLine;
+        uint16_t *dst_ptr = dstLine;
+        __m256i y0, y1, y2;
+        for (int x = crop_left; x < x_fin; x += 32, src_u_ptr += 16, src_v_ptr += 16, dst_ptr += 32) {
+            y0 = _mm256_loadu_si256((const __m256i *)src_u_ptr);
+            y1 = _mm256_loadu_si256((const __m256i *)src_v_ptr);
+
+            if (in_bit_depth < 16) {
+                y0 = _mm256_slli_epi16(y0, 16 - in_bit_depth);
+                y1 = _mm256_slli_epi16(y1, 16 - in_bit_depth);
+            }
+
+            y0 = _mm256_permute4x64_epi64(y0, _MM_SHUFFLE(3,1,2,0));
+            y1 = _mm256_permute4x64_epi64(y1, _MM_SHUFFLE(3,1,2,0));
+
+            y2 = _mm256_unpackhi_epi16(y0, y1);
+            y0 = _mm256_unpacklo_epi16(y0, y1);
+
+            _mm256_storeu_si256((__m256i *)(dst_ptr +  0), y0);
+            _mm256_storeu_si256((__m256i *)(dst_ptr + 16), y2);
+        }
+    }
+    _mm256_zeroupper();
 }
+CONVERT_CSP_INSTANTIATE_HIGHBIT(convert_yuv422_high_to_p210_avx2)
+#pragma warning (pop)
 
 #pragma warning (push)
 #pragma warning (disable: 4100)
@@ -756,25 +888,11 @@ static void __forceinline convert_yuv444_high_to_yuv444_16_avx2_base(void **dst,
 }
 #pragma warning(pop)
 
-void convert_yuv444_16_to_yuv444_16_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yuv444_high_to_yuv444_16_avx2_base<16>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
-}
-
-void convert_yuv444_14_to_yuv444_16_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yuv444_high_to_yuv444_16_avx2_base<14>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
-}
-
-void convert_yuv444_12_to_yuv444_16_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yuv444_high_to_yuv444_16_avx2_base<12>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
-}
-
-void convert_yuv444_10_to_yuv444_16_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yuv444_high_to_yuv444_16_avx2_base<10>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
-}
-
-void convert_yuv444_09_to_yuv444_16_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yuv444_high_to_yuv444_16_avx2_base<9>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+template<int in_bit_depth>
+void convert_yuv444_high_to_yuv444_16_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yuv444_high_to_yuv444_16_avx2_base<in_bit_depth>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
 }
+CONVERT_CSP_INSTANTIATE_HIGHBIT(convert_yuv444_high_to_yuv444_16_avx2)
 
 #pragma warning (push)
 #pragma warning (disable: 4100)
@@ -835,25 +953,243 @@ static void __forceinline convert_yuv444_high_to_yuv444_avx2_base(void **dst, co
 }
 #pragma warning(pop)
 
-void convert_yuv444_16_to_yuv444_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yuv444_high_to_yuv444_avx2_base<16>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+template<int in_bit_depth>
+void convert_yuv444_high_to_yuv444_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yuv444_high_to_yuv444_avx2_base<in_bit_depth>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+CONVERT_CSP_INSTANTIATE_HIGHBIT(convert_yuv444_high_to_yuv444_avx2)
+
+//横方向32画素分を読み込み、偶数番目(左側)の画素を16bit x 16として返す
+template<typename Tin>
+static __forceinline __m256i load_yuv444_uv_even_avx2(const Tin *ptr) {
+    if (sizeof(Tin) == 1) {
+        return _mm256_and_si256(_mm256_loadu_si256((const __m256i *)ptr), _mm256_set1_epi16(0x00ff));
+    } else {
+        const __m256i yMask = _mm256_set1_epi32(0x0000ffff);
+        __m256i y0 = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(ptr +  0)), yMask);
+        __m256i y1 = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(ptr + 16)), yMask);
+        return _mm256_permute4x64_epi64(_mm256_packus_epi32(y0, y1), _MM_SHUFFLE(3,1,2,0));
+    }
 }
 
-void convert_yuv444_14_to_yuv444_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yuv444_high_to_yuv444_avx2_base<14>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+//(y0 + y1 + 1)を計算し、出力ビット深度に合わせる (convert_yuv444_to_nv12_p_cと同じ結果)
+template<int in_bit_depth, int out_bit_depth>
+static __forceinline __m256i yuv444_to_420_p_avx2(__m256i y0, __m256i y1) {
+    if (in_bit_depth == 16) {
+        //16bitでは加算でオーバーフローするので、avgで(y0 + y1 + 1) >> 1を計算する
+        const __m256i y = _mm256_avg_epu16(y0, y1);
+        return (out_bit_depth == 16) ? y : _mm256_srli_epi16(y, std::max(16 - out_bit_depth, 0));
+    }
+    __m256i y = _mm256_add_epi16(_mm256_add_epi16(y0, y1), _mm256_set1_epi16(1));
+    if (out_bit_depth > in_bit_depth + 1) {
+        y = _mm256_slli_epi16(y, std::max(out_bit_depth - in_bit_depth - 1, 0));
+    } else if (out_bit_depth < in_bit_depth + 1) {
+        y = _mm256_srli_epi16(y, std::max(in_bit_depth + 1 - out_bit_depth, 0));
+    }
+    return y;
 }
 
-void convert_yuv444_12_to_yuv444_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yuv444_high_to_yuv444_avx2_base<12>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+//(y0 * 3 + y1 * 1 + 2)を計算し、出力ビット深度に合わせる (convert_yuv444_to_nv12_i_cと同じ結果)
+template<int in_bit_depth, int out_bit_depth>
+static __forceinline __m256i yuv444_to_420_i_avx2(__m256i y0_x3, __m256i y1_x1) {
+    if (in_bit_depth > 14) {
+        //16bitの範囲を超えるので32bitで計算する
+        const __m256i yOffset = _mm256_set1_epi32(2);
+        const __m256i yMul3 = _mm256_set1_epi32(3);
+        __m256i yLo = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(y0_x3)), yMul3), _mm256_cvtepu16_epi32(_mm256_castsi256_si128(y1_x1)));
+        __m256i yHi = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(y0_x3, 1)), yMul3), _mm256_cvtepu16_epi32(_mm256_extracti128_si256(y1_x1, 1)));
+        yLo = _mm256_add_epi32(yLo, yOffset);
+        yHi = _mm256_add_epi32(yHi, yOffset);
+        if (out_bit_depth > in_bit_depth + 2) {
+            yLo = _mm256_slli_epi32(yLo, std::max(out_bit_depth - in_bit_depth - 2, 0));
+            yHi = _mm256_slli_epi32(yHi, std::max(out_bit_depth - in_bit_depth - 2, 0));
+        } else if (out_bit_depth < in_bit_depth + 2) {
+            yLo = _mm256_srli_epi32(yLo, std::max(in_bit_depth + 2 - out_bit_depth, 0));
+            yHi = _mm256_srli_epi32(yHi, std::max(in_bit_depth + 2 - out_bit_depth, 0));
+        }
+        return _mm256_permute4x64_epi64(_mm256_packus_epi32(yLo, yHi), _MM_SHUFFLE(3,1,2,0));
+    }
+    __m256i y = _mm256_add_epi16(_mm256_mullo_epi16(y0_x3, _mm256_set1_epi16(3)), y1_x1);
+    y = _mm256_add_epi16(y, _mm256_set1_epi16(2));
+    if (out_bit_depth > in_bit_depth + 2) {
+        y = _mm256_slli_epi16(y, std::max(out_bit_depth - in_bit_depth - 2, 0));
+    } else if (out_bit_depth < in_bit_depth + 2) {
+        y = _mm256_srli_epi16(y, std::max(in_bit_depth + 2 - out_bit_depth, 0));
+    }
+    return y;
+}
+
+//U, V(16bit x 16)を出力形式に合わせて書き込む
+template<int out_bit_depth>
+static __forceinline void store_yuv444_uv_avx2(void *dst_ptr, __m256i yU, __m256i yV) {
+    if (out_bit_depth == 8) {
+        //8bitに収まっているので、Vを上位バイトに移動してNV12の並びにする
+        _mm256_storeu_si256((__m256i *)dst_ptr, _mm256_or_si256(yU, _mm256_slli_epi16(yV, 8)));
+    } else {
+        __m256i y0 = _mm256_unpacklo_epi16(yU, yV);
+        __m256i y1 = _mm256_unpackhi_epi16(yU, yV);
+        _mm256_storeu_si256((__m256i *)dst_ptr + 0, _mm256_permute2x128_si256(y0, y1, (2<<4) | 0));
+        _mm256_storeu_si256((__m256i *)dst_ptr + 1, _mm256_permute2x128_si256(y0, y1, (3<<4) | 1));
+    }
 }
 
-void convert_yuv444_10_to_yuv444_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yuv444_high_to_yuv444_avx2_base<10>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+//輝度を出力ビット深度に合わせてコピーする
+template<typename Tin, int in_bit_depth, typename Tout, int out_bit_depth>
+static __forceinline void convert_yuv444_y_line_avx2(Tout *dstLine, const Tin *srcLine, int y_width) {
+    if (in_bit_depth == out_bit_depth && sizeof(Tin) == sizeof(Tout)) {
+        avx2_memcpy<false>((uint8_t *)dstLine, (const uint8_t *)srcLine, y_width * (int)sizeof(Tin));
+    } else if (sizeof(Tin) == 1) {
+        //8bit -> 16bit
+        for (int x = 0; x < y_width; x += 32) {
+            __m256i y0 = _mm256_loadu_si256((const __m256i *)((const uint8_t *)srcLine + x));
+            y0 = _mm256_permute4x64_epi64(y0, _MM_SHUFFLE(3,1,2,0));
+            _mm256_storeu_si256((__m256i *)((uint16_t *)dstLine + x +  0), _mm256_unpacklo_epi8(_mm256_setzero_si256(), y0));
+            _mm256_storeu_si256((__m256i *)((uint16_t *)dstLine + x + 16), _mm256_unpackhi_epi8(_mm256_setzero_si256(), y0));
+        }
+    } else if (sizeof(Tout) == 1) {
+        //high bit depth -> 8bit
+        for (int x = 0; x < y_width; x += 32) {
+            const uint16_t *src_ptr = (const uint16_t *)srcLine + x;
+            __m256i y0 = _mm256_loadu2_m128i((const __m128i *)(src_ptr + 16), (const __m128i *)(src_ptr +  0));
+            __m256i y1 = _mm256_loadu2_m128i((const __m128i *)(src_ptr + 24), (const __m128i *)(src_ptr +  8));
+            y0 = _mm256_srli_epi16(y0, std::max(in_bit_depth - 8, 0));
+            y1 = _mm256_srli_epi16(y1, std::max(in_bit_depth - 8, 0));
+            _mm256_storeu_si256((__m256i *)((uint8_t *)dstLine + x), _mm256_packus_epi16(y0, y1));
+        }
+    } else {
+        //high bit depth -> 16bit
+        for (int x = 0; x < y_width; x += 16) {
+            __m256i y0 = _mm256_loadu_si256((const __m256i *)((const uint16_t *)srcLine + x));
+            y0 = _mm256_slli_epi16(y0, std::max(out_bit_depth - in_bit_depth, 0));
+            _mm256_storeu_si256((__m256i *)((uint16_t *)dstLine + x), y0);
+        }
+    }
 }
 
-void convert_yuv444_09_to_yuv444_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
-    convert_yuv444_high_to_yuv444_avx2_base<9>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+#pragma warning (push)
+#pragma warning (disable: 4100)
+#pragma warning (disable: 4127)
+template<typename Tin, int in_bit_depth, typename Tout, int out_bit_depth>
+static void __forceinline convert_yuv444_to_nv12_p_avx2_base(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    static_assert((sizeof(Tin)  == 1 && in_bit_depth  == 8) || (sizeof(Tin)  == 2 && 8 < in_bit_depth  && in_bit_depth  <= 16), "invalid input bit depth.");
+    static_assert((sizeof(Tout) == 1 && out_bit_depth == 8) || (sizeof(Tout) == 2 && out_bit_depth == 16), "invalid output bit depth.");
+    const int crop_left   = crop[0];
+    const int crop_up     = crop[1];
+    const int crop_right  = crop[2];
+    const int crop_bottom = crop[3];
+    const int src_y_pitch = src_y_pitch_byte / sizeof(Tin);
+    const int dst_y_pitch = dst_y_pitch_byte / sizeof(Tout);
+    const int y_width = width - crop_right - crop_left;
+    const auto y_range = thread_y_range(crop_up, height - crop_bottom, thread_id, thread_n);
+    //Y成分のコピー
+    const Tin *srcYLine = (const Tin *)src[0] + src_y_pitch * y_range.start_src + crop_left;
+    Tout *dstYLine = (Tout *)dst[0] + dst_y_pitch * y_range.start_dst;
+    for (int y = 0; y < y_range.len; y++, srcYLine += src_y_pitch, dstYLine += dst_y_pitch) {
+        convert_yuv444_y_line_avx2<Tin, in_bit_depth, Tout, out_bit_depth>(dstYLine, srcYLine, y_width);
+    }
+    //UV成分のコピー
+    const int src_uv_pitch = src_uv_pitch_byte / sizeof(Tin);
+    const Tin *srcULine = (const Tin *)src[1] + ((src_uv_pitch * y_range.start_src) + crop_left);
+    const Tin *srcVLine = (const Tin *)src[2] + ((src_uv_pitch * y_range.start_src) + crop_left);
+    Tout *dstLine = (Tout *)dst[1] + (dst_y_pitch >> 1) * y_range.start_dst;
+    for (int y = 0; y < y_range.len; y += 2, srcULine += src_uv_pitch * 2, srcVLine += src_uv_pitch * 2, dstLine += dst_y_pitch) {
+        for (int x = 0; x < y_width; x += 32) {
+            __m256i yU0 = load_yuv444_uv_even_avx2(srcULine + x + 0*src_uv_pitch);
+            __m256i yU1 = load_yuv444_uv_even_avx2(srcULine + x + 1*src_uv_pitch);
+            __m256i yV0 = load_yuv444_uv_even_avx2(srcVLine + x + 0*src_uv_pitch);
+            __m256i yV1 = load_yuv444_uv_even_avx2(srcVLine + x + 1*src_uv_pitch);
+            __m256i yU = yuv444_to_420_p_avx2<in_bit_depth, out_bit_depth>(yU0, yU1);
+            __m256i yV = yuv444_to_420_p_avx2<in_bit_depth, out_bit_depth>(yV0, yV1);
+            store_yuv444_uv_avx2<out_bit_depth>(dstLine + x, yU, yV);
+        }
+    }
+    _mm256_zeroupper();
+}
+
+template<typename Tin, int in_bit_depth, typename Tout, int out_bit_depth>
+static void __forceinline convert_yuv444_to_nv12_i_avx2_base(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    static_assert((sizeof(Tin)  == 1 && in_bit_depth  == 8) || (sizeof(Tin)  == 2 && 8 < in_bit_depth  && in_bit_depth  <= 16), "invalid input bit depth.");
+    static_assert((sizeof(Tout) == 1 && out_bit_depth == 8) || (sizeof(Tout) == 2 && out_bit_depth == 16), "invalid output bit depth.");
+    const int crop_left   = crop[0];
+    const int crop_up     = crop[1];
+    const int crop_right  = crop[2];
+    const int crop_bottom = crop[3];
+    const int src_y_pitch = src_y_pitch_byte / sizeof(Tin);
+    const int dst_y_pitch = dst_y_pitch_byte / sizeof(Tout);
+    const int y_width = width - crop_right - crop_left;
+    const auto y_range = thread_y_range(crop_up, height - crop_bottom, thread_id, thread_n);
+    //Y成分のコピー
+    const Tin *srcYLine = (const Tin *)src[0] + src_y_pitch * y_range.start_src + crop_left;
+    Tout *dstYLine = (Tout *)dst[0] + dst_y_pitch * y_range.start_dst;
+    for (int y = 0; y < y_range.len; y++, srcYLine += src_y_pitch, dstYLine += dst_y_pitch) {
+        convert_yuv444_y_line_avx2<Tin, in_bit_depth, Tout, out_bit_depth>(dstYLine, srcYLine, y_width);
+    }
+    //UV成分のコピー
+    const int src_uv_pitch = src_uv_pitch_byte / sizeof(Tin);
+    const Tin *srcULine = (const Tin *)src[1] + ((src_uv_pitch * y_range.start_src) + crop_left);
+    const Tin *srcVLine = (const Tin *)src[2] + ((src_uv_pitch * y_range.start_src) + crop_left);
+    Tout *dstLine = (Tout *)dst[1] + (dst_y_pitch >> 1) * y_range.start_dst;
+    for (int y = 0; y < y_range.len; y += 4, srcULine += src_uv_pitch * 4, srcVLine += src_uv_pitch * 4, dstLine += dst_y_pitch * 2) {
+        for (int x = 0; x < y_width; x += 32) {
+            __m256i yU0 = load_yuv444_uv_even_avx2(srcULine + x + 0*src_uv_pitch);
+            __m256i yU1 = load_yuv444_uv_even_avx2(srcULine + x + 1*src_uv_pitch);
+            __m256i yU2 = load_yuv444_uv_even_avx2(srcULine + x + 2*src_uv_pitch);
+            __m256i yU3 = load_yuv444_uv_even_avx2(srcULine + x + 3*src_uv_pitch);
+            __m256i yV0 = load_yuv444_uv_even_avx2(srcVLine + x + 0*src_uv_pitch);
+            __m256i yV1 = load_yuv444_uv_even_avx2(srcVLine + x + 1*src_uv_pitch);
+            __m256i yV2 = load_yuv444_uv_even_avx2(srcVLine + x + 2*src_uv_pitch);
+            __m256i yV3 = load_yuv444_uv_even_avx2(srcVLine + x + 3*src_uv_pitch);
+            store_yuv444_uv_avx2<out_bit_depth>(dstLine + x + 0*dst_y_pitch,
+                yuv444_to_420_i_avx2<in_bit_depth, out_bit_depth>(yU0, yU2),
+                yuv444_to_420_i_avx2<in_bit_depth, out_bit_depth>(yV0, yV2));
+            store_yuv444_uv_avx2<out_bit_depth>(dstLine + x + 1*dst_y_pitch,
+                yuv444_to_420_i_avx2<in_bit_depth, out_bit_depth>(yU3, yU1),
+                yuv444_to_420_i_avx2<in_bit_depth, out_bit_depth>(yV3, yV1));
+        }
+    }
+    _mm256_zeroupper();
+}
+#pragma warning(pop)
+
+void convert_yuv444_to_nv12_p_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yuv444_to_nv12_p_avx2_base<uint8_t, 8, uint8_t, 8>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+
+void convert_yuv444_to_nv12_i_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yuv444_to_nv12_i_avx2_base<uint8_t, 8, uint8_t, 8>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+
+template<int in_bit_depth>
+void convert_yuv444_high_to_nv12_p_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yuv444_to_nv12_p_avx2_base<uint16_t, in_bit_depth, uint8_t, 8>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+CONVERT_CSP_INSTANTIATE_HIGHBIT(convert_yuv444_high_to_nv12_p_avx2)
+
+template<int in_bit_depth>
+void convert_yuv444_high_to_nv12_i_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yuv444_to_nv12_i_avx2_base<uint16_t, in_bit_depth, uint8_t, 8>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+CONVERT_CSP_INSTANTIATE_HIGHBIT(convert_yuv444_high_to_nv12_i_avx2)
+
+void convert_yuv444_to_p010_p_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yuv444_to_nv12_p_avx2_base<uint8_t, 8, uint16_t, 16>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+
+void convert_yuv444_to_p010_i_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yuv444_to_nv12_i_avx2_base<uint8_t, 8, uint16_t, 16>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+
+template<int in_bit_depth>
+void convert_yuv444_high_to_p010_p_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yuv444_to_nv12_p_avx2_base<uint16_t, in_bit_depth, uint16_t, 16>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+CONVERT_CSP_INSTANTIATE_HIGHBIT(convert_yuv444_high_to_p010_p_avx2)
+
+template<int in_bit_depth>
+void convert_yuv444_high_to_p010_i_avx2(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yuv444_to_nv12_i_avx2_base<uint16_t, in_bit_depth, uint16_t, 16>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
 }
+CONVERT_CSP_INSTANTIATE_HIGHBIT(convert_yuv444_high_to_p010_i_avx2)
 
 #include "convert_const.h"
 
@@ -0,0 +1,509 @@
+﻿// -----------------------------------------------------------------------------------------
+// QSVEnc/NVEnc by rigaya
+// -----------------------------------------------------------------------------------------
+// The MIT License
+//
+// Copyright (c) 2011-2016 rigaya
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// ------------------------------------------------------------------------------------------
+
+#define USE_SSE2   1
+#define USE_SSSE3  1
+#define USE_SSE41  1
+#define USE_AVX    1
+#define USE_AVX2   1
+#define USE_AVX512 1
+
+#include <immintrin.h>
+#include "rgy_simd.h"
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include "convert_csp.h"
+
+#if _MSC_VER >= 1911 && !defined(__AVX512BW__) && !defined(_DEBUG)
+static_assert(false, "do not forget to set /arch:AVX512 for this file.");
+#endif
+
+#if (defined(_MSC_VER) && _MSC_VER >= 1911) || (defined(__AVX512BW__) && defined(__AVX512VL__))
+
+//残りの要素数からマスクを作成する
+//AVX512ではマスク付きload/storeで端数を処理するので、行の終端を越えて読み書きしない
+static __forceinline __mmask64 mask64_remain(int n) {
+    return (n >= 64) ? ~(__mmask64)0 : ((n <= 0) ? (__mmask64)0 : (((__mmask64)1 << n) - 1));
+}
+
+static __forceinline __mmask32 mask32_remain(int n) {
+    return (n >= 32) ? ~(__mmask32)0 : ((n <= 0) ? (__mmask32)0 : (((__mmask32)1 << n) - 1));
+}
+
+static __forceinline void avx512_memcpy(uint8_t *dst, const uint8_t *src, int size) {
+    for (; size > 0; size -= 64, dst += 64, src += 64) {
+        const __mmask64 mask = mask64_remain(size);
+        _mm512_mask_storeu_epi8(dst, mask, _mm512_maskz_loadu_epi8(mask, src));
+    }
+}
+
+//_mm512_unpacklo/hi_epi8の結果(128bit単位でインタリーブされている)を並べなおすためのインデックス
+alignas(64) static const int64_t PERMUTE_UNPACK_LO_64[8] = { 0, 1, 8,  9, 2, 3, 10, 11 };
+alignas(64) static const int64_t PERMUTE_UNPACK_HI_64[8] = { 4, 5, 12, 13, 6, 7, 14, 15 };
+//_mm512_packus_epi16の結果(128bit単位でインタリーブされている)を並べなおすためのインデックス
+alignas(64) static const int64_t PERMUTE_PACK_64[8] = { 0, 2, 4, 6, 1, 3, 5, 7 };
+//16bit x 32のU, Vをインタリーブするためのインデックス
+alignas(64) static const uint16_t PERMUTE_INTERLEAVE_LO_16[32] = {
+     0, 32,  1, 33,  2, 34,  3, 35,  4, 36,  5, 37,  6, 38,  7, 39,
+     8, 40,  9, 41, 10, 42, 11, 43, 12, 44, 13, 45, 14, 46, 15, 47
+};
+alignas(64) static const uint16_t PERMUTE_INTERLEAVE_HI_16[32] = {
+    16, 48, 17, 49, 18, 50, 19, 51, 20, 52, 21, 53, 22, 54, 23, 55,
+    24, 56, 25, 57, 26, 58, 27, 59, 28, 60, 29, 61, 30, 62, 31, 63
+};
+//16bit x 64から偶数番目の要素を取り出すためのインデックス
+alignas(64) static const uint16_t PERMUTE_EVEN_16[32] = {
+     0,  2,  4,  6,  8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30,
+    32, 34, 36, 38, 40, 42, 44, 46, 48, 50, 52, 54, 56, 58, 60, 62
+};
+
+//16bitのU, V(それぞれ32要素)をインタリーブしてdst_ptrに書き込む
+//n ... 書き込むU,Vの組の数
+static __forceinline void store_interleave_uv16_avx512(uint16_t *dst_ptr, __m512i u, __m512i v, int n) {
+    const __m512i z0 = _mm512_permutex2var_epi16(u, _mm512_load_si512((const __m512i *)PERMUTE_INTERLEAVE_LO_16), v);
+    const __m512i z1 = _mm512_permutex2var_epi16(u, _mm512_load_si512((const __m512i *)PERMUTE_INTERLEAVE_HI_16), v);
+    _mm512_mask_storeu_epi16(dst_ptr +  0, mask32_remain(n * 2),      z0);
+    _mm512_mask_storeu_epi16(dst_ptr + 32, mask32_remain(n * 2 - 32), z1);
+}
+
+#pragma warning (push)
+#pragma warning (disable: 4127)
+#pragma warning (disable: 4100)
+template<bool uv_only>
+static void __forceinline convert_yv12_to_nv12_avx512_base(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    const int crop_left   = crop[0];
+    const int crop_up     = crop[1];
+    const int crop_right  = crop[2];
+    const int crop_bottom = crop[3];
+    //Y成分のコピー
+    if (!uv_only) {
+        const auto y_range = thread_y_range(crop_up, height - crop_bottom, thread_id, thread_n);
+        uint8_t *srcYLine = (uint8_t *)src[0] + src_y_pitch_byte * y_range.start_src + crop_left;
+        uint8_t *dstLine = (uint8_t *)dst[0] + dst_y_pitch_byte * y_range.start_dst;
+        const int y_width = width - crop_right - crop_left;
+        for (int y = 0; y < y_range.len; y++, srcYLine += src_y_pitch_byte, dstLine += dst_y_pitch_byte) {
+            avx512_memcpy(dstLine, srcYLine, y_width);
+        }
+    }
+    //UV成分のコピー
+    const auto uv_range = thread_y_range(crop_up >> 1, (height - crop_bottom) >> 1, thread_id, thread_n);
+    uint8_t *srcULine = (uint8_t *)src[1] + ((src_uv_pitch_byte * uv_range.start_src) + (crop_left >> 1));
+    uint8_t *srcVLine = (uint8_t *)src[2] + ((src_uv_pitch_byte * uv_range.start_src) + (crop_left >> 1));
+    uint8_t *dstLine = (uint8_t *)dst[1] + dst_y_pitch_byte * uv_range.start_dst;
+    const int uv_width = (width - crop_right - crop_left + 1) >> 1;
+    const __m512i zIdxLo = _mm512_load_si512((const __m512i *)PERMUTE_UNPACK_LO_64);
+    const __m512i zIdxHi = _mm512_load_si512((const __m512i *)PERMUTE_UNPACK_HI_64);
+    for (int y = 0; y < uv_range.len; y++, srcULine += src_uv_pitch_byte, srcVLine += src_uv_pitch_byte, dstLine += dst_y_pitch_byte) {
+        for (int x = 0; x < uv_width; x += 64) {
+            const int n = uv_width - x;
+            const __mmask64 mask = mask64_remain(n);
+            __m512i z0 = _mm512_maskz_loadu_epi8(mask, srcULine + x);
+            __m512i z1 = _mm512_maskz_loadu_epi8(mask, srcVLine + x);
+
+            __m512i z2 = _mm512_unpackhi_epi8(z0, z1);
+            z0 = _mm512_unpacklo_epi8(z0, z1);
+
+            z1 = _mm512_permutex2var_epi64(z0, zIdxHi, z2);
+            z0 = _mm512_permutex2var_epi64(z0, zIdxLo, z2);
+
+            _mm512_mask_storeu_epi8(dstLine + x * 2 +  0, mask64_remain(n * 2),      z0);
+            _mm512_mask_storeu_epi8(dstLine + x * 2 + 64, mask64_remain(n * 2 - 64), z1);
+        }
+    }
+    _mm256_zeroupper();
+}
+
+void convert_yv12_to_nv12_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yv12_to_nv12_avx512_base<false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+
+void convert_uv_yv12_to_nv12_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yv12_to_nv12_avx512_base<true>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+
+template<bool uv_only>
+static void __forceinline convert_yv12_to_p010_avx512_base(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    const int crop_left   = crop[0];
+    const int crop_up     = crop[1];
+    const int crop_right  = crop[2];
+    const int crop_bottom = crop[3];
+    const __m512i zOffset = _mm512_set1_epi16(2 << 6);
+    //Y成分のコピー
+    if (!uv_only) {
+        const auto y_range = thread_y_range(crop_up, height - crop_bottom, thread_id, thread_n);
+        uint8_t *srcYLine = (uint8_t *)src[0] + src_y_pitch_byte * y_range.start_src + crop_left;
+        uint8_t *dstLine  = (uint8_t *)dst[0] + dst_y_pitch_byte * y_range.start_dst;
+        const int y_width = width - crop_right - crop_left;
+        for (int y = 0; y < y_range.len; y++, srcYLine += src_y_pitch_byte, dstLine += dst_y_pitch_byte) {
+            uint16_t *dst_ptr = (uint16_t *)dstLine;
+            for (int x = 0; x < y_width; x += 32) {
+                const __mmask32 mask = mask32_remain(y_width - x);
+                __m512i z0 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(mask, srcYLine + x));
+                z0 = _mm512_add_epi16(_mm512_slli_epi16(z0, 8), zOffset);
+                _mm512_mask_storeu_epi16(dst_ptr + x, mask, z0);
+            }
+        }
+    }
+    //UV成分のコピー
+    const auto uv_range = thread_y_range(crop_up >> 1, (height - crop_bottom) >> 1, thread_id, thread_n);
+    uint8_t *srcULine = (uint8_t *)src[1] + ((src_uv_pitch_byte * uv_range.start_src) + (crop_left >> 1));
+    uint8_t *srcVLine = (uint8_t *)src[2] + ((src_uv_pitch_byte * uv_range.start_src) + (crop_left >> 1));
+    uint8_t *dstLine  = (uint8_t *)dst[1] + dst_y_pitch_byte * uv_range.start_dst;
+    const int uv_width = (width - crop_right - crop_left + 1) >> 1;
+    for (int y = 0; y < uv_range.len; y++, srcULine += src_uv_pitch_byte, srcVLine += src_uv_pitch_byte, dstLine += dst_y_pitch_byte) {
+        uint16_t *dst_ptr = (uint16_t *)dstLine;
+        for (int x = 0; x < uv_width; x += 32) {
+            const int n = uv_width - x;
+            const __mmask32 mask = mask32_remain(n);
+            __m512i z0 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(mask, srcULine + x));
+            __m512i z1 = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(mask, srcVLine + x));
+            z0 = _mm512_add_epi16(_mm512_slli_epi16(z0, 8), zOffset);
+            z1 = _mm512_add_epi16(_mm512_slli_epi16(z1, 8), zOffset);
+            store_interleave_uv16_avx512(dst_ptr + x * 2, z0, z1, n);
+        }
+    }
+    _mm256_zeroupper();
+}
+
+void convert_yv12_to_p010_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yv12_to_p010_avx512_base<false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+
+//16bit x 64の輝度を8bitに変換して書き込む
+template<int in_bit_depth>
+static __forceinline void convert_y_high_to_8bit_line_avx512(uint8_t *dst_ptr, const uint16_t *src_ptr, int y_width) {
+    const __m512i zIdx = _mm512_load_si512((const __m512i *)PERMUTE_PACK_64);
+    for (int x = 0; x < y_width; x += 64) {
+        const int n = y_width - x;
+        __m512i z0 = _mm512_maskz_loadu_epi16(mask32_remain(n),      src_ptr + x +  0);
+        __m512i z1 = _mm512_maskz_loadu_epi16(mask32_remain(n - 32), src_ptr + x + 32);
+        z0 = _mm512_srli_epi16(z0, in_bit_depth - 8);
+        z1 = _mm512_srli_epi16(z1, in_bit_depth - 8);
+        z0 = _mm512_permutexvar_epi64(zIdx, _mm512_packus_epi16(z0, z1));
+        _mm512_mask_storeu_epi8(dst_ptr + x, mask64_remain(n), z0);
+    }
+}
+
+//16bitの輝度を16bitに変換して書き込む
+template<int in_bit_depth>
+static __forceinline void convert_y_high_to_16bit_line_avx512(uint16_t *dst_ptr, const uint16_t *src_ptr, int y_width) {
+    if (in_bit_depth == 16) {
+        avx512_memcpy((uint8_t *)dst_ptr, (const uint8_t *)src_ptr, y_width * (int)sizeof(uint16_t));
+    } else {
+        for (int x = 0; x < y_width; x += 32) {
+            const __mmask32 mask = mask32_remain(y_width - x);
+            __m512i z0 = _mm512_maskz_loadu_epi16(mask, src_ptr + x);
+            z0 = _mm512_slli_epi16(z0, 16 - in_bit_depth);
+            _mm512_mask_storeu_epi16(dst_ptr + x, mask, z0);
+        }
+    }
+}
+
+template<int in_bit_depth, bool uv_only>
+static void __forceinline convert_yv12_high_to_nv12_avx512_base(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    static_assert(8 < in_bit_depth && in_bit_depth <= 16, "in_bit_depth must be 9-16.");
+    const int crop_left   = crop[0];
+    const int crop_up     = crop[1];
+    const int crop_right  = crop[2];
+    const int crop_bottom = crop[3];
+    const int src_y_pitch = src_y_pitch_byte >> 1;
+    //Y成分のコピー
+    if (!uv_only) {
+        const auto y_range = thread_y_range(crop_up, height - crop_bottom, thread_id, thread_n);
+        uint16_t *srcYLine = (uint16_t *)src[0] + src_y_pitch * y_range.start_src + crop_left;
+        uint8_t *dstLine  = (uint8_t *)dst[0] + dst_y_pitch_byte * y_range.start_dst;
+        const int y_width = width - crop_right - crop_left;
+        for (int y = 0; y < y_range.len; y++, srcYLine += src_y_pitch, dstLine += dst_y_pitch_byte) {
+            convert_y_high_to_8bit_line_avx512<in_bit_depth>(dstLine, srcYLine, y_width);
+        }
+    }
+    //UV成分のコピー
+    const auto uv_range = thread_y_range(crop_up >> 1, (height - crop_bottom) >> 1, thread_id, thread_n);
+    const int src_uv_pitch = src_uv_pitch_byte >> 1;
+    uint16_t *srcULine = (uint16_t *)src[1] + ((src_uv_pitch * uv_range.start_src) + (crop_left >> 1));
+    uint16_t *srcVLine = (uint16_t *)src[2] + ((src_uv_pitch * uv_range.start_src) + (crop_left >> 1));
+    uint8_t *dstLine  = (uint8_t *)dst[1] + dst_y_pitch_byte * uv_range.start_dst;
+    const int uv_width = (width - crop_right - crop_left + 1) >> 1;
+    const __m512i zMaskHighByte = _mm512_set1_epi16((short)0xff00);
+    for (int y = 0; y < uv_range.len; y++, srcULine += src_uv_pitch, srcVLine += src_uv_pitch, dstLine += dst_y_pitch_byte) {
+        for (int x = 0; x < uv_width; x += 32) {
+            const __mmask32 mask = mask32_remain(uv_width - x);
+            __m512i z0 = _mm512_maskz_loadu_epi16(mask, srcULine + x);
+            __m512i z1 = _mm512_maskz_loadu_epi16(mask, srcVLine + x);
+
+            z0 = _mm512_srli_epi16(z0, in_bit_depth - 8);
+            z1 = _mm512_slli_epi16(z1, 16 - in_bit_depth);
+            z1 = _mm512_and_si512(z1, zMaskHighByte);
+
+            z0 = _mm512_or_si512(z0, z1);
+
+            _mm512_mask_storeu_epi16(dstLine + x * 2, mask, z0);
+        }
+    }
+    _mm256_zeroupper();
+}
+
+template<int in_bit_depth>
+void convert_yv12_high_to_nv12_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yv12_high_to_nv12_avx512_base<in_bit_depth, false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+CONVERT_CSP_INSTANTIATE_HIGHBIT(convert_yv12_high_to_nv12_avx512)
+
+template<int in_bit_depth, bool uv_only>
+static void __forceinline convert_yv12_high_to_p010_avx512_base(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    static_assert(8 < in_bit_depth && in_bit_depth <= 16, "in_bit_depth must be 9-16.");
+    const int crop_left   = crop[0];
+    const int crop_up     = crop[1];
+    const int crop_right  = crop[2];
+    const int crop_bottom = crop[3];
+    const int src_y_pitch = src_y_pitch_byte >> 1;
+    const int dst_y_pitch = dst_y_pitch_byte >> 1;
+    //Y成分のコピー
+    if (!uv_only) {
+        const auto y_range = thread_y_range(crop_up, height - crop_bottom, thread_id, thread_n);
+        uint16_t *srcYLine = (uint16_t *)src[0] + src_y_pitch * y_range.start_src + crop_left;
+        uint16_t *dstLine = (uint16_t *)dst[0] + dst_y_pitch * y_range.start_dst;
+        const int y_width = width - crop_right - crop_left;
+        for (int y = 0; y < y_range.len; y++, srcYLine += src_y_pitch, dstLine += dst_y_pitch) {
+            convert_y_high_to_16bit_line_avx512<in_bit_depth>(dstLine, srcYLine, y_width);
+        }
+    }
+    //UV成分のコピー
+    const auto uv_range = thread_y_range(crop_up >> 1, (height - crop_bottom) >> 1, thread_id, thread_n);
+    const int src_uv_pitch = src_uv_pitch_byte >> 1;
+    uint16_t *srcULine = (uint16_t *)src[1] + ((src_uv_pitch * uv_range.start_src) + (crop_left >> 1));
+    uint16_t *srcVLine = (uint16_t *)src[2] + ((src_uv_pitch * uv_range.start_src) + (crop_left >> 1));
+    uint16_t *dstLine = (uint16_t *)dst[1] + dst_y_pitch * uv_range.start_dst;
+    const int uv_width = (width - crop_right - crop_left + 1) >> 1;
+    for (int y = 0; y < uv_range.len; y++, srcULine += src_uv_pitch, srcVLine += src_uv_pitch, dstLine += dst_y_pitch) {
+        for (int x = 0; x < uv_width; x += 32) {
+            const int n = uv_width - x;
+            const __mmask32 mask = mask32_remain(n);
+            __m512i z0 = _mm512_maskz_loadu_epi16(mask, srcULine + x);
+            __m512i z1 = _mm512_maskz_loadu_epi16(mask, srcVLine + x);
+
+            if (in_bit_depth < 16) {
+                z0 = _mm512_slli_epi16(z0, 16 - in_bit_depth);
+                z1 = _mm512_slli_epi16(z1, 16 - in_bit_depth);
+            }
+            store_interleave_uv16_avx512(dstLine + x * 2, z0, z1, n);
+        }
+    }
+    _mm256_zeroupper();
+}
+
+template<int in_bit_depth>
+void convert_yv12_high_to_p010_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yv12_high_to_p010_avx512_base<in_bit_depth, false>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+CONVERT_CSP_INSTANTIATE_HIGHBIT(convert_yv12_high_to_p010_avx512)
+
+//16bit x 64の色差から偶数番目(左側の画素)を取り出す
+static __forceinline __m512i load_uv444_even_avx512(const uint16_t *ptr, int n) {
+    const __m512i z0 = _mm512_maskz_loadu_epi16(mask32_remain(n),      ptr +  0);
+    const __m512i z1 = _mm512_maskz_loadu_epi16(mask32_remain(n - 32), ptr + 32);
+    return _mm512_permutex2var_epi16(z0, _mm512_load_si512((const __m512i *)PERMUTE_EVEN_16), z1);
+}
+
+//(y0 + y1 + 1)を計算し、出力ビット深度に合わせる (convert_yuv444_to_nv12_p_cと同じ結果)
+template<int in_bit_depth, int out_bit_depth>
+static __forceinline __m512i yuv444_to_420_p_avx512(__m512i z0, __m512i z1) {
+    if (in_bit_depth == 16) {
+        //16bitでは加算でオーバーフローするので、avgで(y0 + y1 + 1) >> 1を計算する
+        const __m512i z = _mm512_avg_epu16(z0, z1);
+        return (out_bit_depth == 16) ? z : _mm512_srli_epi16(z, std::max(16 - out_bit_depth, 0));
+    }
+    __m512i z = _mm512_add_epi16(_mm512_add_epi16(z0, z1), _mm512_set1_epi16(1));
+    if (out_bit_depth > in_bit_depth + 1) {
+        z = _mm512_slli_epi16(z, std::max(out_bit_depth - in_bit_depth - 1, 0));
+    } else if (out_bit_depth < in_bit_depth + 1) {
+        z = _mm512_srli_epi16(z, std::max(in_bit_depth + 1 - out_bit_depth, 0));
+    }
+    return z;
+}
+
+//(y0 * 3 + y1 * 1 + 2)を計算し、出力ビット深度に合わせる (convert_yuv444_to_nv12_i_cと同じ結果)
+template<int in_bit_depth, int out_bit_depth>
+static __forceinline __m512i yuv444_to_420_i_avx512(__m512i z0_x3, __m512i z1_x1) {
+    if (in_bit_depth > 14) {
+        //16bitの範囲を超えるので32bitで計算する
+        const __m512i zOffset = _mm512_set1_epi32(2);
+        __m512i zLo = _mm512_add_epi32(_mm512_mullo_epi32(_mm512_cvtepu16_epi32(_mm512_castsi512_si256(z0_x3)), _mm512_set1_epi32(3)),
+                                       _mm512_cvtepu16_epi32(_mm512_castsi512_si256(z1_x1)));
+        __m512i zHi = _mm512_add_epi32(_mm512_mullo_epi32(_mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(z0_x3, 1)), _mm512_set1_epi32(3)),
+                                       _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(z1_x1, 1)));
+        zLo = _mm512_add_epi32(zLo, zOffset);
+        zHi = _mm512_add_epi32(zHi, zOffset);
+        if (out_bit_depth > in_bit_depth + 2) {
+            zLo = _mm512_slli_epi32(zLo, std::max(out_bit_depth - in_bit_depth - 2, 0));
+            zHi = _mm512_slli_epi32(zHi, std::max(out_bit_depth - in_bit_depth - 2, 0));
+        } else if (out_bit_depth < in_bit_depth + 2) {
+            zLo = _mm512_srli_epi32(zLo, std::max(in_bit_depth + 2 - out_bit_depth, 0));
+            zHi = _mm512_srli_epi32(zHi, std::max(in_bit_depth + 2 - out_bit_depth, 0));
+        }
+        return _mm512_inserti64x4(_mm512_castsi256_si512(_mm512_cvtepi32_epi16(zLo)), _mm512_cvtepi32_epi16(zHi), 1);
+    }
+    __m512i z = _mm512_add_epi16(_mm512_mullo_epi16(z0_x3, _mm512_set1_epi16(3)), z1_x1);
+    z = _mm512_add_epi16(z, _mm512_set1_epi16(2));
+    if (out_bit_depth > in_bit_depth + 2) {
+        z = _mm512_slli_epi16(z, std::max(out_bit_depth - in_bit_depth - 2, 0));
+    } else if (out_bit_depth < in_bit_depth + 2) {
+        z = _mm512_srli_epi16(z, std::max(in_bit_depth + 2 - out_bit_depth, 0));
+    }
+    return z;
+}
+
+//U, V(16bit x 32)を出力形式に合わせて書き込む
+template<int out_bit_depth>
+static __forceinline void store_uv_avx512(void *dst_ptr, __m512i u, __m512i v, int n) {
+    if (out_bit_depth == 8) {
+        //8bitに収まっているので、Vを上位バイトに移動してNV12の並びにする
+        const __m512i z = _mm512_or_si512(u, _mm512_slli_epi16(v, 8));
+        _mm512_mask_storeu_epi16(dst_ptr, mask32_remain(n), z);
+    } else {
+        store_interleave_uv16_avx512((uint16_t *)dst_ptr, u, v, n);
+    }
+}
+
+template<int in_bit_depth, typename Tout, int out_bit_depth>
+static void __forceinline convert_yuv444_high_to_nv12_p_avx512_base(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    static_assert(8 < in_bit_depth && in_bit_depth <= 16, "in_bit_depth must be 9-16.");
+    static_assert((sizeof(Tout) == 1 && out_bit_depth == 8) || (sizeof(Tout) == 2 && out_bit_depth == 16), "invalid output bit depth.");
+    const int crop_left   = crop[0];
+    const int crop_up     = crop[1];
+    const int crop_right  = crop[2];
+    const int crop_bottom = crop[3];
+    const int src_y_pitch = src_y_pitch_byte >> 1;
+    const int dst_y_pitch = dst_y_pitch_byte / sizeof(Tout);
+    const int y_width = width - crop_right - crop_left;
+    const auto y_range = thread_y_range(crop_up, height - crop_bottom, thread_id, thread_n);
+    //Y成分のコピー
+    uint16_t *srcYLine = (uint16_t *)src[0] + src_y_pitch * y_range.start_src + crop_left;
+    Tout *dstYLine = (Tout *)dst[0] + dst_y_pitch * y_range.start_dst;
+    for (int y = 0; y < y_range.len; y++, srcYLine += src_y_pitch, dstYLine += dst_y_pitch) {
+        if (out_bit_depth == 8) {
+            convert_y_high_to_8bit_line_avx512<in_bit_depth>((uint8_t *)dstYLine, srcYLine, y_width);
+        } else {
+            convert_y_high_to_16bit_line_avx512<in_bit_depth>((uint16_t *)dstYLine, srcYLine, y_width);
+        }
+    }
+    //UV成分のコピー
+    const int src_uv_pitch = src_uv_pitch_byte >> 1;
+    uint16_t *srcULine = (uint16_t *)src[1] + ((src_uv_pitch * y_range.start_src) + crop_left);
+    uint16_t *srcVLine = (uint16_t *)src[2] + ((src_uv_pitch * y_range.start_src) + crop_left);
+    Tout *dstLine = (Tout *)dst[1] + (dst_y_pitch >> 1) * y_range.start_dst;
+    for (int y = 0; y < y_range.len; y += 2, srcULine += src_uv_pitch * 2, srcVLine += src_uv_pitch * 2, dstLine += dst_y_pitch) {
+        for (int x = 0; x < y_width; x += 64) {
+            const int n = y_width - x;
+            const __m512i zU0 = load_uv444_even_avx512(srcULine + x + 0*src_uv_pitch, n);
+            const __m512i zU1 = load_uv444_even_avx512(srcULine + x + 1*src_uv_pitch, n);
+            const __m512i zV0 = load_uv444_even_avx512(srcVLine + x + 0*src_uv_pitch, n);
+            const __m512i zV1 = load_uv444_even_avx512(srcVLine + x + 1*src_uv_pitch, n);
+            const __m512i zU = yuv444_to_420_p_avx512<in_bit_depth, out_bit_depth>(zU0, zU1);
+            const __m512i zV = yuv444_to_420_p_avx512<in_bit_depth, out_bit_depth>(zV0, zV1);
+            store_uv_avx512<out_bit_depth>(dstLine + x, zU, zV, (n + 1) >> 1);
+        }
+    }
+    _mm256_zeroupper();
+}
+
+template<int in_bit_depth, typename Tout, int out_bit_depth>
+static void __forceinline convert_yuv444_high_to_nv12_i_avx512_base(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    static_assert(8 < in_bit_depth && in_bit_depth <= 16, "in_bit_depth must be 9-16.");
+    static_assert((sizeof(Tout) == 1 && out_bit_depth == 8) || (sizeof(Tout) == 2 && out_bit_depth == 16), "invalid output bit depth.");
+    const int crop_left   = crop[0];
+    const int crop_up     = crop[1];
+    const int crop_right  = crop[2];
+    const int crop_bottom = crop[3];
+    const int src_y_pitch = src_y_pitch_byte >> 1;
+    const int dst_y_pitch = dst_y_pitch_byte / sizeof(Tout);
+    const int y_width = width - crop_right - crop_left;
+    const auto y_range = thread_y_range(crop_up, height - crop_bottom, thread_id, thread_n);
+    //Y成分のコピー
+    uint16_t *srcYLine = (uint16_t *)src[0] + src_y_pitch * y_range.start_src + crop_left;
+    Tout *dstYLine = (Tout *)dst[0] + dst_y_pitch * y_range.start_dst;
+    for (int y = 0; y < y_range.len; y++, srcYLine += src_y_pitch, dstYLine += dst_y_pitch) {
+        if (out_bit_depth == 8) {
+            convert_y_high_to_8bit_line_avx512<in_bit_depth>((uint8_t *)dstYLine, srcYLine, y_width);
+        } else {
+            convert_y_high_to_16bit_line_avx512<in_bit_depth>((uint16_t *)dstYLine, srcYLine, y_width);
+        }
+    }
+    //UV成分のコピー
+    const int src_uv_pitch = src_uv_pitch_byte >> 1;
+    uint16_t *srcULine = (uint16_t *)src[1] + ((src_uv_pitch * y_range.start_src) + crop_left);
+    uint16_t *srcVLine = (uint16_t *)src[2] + ((src_uv_pitch * y_range.start_src) + crop_left);
+    Tout *dstLine = (Tout *)dst[1] + (dst_y_pitch >> 1) * y_range.start_dst;
+    for (int y = 0; y < y_range.len; y += 4, srcULine += src_uv_pitch * 4, srcVLine += src_uv_pitch * 4, dstLine += dst_y_pitch * 2) {
+        for (int x = 0; x < y_width; x += 64) {
+            const int n = y_width - x;
+            const __m512i zU0 = load_uv444_even_avx512(srcULine + x + 0*src_uv_pitch, n);
+            const __m512i zU1 = load_uv444_even_avx512(srcULine + x + 1*src_uv_pitch, n);
+            const __m512i zU2 = load_uv444_even_avx512(srcULine + x + 2*src_uv_pitch, n);
+            const __m512i zU3 = load_uv444_even_avx512(srcULine + x + 3*src_uv_pitch, n);
+            const __m512i zV0 = load_uv444_even_avx512(srcVLine + x + 0*src_uv_pitch, n);
+            const __m512i zV1 = load_uv444_even_avx512(srcVLine + x + 1*src_uv_pitch, n);
+            const __m512i zV2 = load_uv444_even_avx512(srcVLine + x + 2*src_uv_pitch, n);
+            const __m512i zV3 = load_uv444_even_avx512(srcVLine + x + 3*src_uv_pitch, n);
+            const __m512i zUy0 = yuv444_to_420_i_avx512<in_bit_depth, out_bit_depth>(zU0, zU2);
+            const __m512i zVy0 = yuv444_to_420_i_avx512<in_bit_depth, out_bit_depth>(zV0, zV2);
+            const __m512i zUy1 = yuv444_to_420_i_avx512<in_bit_depth, out_bit_depth>(zU3, zU1);
+            const __m512i zVy1 = yuv444_to_420_i_avx512<in_bit_depth, out_bit_depth>(zV3, zV1);
+            store_uv_avx512<out_bit_depth>(dstLine + x + 0*dst_y_pitch, zUy0, zVy0, (n + 1) >> 1);
+            store_uv_avx512<out_bit_depth>(dstLine + x + 1*dst_y_pitch, zUy1, zVy1, (n + 1) >> 1);
+        }
+    }
+    _mm256_zeroupper();
+}
+#pragma warning (pop)
+
+template<int in_bit_depth>
+void convert_yuv444_high_to_nv12_p_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yuv444_high_to_nv12_p_avx512_base<in_bit_depth, uint8_t, 8>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+CONVERT_CSP_INSTANTIATE_HIGHBIT(convert_yuv444_high_to_nv12_p_avx512)
+
+template<int in_bit_depth>
+void convert_yuv444_high_to_nv12_i_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yuv444_high_to_nv12_i_avx512_base<in_bit_depth, uint8_t, 8>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+CONVERT_CSP_INSTANTIATE_HIGHBIT(convert_yuv444_high_to_nv12_i_avx512)
+
+template<int in_bit_depth>
+void convert_yuv444_high_to_p010_p_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yuv444_high_to_nv12_p_avx512_base<in_bit_depth, uint16_t, 16>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+CONVERT_CSP_INSTANTIATE_HIGHBIT(convert_yuv444_high_to_p010_p_avx512)
+
+template<int in_bit_depth>
+void convert_yuv444_high_to_p010_i_avx512(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    convert_yuv444_high_to_nv12_i_avx512_base<in_bit_depth, uint16_t, 16>(dst, src, width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte, height, dst_height, thread_id, thread_n, crop);
+}
+CONVERT_CSP_INSTANTIATE_HIGHBIT(convert_yuv444_high_to_p010_i_avx512)
+
+#endif //#if (defined(_MSC_VER) && _MSC_VER >= 1911) || (defined(__AVX512BW__) && defined(__AVX512VL__))
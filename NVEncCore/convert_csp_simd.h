@@ -40,6 +40,7 @@
 #include "convert_csp.h"
 #include "convert_const.h"
 #include <utility>
+#include <algorithm>
 
 static void __forceinline memcpy_sse(uint8_t *dst, const uint8_t *src, int size) {
     if (size < 64) {
@@ -1127,7 +1128,7 @@ static void __forceinline convert_yuv422_to_p210_simd(void **dst, const void **s
         uint8_t *src_v_ptr = srcVLine;
         uint16_t *dst_ptr = dstLine;
         __m128i x0, x1, x2, x3, x4;
-        for (int x = crop_left; x < x_fin; x += 16, src_u_ptr += 16, src_v_ptr += 16, dst_ptr += 32) {
+        for (int x = crop_left; x < x_fin; x += 32, src_u_ptr += 16, src_v_ptr += 16, dst_ptr += 32) {
             x0 = _mm_loadu_si128((const __m128i *)src_u_ptr);
             x1 = _mm_loadu_si128((const __m128i *)src_v_ptr);
             x2 = _mm_unpackhi_epi8(_mm_setzero_si128(), x0);
@@ -1306,6 +1307,190 @@ static void __forceinline convert_yuv444_high_to_yuv444_simd(void **dst, const v
     }
 }
 
+#if USE_SSE41
+//横方向16画素分を読み込み、偶数番目(左側)の画素を16bit x 8として返す
+template<typename Tin>
+static __forceinline __m128i load_yuv444_uv_even_simd(const Tin *ptr) {
+    if (sizeof(Tin) == 1) {
+        return _mm_and_si128(_mm_loadu_si128((const __m128i *)ptr), _mm_set1_epi16(0x00ff));
+    } else {
+        const __m128i xMask = _mm_set1_epi32(0x0000ffff);
+        __m128i x0 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(ptr + 0)), xMask);
+        __m128i x1 = _mm_and_si128(_mm_loadu_si128((const __m128i *)(ptr + 8)), xMask);
+        return _mm_packus_epi32(x0, x1);
+    }
+}
+
+//(y0 + y1 + 1)を計算し、出力ビット深度に合わせる (convert_yuv444_to_nv12_p_cと同じ結果)
+template<int in_bit_depth, int out_bit_depth>
+static __forceinline __m128i yuv444_to_420_p_simd(__m128i x0, __m128i x1) {
+    if (in_bit_depth == 16) {
+        //16bitでは加算でオーバーフローするので、avgで(y0 + y1 + 1) >> 1を計算する
+        const __m128i x = _mm_avg_epu16(x0, x1);
+        return (out_bit_depth == 16) ? x : _mm_srli_epi16(x, std::max(16 - out_bit_depth, 0));
+    }
+    __m128i x = _mm_add_epi16(_mm_add_epi16(x0, x1), _mm_set1_epi16(1));
+    if (out_bit_depth > in_bit_depth + 1) {
+        x = _mm_slli_epi16(x, std::max(out_bit_depth - in_bit_depth - 1, 0));
+    } else if (out_bit_depth < in_bit_depth + 1) {
+        x = _mm_srli_epi16(x, std::max(in_bit_depth + 1 - out_bit_depth, 0));
+    }
+    return x;
+}
+
+//(y0 * 3 + y1 * 1 + 2)を計算し、出力ビット深度に合わせる (convert_yuv444_to_nv12_i_cと同じ結果)
+template<int in_bit_depth, int out_bit_depth>
+static __forceinline __m128i yuv444_to_420_i_simd(__m128i x0_x3, __m128i x1_x1) {
+    if (in_bit_depth > 14) {
+        //16bitの範囲を超えるので32bitで計算する
+        const __m128i xOffset = _mm_set1_epi32(2);
+        const __m128i xMul3 = _mm_set1_epi32(3);
+        __m128i xLo = _mm_add_epi32(_mm_mullo_epi32(_mm_cvtepu16_epi32(x0_x3), xMul3), _mm_cvtepu16_epi32(x1_x1));
+        __m128i xHi = _mm_add_epi32(_mm_mullo_epi32(_mm_cvtepu16_epi32(_mm_srli_si128(x0_x3, 8)), xMul3), _mm_cvtepu16_epi32(_mm_srli_si128(x1_x1, 8)));
+        xLo = _mm_add_epi32(xLo, xOffset);
+        xHi = _mm_add_epi32(xHi, xOffset);
+        if (out_bit_depth > in_bit_depth + 2) {
+            xLo = _mm_slli_epi32(xLo, std::max(out_bit_depth - in_bit_depth - 2, 0));
+            xHi = _mm_slli_epi32(xHi, std::max(out_bit_depth - in_bit_depth - 2, 0));
+        } else if (out_bit_depth < in_bit_depth + 2) {
+            xLo = _mm_srli_epi32(xLo, std::max(in_bit_depth + 2 - out_bit_depth, 0));
+            xHi = _mm_srli_epi32(xHi, std::max(in_bit_depth + 2 - out_bit_depth, 0));
+        }
+        return _mm_packus_epi32(xLo, xHi);
+    }
+    __m128i x = _mm_add_epi16(_mm_mullo_epi16(x0_x3, _mm_set1_epi16(3)), x1_x1);
+    x = _mm_add_epi16(x, _mm_set1_epi16(2));
+    if (out_bit_depth > in_bit_depth + 2) {
+        x = _mm_slli_epi16(x, std::max(out_bit_depth - in_bit_depth - 2, 0));
+    } else if (out_bit_depth < in_bit_depth + 2) {
+        x = _mm_srli_epi16(x, std::max(in_bit_depth + 2 - out_bit_depth, 0));
+    }
+    return x;
+}
+
+//U, V(16bit x 8)を出力形式に合わせて書き込む
+template<int out_bit_depth>
+static __forceinline void store_yuv444_uv_simd(void *dst_ptr, __m128i xU, __m128i xV) {
+    if (out_bit_depth == 8) {
+        //8bitに収まっているので、Vを上位バイトに移動してNV12の並びにする
+        _mm_storeu_si128((__m128i *)dst_ptr, _mm_or_si128(xU, _mm_slli_epi16(xV, 8)));
+    } else {
+        _mm_storeu_si128((__m128i *)dst_ptr + 0, _mm_unpacklo_epi16(xU, xV));
+        _mm_storeu_si128((__m128i *)dst_ptr + 1, _mm_unpackhi_epi16(xU, xV));
+    }
+}
+
+//輝度を出力ビット深度に合わせてコピーする
+template<typename Tin, int in_bit_depth, typename Tout, int out_bit_depth>
+static __forceinline void convert_yuv444_y_line_simd(Tout *dstLine, const Tin *srcLine, int y_width) {
+    if (in_bit_depth == out_bit_depth && sizeof(Tin) == sizeof(Tout)) {
+        memcpy_sse((uint8_t *)dstLine, (const uint8_t *)srcLine, y_width * (int)sizeof(Tin));
+    } else if (sizeof(Tin) == 1) {
+        //8bit -> 16bit
+        for (int x = 0; x < y_width; x += 16) {
+            __m128i x0 = _mm_loadu_si128((const __m128i *)((const uint8_t *)srcLine + x));
+            _mm_storeu_si128((__m128i *)((uint16_t *)dstLine + x + 0), _mm_unpacklo_epi8(_mm_setzero_si128(), x0));
+            _mm_storeu_si128((__m128i *)((uint16_t *)dstLine + x + 8), _mm_unpackhi_epi8(_mm_setzero_si128(), x0));
+        }
+    } else if (sizeof(Tout) == 1) {
+        //high bit depth -> 8bit
+        for (int x = 0; x < y_width; x += 16) {
+            __m128i x0 = _mm_loadu_si128((const __m128i *)((const uint16_t *)srcLine + x + 0));
+            __m128i x1 = _mm_loadu_si128((const __m128i *)((const uint16_t *)srcLine + x + 8));
+            x0 = _mm_srli_epi16(x0, std::max(in_bit_depth - 8, 0));
+            x1 = _mm_srli_epi16(x1, std::max(in_bit_depth - 8, 0));
+            _mm_storeu_si128((__m128i *)((uint8_t *)dstLine + x), _mm_packus_epi16(x0, x1));
+        }
+    } else {
+        //high bit depth -> 16bit
+        for (int x = 0; x < y_width; x += 8) {
+            __m128i x0 = _mm_loadu_si128((const __m128i *)((const uint16_t *)srcLine + x));
+            x0 = _mm_slli_epi16(x0, std::max(out_bit_depth - in_bit_depth, 0));
+            _mm_storeu_si128((__m128i *)((uint16_t *)dstLine + x), x0);
+        }
+    }
+}
+
+template<typename Tin, int in_bit_depth, typename Tout, int out_bit_depth>
+static void __forceinline convert_yuv444_to_nv12_p_simd(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    static_assert((sizeof(Tin)  == 1 && in_bit_depth  == 8) || (sizeof(Tin)  == 2 && 8 < in_bit_depth  && in_bit_depth  <= 16), "invalid input bit depth.");
+    static_assert((sizeof(Tout) == 1 && out_bit_depth == 8) || (sizeof(Tout) == 2 && out_bit_depth == 16), "invalid output bit depth.");
+    const int crop_left   = crop[0];
+    const int crop_up     = crop[1];
+    const int crop_right  = crop[2];
+    const int crop_bottom = crop[3];
+    const int src_y_pitch = src_y_pitch_byte / sizeof(Tin);
+    const int dst_y_pitch = dst_y_pitch_byte / sizeof(Tout);
+    const int y_width = width - crop_right - crop_left;
+    const auto y_range = thread_y_range(crop_up, height - crop_bottom, thread_id, thread_n);
+    //Y成分のコピー
+    Tin *srcYLine = (Tin *)src[0] + src_y_pitch * y_range.start_src + crop_left;
+    Tout *dstYLine = (Tout *)dst[0] + dst_y_pitch * y_range.start_dst;
+    for (int y = 0; y < y_range.len; y++, srcYLine += src_y_pitch, dstYLine += dst_y_pitch) {
+        convert_yuv444_y_line_simd<Tin, in_bit_depth, Tout, out_bit_depth>(dstYLine, srcYLine, y_width);
+    }
+    //UV成分のコピー
+    const int src_uv_pitch = src_uv_pitch_byte / sizeof(Tin);
+    Tin *srcULine = (Tin *)src[1] + ((src_uv_pitch * y_range.start_src) + crop_left);
+    Tin *srcVLine = (Tin *)src[2] + ((src_uv_pitch * y_range.start_src) + crop_left);
+    Tout *dstLine = (Tout *)dst[1] + (dst_y_pitch >> 1) * y_range.start_dst;
+    for (int y = 0; y < y_range.len; y += 2, srcULine += src_uv_pitch * 2, srcVLine += src_uv_pitch * 2, dstLine += dst_y_pitch) {
+        for (int x = 0; x < y_width; x += 16) {
+            __m128i xU0 = load_yuv444_uv_even_simd(srcULine + x + 0*src_uv_pitch);
+            __m128i xU1 = load_yuv444_uv_even_simd(srcULine + x + 1*src_uv_pitch);
+            __m128i xV0 = load_yuv444_uv_even_simd(srcVLine + x + 0*src_uv_pitch);
+            __m128i xV1 = load_yuv444_uv_even_simd(srcVLine + x + 1*src_uv_pitch);
+            __m128i xU = yuv444_to_420_p_simd<in_bit_depth, out_bit_depth>(xU0, xU1);
+            __m128i xV = yuv444_to_420_p_simd<in_bit_depth, out_bit_depth>(xV0, xV1);
+            store_yuv444_uv_simd<out_bit_depth>(dstLine + x, xU, xV);
+        }
+    }
+}
+
+template<typename Tin, int in_bit_depth, typename Tout, int out_bit_depth>
+static void __forceinline convert_yuv444_to_nv12_i_simd(void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int thread_id, int thread_n, int *crop) {
+    static_assert((sizeof(Tin)  == 1 && in_bit_depth  == 8) || (sizeof(Tin)  == 2 && 8 < in_bit_depth  && in_bit_depth  <= 16), "invalid input bit depth.");
+    static_assert((sizeof(Tout) == 1 && out_bit_depth == 8) || (sizeof(Tout) == 2 && out_bit_depth == 16), "invalid output bit depth.");
+    const int crop_left   = crop[0];
+    const int crop_up     = crop[1];
+    const int crop_right  = crop[2];
+    const int crop_bottom = crop[3];
+    const int src_y_pitch = src_y_pitch_byte / sizeof(Tin);
+    const int dst_y_pitch = dst_y_pitch_byte / sizeof(Tout);
+    const int y_width = width - crop_right - crop_left;
+    const auto y_range = thread_y_range(crop_up, height - crop_bottom, thread_id, thread_n);
+    //Y成分のコピー
+    Tin *srcYLine = (Tin *)src[0] + src_y_pitch * y_range.start_src + crop_left;
+    Tout *dstYLine = (Tout *)dst[0] + dst_y_pitch * y_range.start_dst;
+    for (int y = 0; y < y_range.len; y++, srcYLine += src_y_pitch, dstYLine += dst_y_pitch) {
+        convert_yuv444_y_line_simd<Tin, in_bit_depth, Tout, out_bit_depth>(dstYLine, srcYLine, y_width);
+    }
+    //UV成分のコピー
+    const int src_uv_pitch = src_uv_pitch_byte / sizeof(Tin);
+    Tin *srcULine = (Tin *)src[1] + ((src_uv_pitch * y_range.start_src) + crop_left);
+    Tin *srcVLine = (Tin *)src[2] + ((src_uv_pitch * y_range.start_src) + crop_left);
+    Tout *dstLine = (Tout *)dst[1] + (dst_y_pitch >> 1) * y_range.start_dst;
+    for (int y = 0; y < y_range.len; y += 4, srcULine += src_uv_pitch * 4, srcVLine += src_uv_pitch * 4, dstLine += dst_y_pitch * 2) {
+        for (int x = 0; x < y_width; x += 16) {
+            __m128i xU0 = load_yuv444_uv_even_simd(srcULine + x + 0*src_uv_pitch);
+            __m128i xU1 = load_yuv444_uv_even_simd(srcULine + x + 1*src_uv_pitch);
+            __m128i xU2 = load_yuv444_uv_even_simd(srcULine + x + 2*src_uv_pitch);
+            __m128i xU3 = load_yuv444_uv_even_simd(srcULine + x + 3*src_uv_pitch);
+            __m128i xV0 = load_yuv444_uv_even_simd(srcVLine + x + 0*src_uv_pitch);
+            __m128i xV1 = load_yuv444_uv_even_simd(srcVLine + x + 1*src_uv_pitch);
+            __m128i xV2 = load_yuv444_uv_even_simd(srcVLine + x + 2*src_uv_pitch);
+            __m128i xV3 = load_yuv444_uv_even_simd(srcVLine + x + 3*src_uv_pitch);
+            store_yuv444_uv_simd<out_bit_depth>(dstLine + x + 0*dst_y_pitch,
+                yuv444_to_420_i_simd<in_bit_depth, out_bit_depth>(xU0, xU2),
+                yuv444_to_420_i_simd<in_bit_depth, out_bit_depth>(xV0, xV2));
+            store_yuv444_uv_simd<out_bit_depth>(dstLine + x + 1*dst_y_pitch,
+                yuv444_to_420_i_simd<in_bit_depth, out_bit_depth>(xU3, xU1),
+                yuv444_to_420_i_simd<in_bit_depth, out_bit_depth>(xV3, xV1));
+        }
+    }
+}
+#endif //#if USE_SSE41
+
 typedef    struct {
     short    y;                    //    画素(輝度    )データ (     0 ～ 4096 )
     short    cb;                    //    画素(色差(青))データ ( -2048 ～ 2048 )
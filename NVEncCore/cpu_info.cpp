@@ -222,7 +222,84 @@ bool get_cpu_info(cpu_info_t *cpu_info) {
     return true;
 }
 
+int get_cpu_logical_processors(cpu_logical_processor_t *list, int list_size) {
+    if (nullptr == list || list_size <= 0)
+        return 0;
+
+    LPFN_GLPI glpi = (LPFN_GLPI)GetProcAddress(GetModuleHandle(_T("kernel32")), "GetLogicalProcessorInformation");
+    if (nullptr == glpi)
+        return 0;
+
+    DWORD returnLength = 0;
+    glpi(nullptr, &returnLength);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || returnLength == 0)
+        return 0;
+    std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> buffer(returnLength / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION) + 1);
+    if (FALSE == glpi(buffer.data(), &returnLength))
+        return 0;
+    const size_t entries = returnLength / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION);
+
+    //プロセッサグループ0 (最大64論理プロセッサ) のみを対象とする
+    int count = 0;
+    uint32_t core = 0;
+    for (size_t i = 0; i < entries; i++) {
+        if (buffer[i].Relationship != RelationProcessorCore)
+            continue;
+        uint32_t smt = 0;
+        for (uint32_t id = 0; id < sizeof(ULONG_PTR) * 8; id++) {
+            if ((buffer[i].ProcessorMask & ((ULONG_PTR)1 << id)) && count < list_size) {
+                list[count].id = id;
+                list[count].core = core;
+                list[count].node = 0;
+                list[count].smt = smt++;
+                count++;
+            }
+        }
+        core++;
+    }
+    for (size_t i = 0; i < entries; i++) {
+        if (buffer[i].Relationship != RelationNumaNode)
+            continue;
+        for (int j = 0; j < count; j++) {
+            if (buffer[i].ProcessorMask & ((ULONG_PTR)1 << list[j].id)) {
+                list[j].node = buffer[i].NumaNode.NodeNumber;
+            }
+        }
+    }
+    return count;
+}
+
 #else //#if defined(_WIN32) || defined(_WIN64)
+#include <unistd.h>
+
+static bool read_sysfs_str(const std::string& path, std::string& str) {
+    std::ifstream ifs(path);
+    if (!ifs)
+        return false;
+    std::getline(ifs, str);
+    return true;
+}
+
+static bool read_sysfs_int(const std::string& path, int *value) {
+    std::string str;
+    return read_sysfs_str(path, str) && 1 == sscanf(str.c_str(), "%d", value);
+}
+
+//"0-3,8-11" のような形式のcpuリストに含まれるcpu数を返す
+static int sysfs_cpulist_count(const std::string& cpulist) {
+    int count = 0;
+    for (const auto& range : split(cpulist, ",")) {
+        int start = 0, fin = 0;
+        const int ret = sscanf(range.c_str(), "%d-%d", &start, &fin);
+        if (ret == 2) {
+            count += fin - start + 1;
+        } else if (ret == 1) {
+            count++;
+        }
+    }
+    return count;
+}
+
 bool get_cpu_info(cpu_info_t *cpu_info) {
     memset(cpu_info, 0, sizeof(cpu_info[0]));
     std::ifstream inputFile("/proc/cpuinfo");
@@ -257,8 +334,79 @@ bool get_cpu_info(cpu_info_t *cpu_info) {
             continue;
         }
     }
+    //キャッシュの情報はsysfsから取得する
+    //Windows版と同様に、sizeは同じレベルのキャッシュすべての合計とする
+    for (int index = 0; ; index++) {
+        const std::string cache_dir = strsprintf("/sys/devices/system/cpu/cpu0/cache/index%d/", index);
+        int level = 0;
+        if (!read_sysfs_int(cache_dir + "level", &level))
+            break;
+        if (level < 1 || _countof(cpu_info->caches) < level)
+            continue;
+        std::string str;
+        int size = 0;
+        char unit = 'K';
+        if (!read_sysfs_str(cache_dir + "size", str) || 1 > sscanf(str.c_str(), "%d%c", &size, &unit))
+            continue;
+        size *= (unit == 'M') ? 1024 * 1024 : ((unit == 'K') ? 1024 : 1);
+        int shared = 1;
+        if (read_sysfs_str(cache_dir + "shared_cpu_list", str))
+            shared = (std::max)(sysfs_cpulist_count(str), 1);
+        const uint32_t count = (std::max)(cpu_info->logical_cores / shared, 1u);
+        int linesize = 0, associativity = 0;
+        read_sysfs_int(cache_dir + "coherency_line_size", &linesize);
+        read_sysfs_int(cache_dir + "ways_of_associativity", &associativity);
+        int type = 0; //CacheUnified
+        if (read_sysfs_str(cache_dir + "type", str))
+            type = (str == "Instruction") ? 1 : ((str == "Data") ? 2 : 0);
+
+        cache_info_t *cache = &cpu_info->caches[level-1];
+        cache->count += count;
+        cache->level = level;
+        cache->linesize = linesize;
+        cache->size += size * count;
+        cache->associativity = associativity;
+        cache->type = type;
+        cpu_info->max_cache_level = (std::max)(cpu_info->max_cache_level, cache->level);
+    }
     return true;
 }
+
+int get_cpu_logical_processors(cpu_logical_processor_t *list, int list_size) {
+    if (nullptr == list || list_size <= 0)
+        return 0;
+
+    const int logical_cores = (int)std::thread::hardware_concurrency();
+    std::vector<std::pair<int, int>> core_list; //(physical_package_id, core_id)
+    std::vector<int> core_smt;
+    int count = 0;
+    for (int id = 0; id < logical_cores && count < list_size; id++) {
+        const std::string cpu_dir = strsprintf("/sys/devices/system/cpu/cpu%d/", id);
+        int package_id = 0, core_id = id;
+        read_sysfs_int(cpu_dir + "topology/physical_package_id", &package_id);
+        read_sysfs_int(cpu_dir + "topology/core_id", &core_id);
+        const auto key = std::make_pair(package_id, core_id);
+        auto it = std::find(core_list.begin(), core_list.end(), key);
+        const int core = (int)(it - core_list.begin());
+        if (it == core_list.end()) {
+            core_list.push_back(key);
+            core_smt.push_back(0);
+        }
+        int node = 0;
+        for (int inode = 0; inode < 256; inode++) {
+            if (access(strsprintf("%snode%d", cpu_dir.c_str(), inode).c_str(), F_OK) == 0) {
+                node = inode;
+                break;
+            }
+        }
+        list[count].id = id;
+        list[count].core = core;
+        list[count].node = node;
+        list[count].smt = core_smt[core]++;
+        count++;
+    }
+    return count;
+}
 #endif //#if defined(_WIN32) || defined(_WIN64)
 
 cpu_info_t get_cpu_info() {
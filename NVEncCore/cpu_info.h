@@ -55,6 +55,17 @@ int getCPUName(char *buffer, size_t nSize);
 bool get_cpu_info(cpu_info_t *cpu_info);
 cpu_info_t get_cpu_info();
 
+//論理プロセッサごとの物理コア・NUMAノードの情報
+typedef struct {
+    uint32_t id;   //論理プロセッサの番号
+    uint32_t core; //物理コアの番号
+    uint32_t node; //NUMAノードの番号
+    uint32_t smt;  //物理コア内での番号 (HTT/SMT)
+} cpu_logical_processor_t;
+
+//論理プロセッサの情報をlistに格納し、その数を返す
+int get_cpu_logical_processors(cpu_logical_processor_t *list, int list_size);
+
 int getCPUInfo(TCHAR *buffer, size_t nSize);
 
 template <size_t size>
@@ -27,22 +27,230 @@
 
 #include <regex>
 #include "rgy_util.h"
+#include <emmintrin.h>
 #include "rgy_bitstream.h"
 #include "rgy_util.h"
+#include "rgy_simd.h"
 
 std::vector<uint8_t> unnal(const uint8_t *ptr, size_t len) {
-    std::vector<uint8_t> data;
-    data.reserve(len);
-    data.push_back(ptr[0]);
-    data.push_back(ptr[1]);
-    for (size_t i = 2; i < len; i++) {
-        if (ptr[i-2] == 0x00 && ptr[i-1] == 0x00 && ptr[i] == 0x03) {
-            //skip
+    std::vector<uint8_t> data(len);
+    data.resize(unnal(data.data(), ptr, len));
+    return data;
+}
+
+size_t unnal(uint8_t *dst, const uint8_t *src, size_t len) {
+    static const auto find_emulation_prevention_byte = get_find_emulation_prevention_byte_func();
+    size_t dst_size = 0;
+    for (size_t i = 0; i < len; ) {
+        //次のemulation prevention byteの直前までをまとめてコピーし、03を読み飛ばす
+        const size_t pos = i + find_emulation_prevention_byte(src + i, len - i);
+        const size_t copy_fin = std::min(pos + 2, len);
+        if (dst + dst_size != src + i) {
+            memmove(dst + dst_size, src + i, copy_fin - i);
+        }
+        dst_size += copy_fin - i;
+        i = copy_fin + 1;
+    }
+    return dst_size;
+}
+
+void renal(std::vector<uint8_t>& dst, const uint8_t *src, size_t len) {
+    static const auto find_emulation_prevention_target = get_find_emulation_prevention_target_func();
+    //emulation prevention byteは最大で2byteごとに1つ
+    const size_t required = dst.size() + len + len / 2 + 1;
+    if (dst.capacity() < required) {
+        dst.reserve(std::max(required, dst.capacity() * 2));
+    }
+    for (size_t i = 0; i < len; ) {
+        //00 00の直後に03を挿入し、挿入した位置の次のバイトから再び検索する
+        const size_t pos = i + find_emulation_prevention_target(src + i, len - i);
+        const size_t copy_fin = std::min(pos + 2, len);
+        dst.insert(dst.end(), src + i, src + copy_fin);
+        if (copy_fin < len) {
+            dst.push_back(0x03);
+        }
+        i = copy_fin;
+    }
+    //末尾が00の場合は03を追加する
+    if (len > 0 && src[len-1] == 0x00) {
+        dst.push_back(0x03);
+    }
+}
+
+//00 00 xx を検索する
+//targetがtrueなら xx <= 03 (emulation prevention byteの挿入が必要な位置)、falseなら xx == 03 (emulation prevention byte)
+template<bool target>
+static size_t find_emulation_prevention_c_base(const uint8_t *data, size_t size) {
+    if (size < 3) {
+        return size;
+    }
+    const size_t i_fin = size - 2;
+    for (size_t i = 0; i < i_fin; ) {
+        const uint8_t c = data[i+2];
+        if (c > 3) {
+            //data[i+2]が0でも3以下でもなければ、i, i+1, i+2のどれも該当しない
+            i += 3;
+        } else if (data[i] == 0 && data[i+1] == 0 && (target || c == 3)) {
+            return i;
+        } else if (c == 0) {
+            i++;
         } else {
-            data.push_back(ptr[i]);
+            i += 3;
         }
     }
-    return data;
+    return size;
+}
+
+template<bool target>
+static size_t find_emulation_prevention_sse2_base(const uint8_t *data, size_t size) {
+    size_t i = 0;
+    if (size >= 16 + 2) {
+        const __m128i xZero = _mm_setzero_si128();
+        const __m128i xThree = _mm_set1_epi8(3);
+        for (; i + 16 + 2 <= size; i += 16) {
+            __m128i x0 = _mm_loadu_si128((const __m128i *)(data + i + 0));
+            __m128i x1 = _mm_loadu_si128((const __m128i *)(data + i + 1));
+            __m128i x2 = _mm_loadu_si128((const __m128i *)(data + i + 2));
+            __m128i x2Match = (target) ? _mm_cmpeq_epi8(_mm_min_epu8(x2, xThree), x2) : _mm_cmpeq_epi8(x2, xThree);
+            __m128i xMatch = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(x0, xZero), _mm_cmpeq_epi8(x1, xZero)), x2Match);
+            const uint32_t mask = (uint32_t)_mm_movemask_epi8(xMatch);
+            if (mask) {
+                return i + ctz32(mask);
+            }
+        }
+    }
+    return i + find_emulation_prevention_c_base<target>(data + i, size - i);
+}
+
+size_t find_emulation_prevention_byte_c(const uint8_t *data, size_t size) {
+    return find_emulation_prevention_c_base<false>(data, size);
+}
+
+size_t find_emulation_prevention_byte_sse2(const uint8_t *data, size_t size) {
+    return find_emulation_prevention_sse2_base<false>(data, size);
+}
+
+size_t find_emulation_prevention_target_c(const uint8_t *data, size_t size) {
+    return find_emulation_prevention_c_base<true>(data, size);
+}
+
+size_t find_emulation_prevention_target_sse2(const uint8_t *data, size_t size) {
+    return find_emulation_prevention_sse2_base<true>(data, size);
+}
+
+size_t find_start_code_c(const uint8_t *data, size_t size) {
+    if (size < 3) {
+        return size;
+    }
+    const size_t i_fin = size - 2;
+    for (size_t i = 0; i < i_fin; ) {
+        //data[i+2]が0でも1でもなければ、i, i+1, i+2のどれもstart codeの先頭にはならない
+        if (data[i+2] > 1) {
+            i += 3;
+        } else if (data[i+2] == 1 && data[i+1] == 0 && data[i] == 0) {
+            return i;
+        } else {
+            i++;
+        }
+    }
+    return size;
+}
+
+size_t find_start_code_sse2(const uint8_t *data, size_t size) {
+    size_t i = 0;
+    if (size >= 16 + 2) {
+        const __m128i xZero = _mm_setzero_si128();
+        const __m128i xOne = _mm_set1_epi8(1);
+        //data[i+0], data[i+1], data[i+2]をそれぞれずらして読み込み、00 00 01となる位置を一度に判定する
+        for (; i + 16 + 2 <= size; i += 16) {
+            __m128i x0 = _mm_loadu_si128((const __m128i *)(data + i + 0));
+            __m128i x1 = _mm_loadu_si128((const __m128i *)(data + i + 1));
+            __m128i x2 = _mm_loadu_si128((const __m128i *)(data + i + 2));
+            __m128i xMatch = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(x0, xZero), _mm_cmpeq_epi8(x1, xZero)), _mm_cmpeq_epi8(x2, xOne));
+            const uint32_t mask = (uint32_t)_mm_movemask_epi8(xMatch);
+            if (mask) {
+                return i + ctz32(mask);
+            }
+        }
+    }
+    return i + find_start_code_c(data + i, size - i);
+}
+
+funcFindStartCode get_find_start_code_func() {
+    const auto simd = get_availableSIMD();
+#if defined(_MSC_VER) || defined(__AVX2__)
+    if (simd & AVX2) {
+        return find_start_code_avx2;
+    }
+#endif
+    if (simd & SSE2) {
+        return find_start_code_sse2;
+    }
+    return find_start_code_c;
+}
+
+funcFindStartCode get_find_emulation_prevention_byte_func() {
+    const auto simd = get_availableSIMD();
+#if defined(_MSC_VER) || defined(__AVX2__)
+    if (simd & AVX2) {
+        return find_emulation_prevention_byte_avx2;
+    }
+#endif
+    if (simd & SSE2) {
+        return find_emulation_prevention_byte_sse2;
+    }
+    return find_emulation_prevention_byte_c;
+}
+
+funcFindStartCode get_find_emulation_prevention_target_func() {
+    const auto simd = get_availableSIMD();
+#if defined(_MSC_VER) || defined(__AVX2__)
+    if (simd & AVX2) {
+        return find_emulation_prevention_target_avx2;
+    }
+#endif
+    if (simd & SSE2) {
+        return find_emulation_prevention_target_sse2;
+    }
+    return find_emulation_prevention_target_c;
+}
+
+template<bool hevc>
+static void parse_nal_unit(const uint8_t *data, size_t size, std::vector<nal_info>& nal_list) {
+    if (size <= 3) {
+        return;
+    }
+    static const auto find_start_code = get_find_start_code_func();
+    //start codeの次のNAL typeのバイトまでがデータ内にあるものだけを検出する
+    const size_t search_size = size - 1;
+    const size_t list_start = nal_list.size();
+    for (size_t i = find_start_code(data, search_size); i < search_size; ) {
+        nal_info nal;
+        nal.ptr = data + i - (i > 0 && data[i-1] == 0);
+        if (hevc) {
+            nal.type = (data[i+3] & 0x7f) >> 1;
+            nal.temporal_id = (i + 4 < size) ? (uint8_t)std::max(0, (data[i+4] & 0x07) - 1) : 0;
+        } else {
+            nal.type = data[i+3] & 0x1f;
+            nal.temporal_id = 0;
+        }
+        nal.size = data + size - nal.ptr;
+        if (nal_list.size() > list_start) {
+            auto& prev = nal_list.back();
+            prev.size = nal.ptr - prev.ptr;
+        }
+        nal_list.push_back(nal);
+        const size_t next = i + 4;
+        i = (next < search_size) ? next + find_start_code(data + next, search_size - next) : search_size;
+    }
+}
+
+void parse_nal_unit_h264(const uint8_t *data, size_t size, std::vector<nal_info>& nal_list) {
+    parse_nal_unit<false>(data, size, nal_list);
+}
+
+void parse_nal_unit_hevc(const uint8_t *data, size_t size, std::vector<nal_info>& nal_list) {
+    parse_nal_unit<true>(data, size, nal_list);
 }
 
 HEVCHDRSeiPrm::HEVCHDRSeiPrm() : maxcll(-1), maxfall(-1), contentlight_set(false), masterdisplay(), masterdisplay_set(false) {
@@ -146,82 +354,194 @@ std::string HEVCHDRSei::print() const {
     return str;
 }
 
-void HEVCHDRSei::add_u16(std::vector<uint8_t>& data, uint16_t u16) const {
-    data.push_back((uint8_t)((u16 & 0xff00) >> 8));
-    data.push_back((uint8_t)(u16 & 0x00ff));
-}
-
-void HEVCHDRSei::add_u32(std::vector<uint8_t>& data, uint32_t u32) const {
-    data.push_back((uint8_t)((u32 & 0xff000000) >> 24));
-    data.push_back((uint8_t)((u32 & 0x00ff0000) >> 16));
-    data.push_back((uint8_t)((u32 & 0x0000ff00) >>  8));
-    data.push_back((uint8_t)((u32 & 0x000000ff) >>  0));
-}
-
 std::vector<uint8_t> HEVCHDRSei::gen_nal(HEVCHDRSeiPrm prm_set) {
     prm = prm_set;
     return gen_nal();
 }
 
 std::vector<uint8_t> HEVCHDRSei::gen_nal() const {
-    std::vector<uint8_t> data;
-    data.reserve(128);
+    RGYSEIWriter writer;
+    add_payload(writer);
+    std::vector<uint8_t> nal;
+    writer.appendNalHEVC(nal);
+    return nal;
+}
 
-    auto data_maxcll = sei_maxcll();
-    auto data_masterdisplay = sei_masterdisplay();
-    if (data_maxcll.size() == 0 && data_masterdisplay.size() == 0) {
-        return data;
+void HEVCHDRSei::add_payload(RGYSEIWriter& writer) const {
+    if (prm.contentlight_set && prm.maxcll >= 0 && prm.maxfall >= 0) {
+        writer.addContentLightLevel(prm.maxcll, prm.maxfall);
     }
-    std::vector<uint8_t> header = { 0x00, 0x00, 0x00, 0x01 };
-    header.reserve(128);
+    if (prm.masterdisplay_set) {
+        writer.addMasteringDisplay(prm.masterdisplay);
+    }
+}
 
-    uint16_t u16 = 0x00;
-    u16 |= (39 << 9) | 1;
-    add_u16(data, u16);
+static inline uint8_t *write_u16_be(uint8_t *ptr, uint16_t u16) {
+    ptr[0] = (uint8_t)(u16 >> 8);
+    ptr[1] = (uint8_t)(u16);
+    return ptr + 2;
+}
 
-    vector_cat(data, data_maxcll);
-    vector_cat(data, data_masterdisplay);
-    to_nal(data);
+static inline uint8_t *write_u32_be(uint8_t *ptr, uint32_t u32) {
+    ptr[0] = (uint8_t)(u32 >> 24);
+    ptr[1] = (uint8_t)(u32 >> 16);
+    ptr[2] = (uint8_t)(u32 >> 8);
+    ptr[3] = (uint8_t)(u32);
+    return ptr + 4;
+}
 
-    vector_cat(header, data);
-    header.push_back(0x80);
-    return header;
+RGYSEIWriter::RGYSEIWriter() : m_buf(), m_payloads() {
+    m_buf.reserve(1024);
 }
 
+void RGYSEIWriter::clear() {
+    m_buf.clear();
+    m_payloads.clear();
+}
 
-std::vector<uint8_t> HEVCHDRSei::sei_maxcll() const {
-    std::vector<uint8_t> data;
-    data.reserve(256);
-    if (prm.contentlight_set && prm.maxcll >= 0 && prm.maxfall >= 0) {
-        data.push_back(144);
-        data.push_back(4);
-        add_u16(data, (uint16_t)prm.maxcll);
-        add_u16(data, (uint16_t)prm.maxfall);
+uint8_t *RGYSEIWriter::add(int payloadType, size_t size) {
+    Payload payload;
+    payload.type = payloadType;
+    payload.offset = m_buf.size();
+    payload.size = size;
+    m_payloads.push_back(payload);
+    m_buf.resize(m_buf.size() + size);
+    return m_buf.data() + payload.offset;
+}
+
+void RGYSEIWriter::add(int payloadType, const uint8_t *data, size_t size) {
+    auto ptr = add(payloadType, size);
+    if (size > 0) {
+        memcpy(ptr, data, size);
     }
-    return data;
 }
 
-std::vector<uint8_t> HEVCHDRSei::sei_masterdisplay() const {
-    std::vector<uint8_t> data;
-    data.reserve(256);
-    if (prm.masterdisplay_set) {
-        data.push_back(137);
-        data.push_back(24);
-        for (int i = 0; i < 8; i++) {
-            add_u16(data, (uint16_t)prm.masterdisplay[i]);
-        }
-        add_u32(data, (uint32_t)prm.masterdisplay[8]);
-        add_u32(data, (uint32_t)prm.masterdisplay[9]);
+void RGYSEIWriter::addT35(const uint8_t *data, size_t size) {
+    add(USER_DATA_REGISTERED_ITU_T_T35, data, size);
+}
+
+void RGYSEIWriter::addUserDataUnregistered(const uint8_t uuid[16], const uint8_t *data, size_t size) {
+    auto ptr = add(USER_DATA_UNREGISTERED, 16 + size);
+    memcpy(ptr, uuid, 16);
+    if (size > 0) {
+        memcpy(ptr + 16, data, size);
     }
-    return data;
 }
 
-void HEVCHDRSei::to_nal(std::vector<uint8_t>& data) const {
-    for (auto it = data.begin(); it < data.end() - 2; it++) {
-        if (    *it == 0
-            && *(it+1) == 0
-            && (*(it+2) & (~(0x03))) == 0) {
-            it = data.insert(it+2, 0x03);
+void RGYSEIWriter::endBitPayload(int payloadType, size_t offset, RGYBitWriter& writer) {
+    //sei_payloadの終端がバイト境界にない場合は、1を書いてから0で埋める
+    if (!writer.byteAligned()) {
+        writer.put(1, 1);
+        writer.alignZero();
+    }
+    Payload payload;
+    payload.type = payloadType;
+    payload.offset = offset;
+    payload.size = m_buf.size() - offset;
+    m_payloads.push_back(payload);
+}
+
+void RGYSEIWriter::addRecoveryPointH264(int recoveryFrameCnt, bool exactMatch, bool brokenLink) {
+    const size_t offset = m_buf.size();
+    RGYBitWriter writer(m_buf);
+    writer.putUE((uint32_t)recoveryFrameCnt);
+    writer.put(exactMatch ? 1 : 0, 1);
+    writer.put(brokenLink ? 1 : 0, 1);
+    writer.put(0, 2); // changing_slice_group_idc
+    endBitPayload(RECOVERY_POINT, offset, writer);
+}
+
+void RGYSEIWriter::addRecoveryPointHEVC(int recoveryPocCnt, bool exactMatch, bool brokenLink) {
+    const size_t offset = m_buf.size();
+    RGYBitWriter writer(m_buf);
+    writer.putSE(recoveryPocCnt);
+    writer.put(exactMatch ? 1 : 0, 1);
+    writer.put(brokenLink ? 1 : 0, 1);
+    endBitPayload(RECOVERY_POINT, offset, writer);
+}
+
+void RGYSEIWriter::addTimeCodeHEVC(int hours, int minutes, int seconds, int frames, bool dropFrame) {
+    const size_t offset = m_buf.size();
+    RGYBitWriter writer(m_buf);
+    writer.put(1, 2); // num_clock_ts
+    writer.put(1, 1); // clock_timestamp_flag
+    writer.put(0, 1); // units_field_based_flag
+    writer.put(dropFrame ? 4 : 0, 5); // counting_type
+    writer.put(1, 1); // full_timestamp_flag
+    writer.put(0, 1); // discontinuity_flag
+    writer.put(0, 1); // cnt_dropped_flag
+    writer.put((uint32_t)frames, 9);
+    writer.put((uint32_t)seconds, 6);
+    writer.put((uint32_t)minutes, 6);
+    writer.put((uint32_t)hours, 5);
+    writer.put(0, 5); // time_offset_length
+    endBitPayload(TIME_CODE, offset, writer);
+}
+
+void RGYSEIWriter::addContentLightLevel(int maxcll, int maxfall) {
+    auto ptr = add(CONTENT_LIGHT_LEVEL_INFO, 4);
+    ptr = write_u16_be(ptr, (uint16_t)maxcll);
+    ptr = write_u16_be(ptr, (uint16_t)maxfall);
+}
+
+void RGYSEIWriter::addMasteringDisplay(const int masterdisplay[10]) {
+    auto ptr = add(MASTERING_DISPLAY_COLOUR_VOLUME, 24);
+    for (int i = 0; i < 8; i++) {
+        ptr = write_u16_be(ptr, (uint16_t)masterdisplay[i]);
+    }
+    ptr = write_u32_be(ptr, (uint32_t)masterdisplay[8]);
+    ptr = write_u32_be(ptr, (uint32_t)masterdisplay[9]);
+}
+
+void RGYSEIWriter::appendNalH264(std::vector<uint8_t>& nal) const {
+    static const uint8_t header[] = { NALU_H264_SEI };
+    appendNal(nal, header, _countof(header));
+}
+
+void RGYSEIWriter::appendNalHEVC(std::vector<uint8_t>& nal, bool suffix) const {
+    const uint8_t header[] = { (uint8_t)((suffix ? NALU_HEVC_SUFFIX_SEI : NALU_HEVC_PREFIX_SEI) << 1), 0x01 };
+    appendNal(nal, header, _countof(header));
+}
+
+void RGYSEIWriter::appendNal(std::vector<uint8_t>& nal, const uint8_t *nalHeader, size_t nalHeaderSize) const {
+    if (empty()) {
+        return;
+    }
+    //emulation prevention byteは最大で2byteごとに1つなので、その分も含めて先に確保しておく
+    size_t rbspSize = 1;
+    for (const auto& payload : m_payloads) {
+        rbspSize += payload.type / 255 + 1 + payload.size / 255 + 1 + payload.size;
+    }
+    static const uint8_t startCode[] = { 0x00, 0x00, 0x00, 0x01 };
+    nal.reserve(nal.size() + _countof(startCode) + nalHeaderSize + rbspSize + rbspSize / 2 + 1);
+    nal.insert(nal.end(), startCode, startCode + _countof(startCode));
+    nal.insert(nal.end(), nalHeader, nalHeader + nalHeaderSize);
+
+    //sei_messageを書き出しながら、emulation preventionを行う
+    int zeroCount = 0;
+    auto put = [&nal, &zeroCount](uint8_t byte) {
+        if (zeroCount >= 2 && byte <= 0x03) {
+            nal.push_back(0x03);
+            zeroCount = 0;
+        }
+        nal.push_back(byte);
+        zeroCount = (byte == 0x00) ? zeroCount + 1 : 0;
+    };
+    for (const auto& payload : m_payloads) {
+        size_t type = payload.type;
+        for (; type >= 255; type -= 255) {
+            put(0xff);
+        }
+        put((uint8_t)type);
+        size_t size = payload.size;
+        for (; size >= 255; size -= 255) {
+            put(0xff);
+        }
+        put((uint8_t)size);
+        const uint8_t *data = payloadData(payload);
+        for (size_t i = 0; i < payload.size; i++) {
+            put(data[i]);
         }
     }
+    nal.push_back(0x80); // rbsp_trailing_bits
 }
@@ -36,6 +36,7 @@
 struct nal_info {
     const uint8_t *ptr;
     uint8_t type;
+    uint8_t temporal_id; //HEVCのTemporalId (H.264では常に0)
     size_t size;
 };
 
@@ -118,61 +119,127 @@ enum PayloadType {
 };
 
 std::vector<uint8_t> unnal(const uint8_t *ptr, size_t len);
+//emulation prevention byte (00 00 03 の 03) を取り除いてdstに書き出し、書き出したバイト数を返す
+//dstにはlenバイト以上の領域が必要 (dst == srcとしてin-placeで処理してもよい)
+size_t unnal(uint8_t *dst, const uint8_t *src, size_t len);
+//emulation prevention byteを挿入しながら、dstの末尾に追加する
+void renal(std::vector<uint8_t>& dst, const uint8_t *src, size_t len);
+
+//emulation prevention byteの位置 (00 00 03 の先頭の00の位置) を返す
+//見つからなければsizeを返す
+size_t find_emulation_prevention_byte_c(const uint8_t *data, size_t size);
+size_t find_emulation_prevention_byte_sse2(const uint8_t *data, size_t size);
+size_t find_emulation_prevention_byte_avx2(const uint8_t *data, size_t size);
+//emulation prevention byteの挿入が必要な位置 (00 00 0x (x <= 3) の先頭の00の位置) を返す
+//見つからなければsizeを返す
+size_t find_emulation_prevention_target_c(const uint8_t *data, size_t size);
+size_t find_emulation_prevention_target_sse2(const uint8_t *data, size_t size);
+size_t find_emulation_prevention_target_avx2(const uint8_t *data, size_t size);
+
+//start code (00 00 01)を検索し、見つかった位置 (先頭の00の位置) を返す
+//見つからなければsizeを返す
+size_t find_start_code_c(const uint8_t *data, size_t size);
+size_t find_start_code_sse2(const uint8_t *data, size_t size);
+size_t find_start_code_avx2(const uint8_t *data, size_t size);
+typedef size_t (*funcFindStartCode)(const uint8_t *data, size_t size);
+//実行環境で使用可能な最も速い関数を返す
+funcFindStartCode get_find_start_code_func();
+funcFindStartCode get_find_emulation_prevention_byte_func();
+funcFindStartCode get_find_emulation_prevention_target_func();
+
+//NAL unitに分割し、nal_listの末尾に追加する
+//nal_listを呼び出し側で使いまわせば、呼び出しごとの確保は不要になる
+void parse_nal_unit_h264(const uint8_t *data, size_t size, std::vector<nal_info>& nal_list);
+void parse_nal_unit_hevc(const uint8_t *data, size_t size, std::vector<nal_info>& nal_list);
 
 static std::vector<nal_info> parse_nal_unit_h264(const uint8_t *data, size_t size) {
     std::vector<nal_info> nal_list;
-    if (size > 3) {
-        nal_info nal_start = { nullptr, 0, 0 };
-        const auto i_fin = size - 3;
-        for (size_t i = 0; i < i_fin; i++) {
-            if (data[i+0] == 0 && data[i+1] == 0 && data[i+2] == 1) {
-                if (nal_start.ptr) {
-                    nal_list.push_back(nal_start);
-                }
-                nal_start.ptr = data + i - (i > 0 && data[i-1] == 0);
-                nal_start.type = data[i+3] & 0x1f;
-                nal_start.size = data + size - nal_start.ptr;
-                if (nal_list.size()) {
-                    auto prev = nal_list.end()-1;
-                    prev->size = nal_start.ptr - prev->ptr;
-                }
-                i += 3;
-            }
-        }
-        if (nal_start.ptr) {
-            nal_list.push_back(nal_start);
-        }
-    }
+    parse_nal_unit_h264(data, size, nal_list);
     return nal_list;
 }
 
 static std::vector<nal_info> parse_nal_unit_hevc(const uint8_t *data, size_t size) {
     std::vector<nal_info> nal_list;
-    if (size > 3) {
-        nal_info nal_start = { nullptr, 0, 0 };
-        const auto i_fin = size - 3;
-
-        for (size_t i = 0; i < i_fin; i++) {
-            if (data[i+0] == 0 && data[i+1] == 0 && data[i+2] == 1) {
-                if (nal_start.ptr) {
-                    nal_list.push_back(nal_start);
-                }
-                nal_start.ptr = data + i - (i > 0 && data[i-1] == 0);
-                nal_start.type = (data[i+3] & 0x7f) >> 1;
-                nal_start.size = data + size - nal_start.ptr;
-                if (nal_list.size()) {
-                    auto prev = nal_list.end()-1;
-                    prev->size = nal_start.ptr - prev->ptr;
-                }
-                i += 3;
+    parse_nal_unit_hevc(data, size, nal_list);
+    return nal_list;
+}
+
+//ビット単位でbufの末尾に追加していく (MSB first)
+class RGYBitWriter {
+public:
+    RGYBitWriter(std::vector<uint8_t>& buf) : m_buf(buf), m_bitPos(0) {};
+    void put(uint32_t value, int bits) {
+        for (int i = bits - 1; i >= 0; i--) {
+            if ((m_bitPos & 7) == 0) {
+                m_buf.push_back(0);
             }
+            m_buf.back() |= (uint8_t)(((value >> i) & 1) << (7 - (m_bitPos & 7)));
+            m_bitPos++;
         }
-        if (nal_start.ptr) {
-            nal_list.push_back(nal_start);
+    }
+    //ue(v) (value < 0xffffffff)
+    void putUE(uint32_t value) {
+        const uint32_t v = value + 1;
+        int len = 0;
+        while ((v >> len) > 1) {
+            len++;
         }
+        put(0, len);
+        put(v, len + 1);
     }
-    return nal_list;
-}
+    //se(v)
+    void putSE(int value) {
+        putUE((value <= 0) ? (uint32_t)(-2 * (int64_t)value) : (uint32_t)(2 * (int64_t)value - 1));
+    }
+    bool byteAligned() const { return (m_bitPos & 7) == 0; }
+    //バイト境界まで0で埋める
+    void alignZero() { m_bitPos = (m_bitPos + 7) & ~(size_t)7; }
+private:
+    std::vector<uint8_t>& m_buf;
+    size_t m_bitPos;
+};
+
+//SEIの組み立て
+//フレームごとのSEIのpayloadを1つのバッファにまとめておき、エンコーダに渡すpayloadの一覧や
+//SEI NAL unitを生成する。バッファは使いまわすので、フレームごとの確保は発生しない
+class RGYSEIWriter {
+public:
+    struct Payload {
+        int type;
+        size_t offset; //m_bufでの位置
+        size_t size;
+    };
+    RGYSEIWriter();
+
+    //追加済みのpayloadを破棄する (確保済みのバッファは保持する)
+    void clear();
+    bool empty() const { return m_payloads.size() == 0; }
+    const std::vector<Payload>& payloads() const { return m_payloads; }
+    const uint8_t *payloadData(const Payload& payload) const { return m_buf.data() + payload.offset; }
+
+    //payloadを追加する
+    void add(int payloadType, const uint8_t *data, size_t size);
+    //sizeバイトのpayloadを追加し、書き込み先を返す (次のaddまで有効)
+    uint8_t *add(int payloadType, size_t size);
+    void addT35(const uint8_t *data, size_t size);
+    void addUserDataUnregistered(const uint8_t uuid[16], const uint8_t *data, size_t size);
+    void addRecoveryPointH264(int recoveryFrameCnt, bool exactMatch, bool brokenLink);
+    void addRecoveryPointHEVC(int recoveryPocCnt, bool exactMatch, bool brokenLink);
+    void addTimeCodeHEVC(int hours, int minutes, int seconds, int frames, bool dropFrame);
+    void addContentLightLevel(int maxcll, int maxfall);
+    void addMasteringDisplay(const int masterdisplay[10]);
+
+    //SEI NAL unit (start code付き) を生成し、nalの末尾に追加する
+    void appendNalH264(std::vector<uint8_t>& nal) const;
+    void appendNalHEVC(std::vector<uint8_t>& nal, bool suffix = false) const;
+private:
+    //ビット単位で書き込むpayloadの終端処理
+    void endBitPayload(int payloadType, size_t offset, RGYBitWriter& writer);
+    void appendNal(std::vector<uint8_t>& nal, const uint8_t *nalHeader, size_t nalHeaderSize) const;
+
+    std::vector<uint8_t> m_buf; //payloadのデータ (emulation prevention前)
+    std::vector<Payload> m_payloads;
+};
 
 struct HEVCHDRSeiPrm {
     int maxcll;
@@ -201,12 +268,8 @@ public:
     std::string print() const;
     std::vector<uint8_t> gen_nal() const;
     std::vector<uint8_t> gen_nal(HEVCHDRSeiPrm prm);
-private:
-    std::vector<uint8_t> sei_maxcll() const;
-    std::vector<uint8_t> sei_masterdisplay() const;
-    void to_nal(std::vector<uint8_t>& data) const;
-    void add_u16(std::vector<uint8_t>& data, uint16_t u16) const;
-    void add_u32(std::vector<uint8_t>& data, uint32_t u32) const;
+    //MaxCLL/MaxFALL, mastering displayのSEIをwriterに追加する
+    void add_payload(RGYSEIWriter& writer) const;
 };
 
 #endif //__RGY_BITSTREAM_H__
@@ -0,0 +1,103 @@
+﻿// -----------------------------------------------------------------------------------------
+// QSVEnc/NVEnc by rigaya
+// -----------------------------------------------------------------------------------------
+// The MIT License
+//
+// Copyright (c) 2011-2016 rigaya
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// --------------------------------------------------------------------------------------------
+
+#include <immintrin.h>
+#include "rgy_bitstream.h"
+#include "rgy_util.h"
+
+#if _MSC_VER >= 1800 && !defined(__AVX__) && !defined(_DEBUG)
+static_assert(false, "do not forget to set /arch:AVX or /arch:AVX2 for this file.");
+#endif
+
+#if defined(_MSC_VER) || defined(__AVX2__)
+
+size_t find_start_code_avx2(const uint8_t *data, size_t size) {
+    size_t i = 0;
+    if (size >= 64 + 2) {
+        const __m256i yZero = _mm256_setzero_si256();
+        const __m256i yOne = _mm256_set1_epi8(1);
+        //data[i+0], data[i+1], data[i+2]をそれぞれずらして読み込み、00 00 01となる位置を一度に判定する
+        //start codeはまれにしか出現しないので、64byteずつまとめて判定し、見つかった場合のみ位置を求める
+        for (; i + 64 + 2 <= size; i += 64) {
+            __m256i y0a = _mm256_loadu_si256((const __m256i *)(data + i +  0));
+            __m256i y1a = _mm256_loadu_si256((const __m256i *)(data + i +  1));
+            __m256i y2a = _mm256_loadu_si256((const __m256i *)(data + i +  2));
+            __m256i y0b = _mm256_loadu_si256((const __m256i *)(data + i + 32));
+            __m256i y1b = _mm256_loadu_si256((const __m256i *)(data + i + 33));
+            __m256i y2b = _mm256_loadu_si256((const __m256i *)(data + i + 34));
+            __m256i yMatchA = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(y0a, yZero), _mm256_cmpeq_epi8(y1a, yZero)), _mm256_cmpeq_epi8(y2a, yOne));
+            __m256i yMatchB = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(y0b, yZero), _mm256_cmpeq_epi8(y1b, yZero)), _mm256_cmpeq_epi8(y2b, yOne));
+            if (!_mm256_testz_si256(_mm256_or_si256(yMatchA, yMatchB), _mm256_or_si256(yMatchA, yMatchB))) {
+                const uint32_t maskA = (uint32_t)_mm256_movemask_epi8(yMatchA);
+                if (maskA) {
+                    _mm256_zeroupper();
+                    return i + ctz32(maskA);
+                }
+                const uint32_t maskB = (uint32_t)_mm256_movemask_epi8(yMatchB);
+                _mm256_zeroupper();
+                return i + 32 + ctz32(maskB);
+            }
+        }
+        _mm256_zeroupper();
+    }
+    return i + find_start_code_sse2(data + i, size - i);
+}
+
+//00 00 xx を検索する
+//targetがtrueなら xx <= 03 (emulation prevention byteの挿入が必要な位置)、falseなら xx == 03 (emulation prevention byte)
+template<bool target>
+static size_t find_emulation_prevention_avx2_base(const uint8_t *data, size_t size) {
+    size_t i = 0;
+    if (size >= 32 + 2) {
+        const __m256i yZero = _mm256_setzero_si256();
+        const __m256i yThree = _mm256_set1_epi8(3);
+        for (; i + 32 + 2 <= size; i += 32) {
+            __m256i y0 = _mm256_loadu_si256((const __m256i *)(data + i + 0));
+            __m256i y1 = _mm256_loadu_si256((const __m256i *)(data + i + 1));
+            __m256i y2 = _mm256_loadu_si256((const __m256i *)(data + i + 2));
+            __m256i y2Match = (target) ? _mm256_cmpeq_epi8(_mm256_min_epu8(y2, yThree), y2) : _mm256_cmpeq_epi8(y2, yThree);
+            __m256i yMatch = _mm256_and_si256(_mm256_and_si256(_mm256_cmpeq_epi8(y0, yZero), _mm256_cmpeq_epi8(y1, yZero)), y2Match);
+            const uint32_t mask = (uint32_t)_mm256_movemask_epi8(yMatch);
+            if (mask) {
+                _mm256_zeroupper();
+                return i + ctz32(mask);
+            }
+        }
+        _mm256_zeroupper();
+    }
+    return i + ((target) ? find_emulation_prevention_target_sse2(data + i, size - i) : find_emulation_prevention_byte_sse2(data + i, size - i));
+}
+
+size_t find_emulation_prevention_byte_avx2(const uint8_t *data, size_t size) {
+    return find_emulation_prevention_avx2_base<false>(data, size);
+}
+
+size_t find_emulation_prevention_target_avx2(const uint8_t *data, size_t size) {
+    return find_emulation_prevention_avx2_base<true>(data, size);
+}
+
+#endif //#if defined(_MSC_VER) || defined(__AVX2__)
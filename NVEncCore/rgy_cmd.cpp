@@ -1495,6 +1495,85 @@ int parse_one_ctrl_option(const TCHAR *option_name, const TCHAR *strInput[], int
         ctrl->lowLatency = true;
         return 0;
     }
+    if (IS_OPTION("host-hugepage")) {
+        i++;
+        int value = 0;
+        if (get_list_value(list_host_hugepage, strInput[i], &value)) {
+            ctrl->hostHugePage = (RGYHostHugePage)value;
+        } else {
+            print_cmd_error_invalid_value(option_name, strInput[i], list_host_hugepage);
+            return 1;
+        }
+        return 0;
+    }
+    if (IS_OPTION("input-read-mode")) {
+        i++;
+        int value = 0;
+        if (get_list_value(list_input_read_mode, strInput[i], &value)) {
+            ctrl->inputReadMode = (RGYInputReadMode)value;
+        } else {
+            print_cmd_error_invalid_value(option_name, strInput[i], list_input_read_mode);
+            return 1;
+        }
+        return 0;
+    }
+    if (IS_OPTION("input-prefetch")) {
+        i++;
+        int value = 0;
+        if (1 != _stscanf_s(strInput[i], _T("%d"), &value)) {
+            print_cmd_error_invalid_value(option_name, strInput[i]);
+            return 1;
+        }
+        if (value < 0) {
+            print_cmd_error_invalid_value(option_name, strInput[i], _T("should be 0 or positive value."));
+            return 1;
+        }
+        ctrl->inputPrefetch = value;
+        return 0;
+    }
+    if (IS_OPTION("input-index")) {
+        ctrl->inputIndex = true;
+        return 0;
+    }
+    if (IS_OPTION("avsw-decode-queue")) {
+        i++;
+        int value = 0;
+        if (1 != _stscanf_s(strInput[i], _T("%d"), &value)) {
+            print_cmd_error_invalid_value(option_name, strInput[i]);
+            return 1;
+        }
+        if (value < 0) {
+            print_cmd_error_invalid_value(option_name, strInput[i], _T("should be 0 or positive value."));
+            return 1;
+        }
+        ctrl->avswDecodeQueue = value;
+        return 0;
+    }
+    if (IS_OPTION("avsw-threads")) {
+        i++;
+        int value = 0;
+        if (1 != _stscanf_s(strInput[i], _T("%d"), &value)) {
+            print_cmd_error_invalid_value(option_name, strInput[i]);
+            return 1;
+        }
+        if (value < 0) {
+            print_cmd_error_invalid_value(option_name, strInput[i], _T("should be 0 or positive value."));
+            return 1;
+        }
+        ctrl->avswThreads = value;
+        return 0;
+    }
+    if (IS_OPTION("avsw-thread-type")) {
+        i++;
+        int value = 0;
+        if (get_list_value(list_avsw_thread_type, strInput[i], &value)) {
+            ctrl->avswThreadType = (RGYAVSWThreadType)value;
+        } else {
+            print_cmd_error_invalid_value(option_name, strInput[i], list_avsw_thread_type);
+            return 1;
+        }
+        return 0;
+    }
     if (IS_OPTION("input-thread") || IS_OPTION("thread-input")) {
         i++;
         int value = 0;
@@ -1543,6 +1622,10 @@ int parse_one_ctrl_option(const TCHAR *option_name, const TCHAR *strInput[], int
     }
     if (IS_OPTION("thread-csp")) {
         i++;
+        if (0 == _tcsicmp(strInput[i], _T("tiled"))) {
+            ctrl->threadCsp = RGY_THREAD_CSP_TILED;
+            return 0;
+        }
         int value = 0;
         if (1 != _stscanf_s(strInput[i], _T("%d"), &value)) {
             print_cmd_error_invalid_value(option_name, strInput[i]);
@@ -1917,10 +2000,21 @@ tstring gen_cmd(const RGYParamControl *param, const RGYParamControl *defaultPrm,
     OPT_NUM(_T("--thread-output"), threadOutput);
     OPT_NUM(_T("--thread-input"), threadInput);
     OPT_NUM(_T("--thread-audio"), threadAudio);
-    OPT_NUM(_T("--thread-csp"), threadCsp);
+    if (param->threadCsp == RGY_THREAD_CSP_TILED) {
+        cmd << _T(" --thread-csp tiled");
+    } else {
+        OPT_NUM(_T("--thread-csp"), threadCsp);
+    }
     OPT_LST(_T("--simd-csp"), simdCsp, list_simd);
     OPT_NUM(_T("--max-procfps"), procSpeedLimit);
     OPT_BOOL(_T("--lowlatency"), _T(""), lowLatency);
+    OPT_LST(_T("--host-hugepage"), hostHugePage, list_host_hugepage);
+    OPT_LST(_T("--input-read-mode"), inputReadMode, list_input_read_mode);
+    OPT_NUM(_T("--input-prefetch"), inputPrefetch);
+    OPT_BOOL(_T("--input-index"), _T(""), inputIndex);
+    OPT_NUM(_T("--avsw-decode-queue"), avswDecodeQueue);
+    OPT_NUM(_T("--avsw-threads"), avswThreads);
+    OPT_LST(_T("--avsw-thread-type"), avswThreadType, list_avsw_thread_type);
     OPT_STR_PATH(_T("--log"), logfile);
     OPT_LST(_T("--log-level"), loglevel, list_log_level);
     OPT_STR_PATH(_T("--log-framelist"), logFramePosList);
@@ -2157,7 +2251,23 @@ tstring gen_cmd_help_ctrl() {
     str += strsprintf(_T("")
         _T("   --max-procfps <int>         limit encoding speed for lower utilization.\n")
         _T("                                 default:0 (no limit)\n")
-        _T("   --lowlatency                minimize latency (might have lower throughput).\n"));
+        _T("   --lowlatency                minimize latency (might have lower throughput).\n")
+        _T("   --host-hugepage <string>    use huge pages for host frame buffers.\n")
+        _T("                                 off, auto(default), on\n")
+        _T("   --input-read-mode <string>  set how raw/y4m input files are read.\n")
+        _T("                                 auto(default), stdio, mmap, direct\n")
+        _T("   --input-prefetch <int>      read raw/y4m frames ahead on a separate thread.\n")
+        _T("                                 set number of frames to read ahead, default:0 (disabled)\n")
+        _T("   --input-index               cache keyframe index of avhw/avsw input\n")
+        _T("                                 next to the input file, to speed up reopening.\n")
+        _T("   --avsw-decode-queue <int>   decode avsw input ahead on a separate thread.\n")
+        _T("                                 set number of frames to decode ahead, default:%d\n")
+        _T("                                 0: decode on the calling thread\n")
+        _T("   --avsw-threads <int>        set number of threads used by the avsw decoder.\n")
+        _T("                                 default:0 (auto)\n")
+        _T("   --avsw-thread-type <string> set threading method of the avsw decoder.\n")
+        _T("                                 auto(default), frame, slice\n"),
+        DEFAULT_AVSW_DECODE_QUEUE);
 #if ENABLE_AVCODEC_OUT_THREAD
     str += strsprintf(_T("")
         _T("   --output-thread <int>        set output thread num\n")
@@ -28,46 +28,94 @@
 #if !(defined(_WIN32) || defined(_WIN64))
 #include "rgy_event.h"
 
-#include <thread>
-#include <mutex>
-#include <condition_variable>
 #include <atomic>
 #include <climits>
 #include <chrono>
 #include <algorithm>
+#include <cerrno>
+#include <ctime>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
+//イベントはfutexの対象となる状態変数のみを持ち、mutex/condition_variableは使用しない
+//状態変数: 0 = 非シグナル, 1 = シグナル
 class Event {
 public:
+    std::atomic<uint32_t> state;
+    std::atomic<uint32_t> waiters; //WaitForSingleObjectで待機中のスレッド数
     bool bManualReset;
-    bool bReady;
-    std::mutex mtx;
-    std::condition_variable cv;
 
-    Event() : bManualReset(false), bReady(false), mtx(), cv() {
-
-    };
-    Event(bool manualReset) : Event() {
-        bManualReset = manualReset;
+    Event(bool manualReset) : state(0), waiters(0), bManualReset(manualReset) {
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex requires 32bit atomic.");
     };
 };
 
-void ResetEvent(HANDLE ev) {
-    Event *event = (Event *)ev;
-    {
-        std::lock_guard<std::mutex> lock(event->mtx);
-        if (event->bReady) {
-            event->bReady = false;
+//WaitForMultipleObjectsで複数のイベントを待機するスレッドは、どのイベントがセットされても起床する必要がある
+//futexは1つのアドレスしか待機できないので、待機中のスレッドがいる場合のみ、SetEventのたびにこの値を更新して起床させる
+static std::atomic<uint32_t> g_eventSetSeq(0);
+static std::atomic<uint32_t> g_eventMultiWaiters(0);
+
+static int futex_wait(std::atomic<uint32_t> *addr, uint32_t expected, const struct timespec *timeout) {
+    return (int)syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+}
+
+static void futex_wake(std::atomic<uint32_t> *addr, int count) {
+    syscall(SYS_futex, (uint32_t *)addr, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+//シグナル状態ならtrueを返す (自動リセットの場合は非シグナル状態に戻す)
+static bool event_try_acquire(Event *event) {
+    if (event->bManualReset) {
+        return event->state.load() != 0;
+    }
+    uint32_t expected = 1;
+    return event->state.compare_exchange_strong(expected, 0);
+}
+
+//待機の期限までの残り時間を取得する
+//INFINITEの場合はtimeoutにnullptrを返す、期限を過ぎていればfalseを返す
+class EventDeadline {
+public:
+    EventDeadline(uint32_t millisec) :
+        m_infinite(millisec == INFINITE),
+        m_deadline(std::chrono::steady_clock::now() + std::chrono::milliseconds(m_infinite ? 0 : millisec)),
+        m_ts() {
+    }
+    bool remaining(struct timespec **timeout) {
+        if (m_infinite) {
+            *timeout = nullptr;
+            return true;
         }
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(m_deadline - std::chrono::steady_clock::now()).count();
+        if (ns <= 0) {
+            return false;
+        }
+        m_ts.tv_sec  = (time_t)(ns / 1000000000);
+        m_ts.tv_nsec = (long)(ns % 1000000000);
+        *timeout = &m_ts;
+        return true;
     }
+private:
+    bool m_infinite;
+    std::chrono::steady_clock::time_point m_deadline;
+    struct timespec m_ts;
+};
+
+void ResetEvent(HANDLE ev) {
+    Event *event = (Event *)ev;
+    event->state.store(0);
 }
 
 void SetEvent(HANDLE ev) {
     Event *event = (Event *)ev;
-    {
-        std::lock_guard<std::mutex> lock(event->mtx);
-        if (!event->bReady) {
-            event->bReady = true;
-            (event->bManualReset) ? event->cv.notify_all() : event->cv.notify_one();
+    if (event->state.exchange(1) == 0) {
+        if (event->waiters.load() > 0) {
+            futex_wake(&event->state, (event->bManualReset) ? INT_MAX : 1);
+        }
+        if (g_eventMultiWaiters.load() > 0) {
+            g_eventSetSeq.fetch_add(1);
+            futex_wake(&g_eventSetSeq, INT_MAX);
         }
     }
 }
@@ -83,43 +131,71 @@ HANDLE CreateEvent(void *pDummy, int bManualReset, int bInitialState, void *pDum
 void CloseEvent(HANDLE ev) {
     if (ev != NULL) {
         Event *event = (Event *)ev;
-       delete event;
+        delete event;
     }
 }
 
 uint32_t WaitForSingleObject(HANDLE ev, uint32_t millisec) {
     Event *event = (Event *)ev;
-    {
-        std::unique_lock<std::mutex> uniq_lk(event->mtx);
-        if (millisec == INFINITE) {
-            event->cv.wait(uniq_lk, [&event]{ return event->bReady;});
-            if (!event->bManualReset) {
-                event->bReady = false;
-            }
-        } else {
-            event->cv.wait_for(uniq_lk, std::chrono::milliseconds(millisec), [&event]{ return event->bReady;});
-            if (!event->bReady) {
-                return WAIT_TIMEOUT;
-            }
-            if (!event->bManualReset) {
-                event->bReady = false;
-            }
+    EventDeadline deadline(millisec);
+    for (;;) {
+        if (event_try_acquire(event)) {
+            return WAIT_OBJECT_0;
         }
+        struct timespec *timeout = nullptr;
+        if (!deadline.remaining(&timeout)) {
+            return WAIT_TIMEOUT;
+        }
+        //waitersを増やしてからfutexで状態変数を確認するので、SetEventの通知を取りこぼさない
+        event->waiters.fetch_add(1);
+        futex_wait(&event->state, 0, timeout);
+        event->waiters.fetch_sub(1);
     }
-    return WAIT_OBJECT_0;
 }
 
-uint32_t WaitForMultipleObjects(uint32_t count, HANDLE *pev, int dummy, uint32_t millisec) {
+//bWaitAll = FALSE : いずれかのイベントがシグナル状態になるまで待機し、WAIT_OBJECT_0 + そのindexを返す
+//bWaitAll = TRUE  : すべてのイベントが同時にシグナル状態になるまで待機し、WAIT_OBJECT_0を返す
+uint32_t WaitForMultipleObjects(uint32_t count, HANDLE *pev, int bWaitAll, uint32_t millisec) {
     Event **pevent = (Event **)pev;
-    int success = 0;
-    bool bTimeout = false;
-    for (uint32_t i = 0; i < count; i++) {
-        if (WAIT_TIMEOUT == WaitForSingleObject(pevent[i], (bTimeout) ? 0 : millisec)) {
-            bTimeout = true;
-        } else {
-            success++;
+    EventDeadline deadline(millisec);
+    //状態を確認する前に登録しておくことで、確認後のSetEventで必ずg_eventSetSeqが更新されるようにする
+    g_eventMultiWaiters.fetch_add(1);
+    uint32_t ret = WAIT_TIMEOUT;
+    for (;;) {
+        const uint32_t seq = g_eventSetSeq.load();
+        if (!bWaitAll) {
+            for (uint32_t i = 0; i < count; i++) {
+                if (event_try_acquire(pevent[i])) {
+                    ret = WAIT_OBJECT_0 + i;
+                    break;
+                }
+            }
+        } else if (std::all_of(pevent, pevent + count, [](Event *event) { return event->state.load() != 0; })) {
+            //自動リセットのイベントを非シグナル状態に戻す
+            //途中でほかのスレッドに取られた場合は、取得済みのものを戻して再度待機する
+            uint32_t acquired = 0;
+            for (; acquired < count; acquired++) {
+                if (!event_try_acquire(pevent[acquired])) {
+                    break;
+                }
+            }
+            if (acquired == count) {
+                ret = WAIT_OBJECT_0;
+            } else {
+                for (uint32_t i = 0; i < acquired; i++) {
+                    if (!pevent[i]->bManualReset) {
+                        SetEvent(pevent[i]);
+                    }
+                }
+            }
+        }
+        struct timespec *timeout = nullptr;
+        if (ret != WAIT_TIMEOUT || !deadline.remaining(&timeout)) {
+            break;
         }
+        futex_wait(&g_eventSetSeq, seq, timeout);
     }
-    return (bTimeout) ? WAIT_TIMEOUT : (WAIT_OBJECT_0 + success);
+    g_eventMultiWaiters.fetch_sub(1);
+    return ret;
 }
 #endif //#if !(defined(_WIN32) || defined(_WIN64))
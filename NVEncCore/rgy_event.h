@@ -55,7 +55,8 @@ void CloseEvent(HANDLE ev);
 
 uint32_t WaitForSingleObject(HANDLE ev, uint32_t millisec);
 
-uint32_t WaitForMultipleObjects(uint32_t count, HANDLE *pev, int dummy, uint32_t millisec);
+//bWaitAll = FALSEならいずれか1つ、TRUEならすべてのイベントがシグナル状態になるまで待機する
+uint32_t WaitForMultipleObjects(uint32_t count, HANDLE *pev, int bWaitAll, uint32_t millisec);
 
 #endif //#if defined(_WIN32) || defined(_WIN64)
 
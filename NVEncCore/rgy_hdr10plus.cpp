@@ -25,76 +25,467 @@
 //
 // --------------------------------------------------------------------------------------------
 
-#define WIN32_LEAN_AND_MEAN
-#define NOMINMAX
-#include <Windows.h>
-#include <fcntl.h>
-#include <io.h>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include "rgy_osdep.h"
 #include "rgy_hdr10plus.h"
+#include "rgy_bitstream.h"
 
-const TCHAR *RGYHDR10Plus::HDR10PLUS_GEN_EXE_NAME =  _T("hdr10plus_gen.exe");
+//jsonの値 (HDR10+のメタデータの読み込みに必要な最低限の実装)
+struct RGYJsonValue {
+    enum Type {
+        JSON_NULL,
+        JSON_BOOL,
+        JSON_NUMBER,
+        JSON_STRING,
+        JSON_ARRAY,
+        JSON_OBJECT,
+    };
+    Type type;
+    double num;
+    std::string str;
+    std::vector<RGYJsonValue> arr;
+    std::vector<std::pair<std::string, RGYJsonValue>> obj;
+
+    RGYJsonValue() : type(JSON_NULL), num(0.0), str(), arr(), obj() {};
+    void clear() {
+        type = JSON_NULL;
+        num = 0.0;
+        str.clear();
+        arr.clear();
+        obj.clear();
+    }
+    const RGYJsonValue *find(const char *key) const {
+        if (type != JSON_OBJECT) {
+            return nullptr;
+        }
+        for (const auto& item : obj) {
+            if (item.first == key) {
+                return &item.second;
+            }
+        }
+        return nullptr;
+    }
+};
+
+class RGYJsonReader {
+public:
+    RGYJsonReader(const char *ptr, const char *fin) : m_start(ptr), m_ptr(ptr), m_fin(fin) {};
+
+    //次の空白以外の文字を返す (終端なら'\0')
+    char peek() {
+        while (m_ptr < m_fin && (*m_ptr == ' ' || *m_ptr == '\t' || *m_ptr == '\r' || *m_ptr == '\n')) {
+            m_ptr++;
+        }
+        return (m_ptr < m_fin) ? *m_ptr : '\0';
+    }
+    bool consume(char c) {
+        if (peek() != c) {
+            return false;
+        }
+        m_ptr++;
+        return true;
+    }
+    size_t pos() const { return m_ptr - m_start; }
+
+    bool parseString(std::string& str) {
+        if (!consume('"')) {
+            return false;
+        }
+        str.clear();
+        while (m_ptr < m_fin) {
+            const char c = *m_ptr++;
+            if (c == '"') {
+                return true;
+            } else if (c != '\\') {
+                str.push_back(c);
+                continue;
+            }
+            if (m_ptr >= m_fin) {
+                return false;
+            }
+            switch (*m_ptr++) {
+            case '"':  str.push_back('"');  break;
+            case '\\': str.push_back('\\'); break;
+            case '/':  str.push_back('/');  break;
+            case 'b':  str.push_back('\b'); break;
+            case 'f':  str.push_back('\f'); break;
+            case 'n':  str.push_back('\n'); break;
+            case 'r':  str.push_back('\r'); break;
+            case 't':  str.push_back('\t'); break;
+            case 'u': {
+                if (m_fin - m_ptr < 4) {
+                    return false;
+                }
+                uint32_t code = 0;
+                for (int i = 0; i < 4; i++) {
+                    const char h = *m_ptr++;
+                    code <<= 4;
+                    if ('0' <= h && h <= '9')      code |= h - '0';
+                    else if ('a' <= h && h <= 'f') code |= h - 'a' + 10;
+                    else if ('A' <= h && h <= 'F') code |= h - 'A' + 10;
+                    else return false;
+                }
+                //キー名はASCIIのみなので、サロゲートペアは結合せずそのままUTF-8にする
+                if (code < 0x80) {
+                    str.push_back((char)code);
+                } else if (code < 0x800) {
+                    str.push_back((char)(0xC0 | (code >> 6)));
+                    str.push_back((char)(0x80 | (code & 0x3F)));
+                } else {
+                    str.push_back((char)(0xE0 | (code >> 12)));
+                    str.push_back((char)(0x80 | ((code >> 6) & 0x3F)));
+                    str.push_back((char)(0x80 | (code & 0x3F)));
+                }
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    bool parseValue(RGYJsonValue& value, int depth = 0) {
+        //不正なjsonでスタックを使い切らないよう、ネストの深さを制限する
+        if (depth > 64) {
+            return false;
+        }
+        const char c = peek();
+        if (c == '{') {
+            m_ptr++;
+            value.type = RGYJsonValue::JSON_OBJECT;
+            if (consume('}')) {
+                return true;
+            }
+            do {
+                value.obj.push_back(std::make_pair(std::string(), RGYJsonValue()));
+                auto& item = value.obj.back();
+                if (!parseString(item.first) || !consume(':') || !parseValue(item.second, depth + 1)) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume('}');
+        } else if (c == '[') {
+            m_ptr++;
+            value.type = RGYJsonValue::JSON_ARRAY;
+            if (consume(']')) {
+                return true;
+            }
+            do {
+                value.arr.push_back(RGYJsonValue());
+                if (!parseValue(value.arr.back(), depth + 1)) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(']');
+        } else if (c == '"') {
+            value.type = RGYJsonValue::JSON_STRING;
+            return parseString(value.str);
+        } else if (c == 't' || c == 'f' || c == 'n') {
+            const char *literal = (c == 't') ? "true" : ((c == 'f') ? "false" : "null");
+            const size_t len = strlen(literal);
+            if ((size_t)(m_fin - m_ptr) < len || strncmp(m_ptr, literal, len) != 0) {
+                return false;
+            }
+            m_ptr += len;
+            value.type = (c == 'n') ? RGYJsonValue::JSON_NULL : RGYJsonValue::JSON_BOOL;
+            value.num = (c == 't') ? 1.0 : 0.0;
+            return true;
+        }
+        char buf[64];
+        size_t len = 0;
+        while (m_ptr < m_fin && len < _countof(buf) - 1
+            && (('0' <= *m_ptr && *m_ptr <= '9') || *m_ptr == '-' || *m_ptr == '+' || *m_ptr == '.' || *m_ptr == 'e' || *m_ptr == 'E')) {
+            buf[len++] = *m_ptr++;
+        }
+        buf[len] = '\0';
+        char *end = nullptr;
+        value.type = RGYJsonValue::JSON_NUMBER;
+        value.num = strtod(buf, &end);
+        return len > 0 && end == buf + len;
+    }
+private:
+    const char *m_start;
+    const char *m_ptr;
+    const char *m_fin;
+};
+
+//jsonの数値を、指定ビット数に収まる非負整数として取得する
+static bool json_to_uint(const RGYJsonValue *value, int bits, uint32_t& dst) {
+    if (value == nullptr || value->type != RGYJsonValue::JSON_NUMBER) {
+        return false;
+    }
+    const double v = std::round(value->num);
+    if (v < 0.0 || v >= (double)((uint64_t)1 << bits)) {
+        return false;
+    }
+    dst = (uint32_t)v;
+    return true;
+}
 
 RGYHDR10Plus::RGYHDR10Plus() :
-    m_proc(), m_pipes(),
-    m_fpStdOut(std::unique_ptr<FILE, decltype(&fclose)>(nullptr, fclose)),
-    m_buffer(std::make_pair(-1, vector<uint8_t>())){
+    m_inputJson(),
+    m_errMes(),
+    m_frames(),
+    m_frameIdx(),
+    m_buffer(std::make_pair(-1, vector<uint8_t>())) {
 }
 
 RGYHDR10Plus::~RGYHDR10Plus() {
-    m_fpStdOut.reset();
-    m_proc.reset();
 }
 
 RGY_ERR RGYHDR10Plus::init(const tstring &inputJson) {
-    if (!(PathFileExists(inputJson.c_str()))) {
-        return RGY_ERR_NOT_FOUND;
-    }
     m_inputJson = inputJson;
-    const tstring HDR10PlusGenExePath = (PathFileExists(HDR10PLUS_GEN_EXE_NAME)) ? HDR10PLUS_GEN_EXE_NAME : getExeDir() + _T("\\") + HDR10PLUS_GEN_EXE_NAME;
-    if (!(PathFileExists(HDR10PlusGenExePath.c_str()))) {
-        return RGY_ERR_NOT_FOUND;
-    }
-    const tstring HDR10PlusGenExePathWithQuotes = tstring(_T("\"")) + HDR10PlusGenExePath + _T("\"");
-    const tstring inputJsonWithQuotes = tstring(_T("\"")) + inputJson + _T("\"");
-    std::vector<const TCHAR *> args;
-    args.push_back(HDR10PlusGenExePathWithQuotes.c_str());
-    args.push_back(_T("-i"));
-    args.push_back(inputJsonWithQuotes.c_str());
-    args.push_back(_T("-o"));
-    args.push_back(_T("-"));
-
-    m_pipes.stdOut.mode = PIPE_MODE_ENABLE;
-    m_pipes.stdOut.bufferSize = 1024;
-
-    m_proc = std::make_unique<RGYPipeProcessWin>();
-    m_proc->init();
-    if (m_proc->run(args, nullptr, &m_pipes, 0, true, true)) {
-        return RGY_ERR_RUN_PROCESS;
-    }
-    m_fpStdOut = std::unique_ptr<FILE, decltype(&fclose)>(_fdopen(_open_osfhandle((intptr_t)m_pipes.stdOut.h_read, _O_BINARY), "rb"), fclose);
-    if (!m_fpStdOut) {
-        return RGY_ERR_INVALID_HANDLE;
+    std::unique_ptr<FILE, decltype(&fclose)> fp(_tfopen(inputJson.c_str(), _T("rb")), fclose);
+    if (!fp) {
+        m_errMes = strsprintf(_T("Failed to open \"%s\".\n"), inputJson.c_str());
+        return RGY_ERR_FILE_OPEN;
+    }
+    _fseeki64(fp.get(), 0, SEEK_END);
+    const int64_t fileSize = _ftelli64(fp.get());
+    _fseeki64(fp.get(), 0, SEEK_SET);
+    if (fileSize <= 0) {
+        m_errMes = strsprintf(_T("\"%s\" is empty.\n"), inputJson.c_str());
+        return RGY_ERR_INVALID_FORMAT;
+    }
+    std::string json((size_t)fileSize, '\0');
+    if (fread(&json[0], 1, json.size(), fp.get()) != json.size()) {
+        m_errMes = strsprintf(_T("Failed to read \"%s\".\n"), inputJson.c_str());
+        return RGY_ERR_UNKNOWN;
+    }
+    fp.reset();
+    //UTF-8 BOMは読み飛ばす
+    if (json.size() >= 3 && memcmp(json.data(), "\xEF\xBB\xBF", 3) == 0) {
+        json.erase(0, 3);
+    }
+    auto sts = parseJson(json);
+    if (sts != RGY_ERR_NONE) {
+        return sts;
+    }
+    if (m_frames.size() == 0) {
+        m_errMes = strsprintf(_T("No HDR10+ metadata found in \"%s\".\n"), inputJson.c_str());
+        return RGY_ERR_INVALID_FORMAT;
     }
     return RGY_ERR_NONE;
 }
 
-const vector<uint8_t> *RGYHDR10Plus::getData(int iframe) {
-    if (!m_fpStdOut) {
-        return nullptr;
+RGY_ERR RGYHDR10Plus::parseJson(const std::string& json) {
+    RGYJsonReader reader(json.data(), json.data() + json.size());
+    auto parseError = [&]() {
+        m_errMes = strsprintf(_T("Failed to parse json at byte %llu.\n"), (unsigned long long)reader.pos());
+        return RGY_ERR_INVALID_FORMAT;
+    };
+    //json全体を展開するとメモリを大量に消費するので、
+    //SceneInfoの要素 (1フレーム分) ごとに読み込んでメタデータに変換し、破棄する
+    auto parseSceneInfo = [&]() {
+        if (!reader.consume('[')) {
+            return parseError();
+        }
+        if (reader.consume(']')) {
+            return RGY_ERR_NONE;
+        }
+        RGYJsonValue sceneInfo;
+        int sceneIdx = 0;
+        do {
+            sceneInfo.clear();
+            if (!reader.parseValue(sceneInfo)) {
+                return parseError();
+            }
+            auto sts = addFrame(sceneInfo, sceneIdx++);
+            if (sts != RGY_ERR_NONE) {
+                return sts;
+            }
+        } while (reader.consume(','));
+        return reader.consume(']') ? RGY_ERR_NONE : parseError();
+    };
+
+    RGY_ERR sts = RGY_ERR_NONE;
+    if (reader.peek() == '[') {
+        //フレームごとのメタデータの配列のみからなるjson
+        sts = parseSceneInfo();
+    } else if (reader.consume('{')) {
+        //HDR10+ LLC形式のjson (JSONInfo, SceneInfo, SceneInfoSummary, ToolInfo)
+        if (!reader.consume('}')) {
+            std::string key;
+            RGYJsonValue skip;
+            do {
+                if (!reader.parseString(key) || !reader.consume(':')) {
+                    return parseError();
+                }
+                if (key == "SceneInfo") {
+                    sts = parseSceneInfo();
+                } else {
+                    skip.clear();
+                    if (!reader.parseValue(skip)) {
+                        return parseError();
+                    }
+                }
+            } while (sts == RGY_ERR_NONE && reader.consume(','));
+            if (sts == RGY_ERR_NONE && !reader.consume('}')) {
+                return parseError();
+            }
+        }
+    } else {
+        return parseError();
     }
-    while (m_buffer.first != iframe) {
-        m_buffer.second.clear();
-        int header[2];
-        if (fread(header, sizeof(header[0]), _countof(header), m_fpStdOut.get()) != _countof(header)) {
-            return nullptr;
+    if (sts == RGY_ERR_NONE && reader.peek() != '\0') {
+        return parseError();
+    }
+    return sts;
+}
+
+RGY_ERR RGYHDR10Plus::addFrame(const RGYJsonValue& sceneInfo, int sceneIdx) {
+    auto invalidValue = [&](const char *name) {
+        m_errMes = strsprintf(_T("Invalid or missing \"%s\" in SceneInfo[%d].\n"), char_to_tstring(name).c_str(), sceneIdx);
+        return RGY_ERR_INVALID_FORMAT;
+    };
+    if (sceneInfo.type != RGYJsonValue::JSON_OBJECT) {
+        return invalidValue("SceneInfo");
+    }
+    RGYHDR10PlusFrame frame;
+    memset(&frame, 0, sizeof(frame));
+
+    if (const auto numWindows = sceneInfo.find("NumberOfWindows")) {
+        uint32_t value = 0;
+        if (!json_to_uint(numWindows, 2, value) || value == 0) {
+            return invalidValue("NumberOfWindows");
         }
-        const int frameNum = header[0];
-        const int dataSize = header[1];
-        m_buffer.second.resize(dataSize, 0);
-        if (fread(m_buffer.second.data(), 1, m_buffer.second.size(), m_fpStdOut.get()) != m_buffer.second.size()) {
-            return nullptr;
+        if (value > 1) {
+            m_errMes = strsprintf(_T("NumberOfWindows > 1 is not supported (SceneInfo[%d]).\n"), sceneIdx);
+            return RGY_ERR_UNSUPPORTED;
+        }
+    }
+    if (!json_to_uint(sceneInfo.find("TargetedSystemDisplayMaximumLuminance"), 27, frame.targetedSystemDisplayMaximumLuminance)) {
+        return invalidValue("TargetedSystemDisplayMaximumLuminance");
+    }
+    const auto luminance = sceneInfo.find("LuminanceParameters");
+    if (luminance == nullptr || luminance->type != RGYJsonValue::JSON_OBJECT) {
+        return invalidValue("LuminanceParameters");
+    }
+    const auto maxscl = luminance->find("MaxScl");
+    if (maxscl == nullptr || maxscl->type != RGYJsonValue::JSON_ARRAY || maxscl->arr.size() != _countof(frame.maxscl)) {
+        return invalidValue("MaxScl");
+    }
+    for (size_t i = 0; i < _countof(frame.maxscl); i++) {
+        if (!json_to_uint(&maxscl->arr[i], 17, frame.maxscl[i])) {
+            return invalidValue("MaxScl");
+        }
+    }
+    if (!json_to_uint(luminance->find("AverageRGB"), 17, frame.averageMaxrgb)) {
+        return invalidValue("AverageRGB");
+    }
+    if (const auto distributions = luminance->find("LuminanceDistributions")) {
+        const auto distIndex = distributions->find("DistributionIndex");
+        const auto distValues = distributions->find("DistributionValues");
+        if (distIndex == nullptr || distIndex->type != RGYJsonValue::JSON_ARRAY
+            || distValues == nullptr || distValues->type != RGYJsonValue::JSON_ARRAY
+            || distIndex->arr.size() != distValues->arr.size()
+            || distIndex->arr.size() > RGY_HDR10PLUS_MAX_DISTRIBUTIONS) {
+            return invalidValue("LuminanceDistributions");
+        }
+        frame.numDistributions = (uint8_t)distIndex->arr.size();
+        for (int i = 0; i < frame.numDistributions; i++) {
+            uint32_t percentage = 0;
+            if (!json_to_uint(&distIndex->arr[i], 7, percentage) || percentage > 100) {
+                return invalidValue("DistributionIndex");
+            }
+            frame.distributionPercentages[i] = (uint8_t)percentage;
+            if (!json_to_uint(&distValues->arr[i], 17, frame.distributionPercentiles[i])) {
+                return invalidValue("DistributionValues");
+            }
+        }
+    }
+    //BezierCurveDataがあればtone mappingを有効にする (HDR10+ profile B)
+    if (const auto bezier = sceneInfo.find("BezierCurveData")) {
+        uint32_t kneePointX = 0, kneePointY = 0;
+        if (!json_to_uint(bezier->find("KneePointX"), 12, kneePointX)) {
+            return invalidValue("KneePointX");
+        }
+        if (!json_to_uint(bezier->find("KneePointY"), 12, kneePointY)) {
+            return invalidValue("KneePointY");
+        }
+        const auto anchors = bezier->find("Anchors");
+        if (anchors == nullptr || anchors->type != RGYJsonValue::JSON_ARRAY || anchors->arr.size() > RGY_HDR10PLUS_MAX_BEZIER_ANCHORS) {
+            return invalidValue("Anchors");
         }
-        m_buffer.first = frameNum;
+        frame.toneMapping = true;
+        frame.kneePointX = (uint16_t)kneePointX;
+        frame.kneePointY = (uint16_t)kneePointY;
+        frame.numBezierCurveAnchors = (uint8_t)anchors->arr.size();
+        for (int i = 0; i < frame.numBezierCurveAnchors; i++) {
+            uint32_t anchor = 0;
+            if (!json_to_uint(&anchors->arr[i], 10, anchor)) {
+                return invalidValue("Anchors");
+            }
+            frame.bezierCurveAnchors[i] = (uint16_t)anchor;
+        }
+    }
+
+    //SequenceFrameIndexがあればそれをフレーム番号とし、なければ配列の順番をフレーム番号とする
+    uint32_t frameIdx = (uint32_t)sceneIdx;
+    if (const auto sequenceFrameIndex = sceneInfo.find("SequenceFrameIndex")) {
+        if (!json_to_uint(sequenceFrameIndex, 24, frameIdx)) {
+            return invalidValue("SequenceFrameIndex");
+        }
+    }
+    if (m_frameIdx.size() <= frameIdx) {
+        m_frameIdx.resize(frameIdx + 1, -1);
+    }
+    if (m_frameIdx[frameIdx] >= 0) {
+        m_errMes = strsprintf(_T("Duplicate metadata for frame %u (SceneInfo[%d]).\n"), frameIdx, sceneIdx);
+        return RGY_ERR_INVALID_FORMAT;
+    }
+    m_frameIdx[frameIdx] = (int)m_frames.size();
+    m_frames.push_back(frame);
+    return RGY_ERR_NONE;
+}
+
+//ST 2094-40 のuser_data_registered_itu_t_t35 (itu_t_t35_country_codeから)
+void RGYHDR10Plus::genPayload(const RGYHDR10PlusFrame& frame, vector<uint8_t>& payload) const {
+    payload.clear();
+    RGYBitWriter writer(payload);
+    writer.put(0xB5, 8);   // itu_t_t35_country_code
+    writer.put(0x003C, 16);// itu_t_t35_terminal_provider_code
+    writer.put(0x0001, 16);// itu_t_t35_terminal_provider_oriented_code
+    writer.put(4, 8);      // application_identifier
+    writer.put(1, 8);      // application_version
+    writer.put(1, 2);      // num_windows
+    writer.put(frame.targetedSystemDisplayMaximumLuminance, 27);
+    writer.put(0, 1);      // targeted_system_display_actual_peak_luminance_flag
+    for (int i = 0; i < (int)_countof(frame.maxscl); i++) {
+        writer.put(frame.maxscl[i], 17);
+    }
+    writer.put(frame.averageMaxrgb, 17);
+    writer.put(frame.numDistributions, 4);
+    for (int i = 0; i < frame.numDistributions; i++) {
+        writer.put(frame.distributionPercentages[i], 7);
+        writer.put(frame.distributionPercentiles[i], 17);
+    }
+    writer.put(0, 10);     // fraction_bright_pixels
+    writer.put(0, 1);      // mastering_display_actual_peak_luminance_flag
+    writer.put(frame.toneMapping ? 1 : 0, 1);
+    if (frame.toneMapping) {
+        writer.put(frame.kneePointX, 12);
+        writer.put(frame.kneePointY, 12);
+        writer.put(frame.numBezierCurveAnchors, 4);
+        for (int i = 0; i < frame.numBezierCurveAnchors; i++) {
+            writer.put(frame.bezierCurveAnchors[i], 10);
+        }
+    }
+    writer.put(0, 1);      // color_saturation_mapping_flag
+}
+
+const vector<uint8_t> *RGYHDR10Plus::getData(int iframe) {
+    if (iframe < 0 || iframe >= (int)m_frameIdx.size() || m_frameIdx[iframe] < 0) {
+        return nullptr;
+    }
+    //payloadは要求されたときに生成し、直前のフレームの結果は保持しておく
+    if (m_buffer.first != iframe) {
+        genPayload(m_frames[m_frameIdx[iframe]], m_buffer.second);
+        m_buffer.first = iframe;
     }
     return &m_buffer.second;
 }
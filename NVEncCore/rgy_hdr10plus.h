@@ -30,25 +30,52 @@
 #define __RGY_HDR10PLUS_H__
 
 #include <string>
+#include <vector>
 #include <memory>
 #include "rgy_err.h"
-#include "rgy_pipe.h"
 #include "rgy_util.h"
 
+static const int RGY_HDR10PLUS_MAX_DISTRIBUTIONS = 15;
+static const int RGY_HDR10PLUS_MAX_BEZIER_ANCHORS = 15;
+
+//HDR10+ (SMPTE ST 2094-40) の1フレーム分のメタデータ
+struct RGYHDR10PlusFrame {
+    uint32_t targetedSystemDisplayMaximumLuminance;
+    uint32_t maxscl[3];
+    uint32_t averageMaxrgb;
+    uint8_t  numDistributions;
+    uint8_t  distributionPercentages[RGY_HDR10PLUS_MAX_DISTRIBUTIONS];
+    uint32_t distributionPercentiles[RGY_HDR10PLUS_MAX_DISTRIBUTIONS];
+    bool     toneMapping;
+    uint16_t kneePointX;
+    uint16_t kneePointY;
+    uint8_t  numBezierCurveAnchors;
+    uint16_t bezierCurveAnchors[RGY_HDR10PLUS_MAX_BEZIER_ANCHORS];
+};
+
+struct RGYJsonValue;
+
 class RGYHDR10Plus {
 public:
-    static const TCHAR *HDR10PLUS_GEN_EXE_NAME;
     RGYHDR10Plus();
     virtual ~RGYHDR10Plus();
 
+    //jsonファイルを読み込み、フレームごとのメタデータの一覧を作成する
     RGY_ERR init(const tstring& inputJson);
+    //指定フレームのuser_data_registered_itu_t_t35のpayloadを返す
     const vector<uint8_t> *getData(int iframe);
     const tstring &inputJson() const { return m_inputJson; };
+    const tstring &errMes() const { return m_errMes; };
+    int frameCount() const { return (int)m_frameIdx.size(); };
 protected:
+    RGY_ERR parseJson(const std::string& json);
+    RGY_ERR addFrame(const RGYJsonValue& sceneInfo, int sceneIdx);
+    void genPayload(const RGYHDR10PlusFrame& frame, vector<uint8_t>& payload) const;
+
     tstring m_inputJson;
-    std::unique_ptr<RGYPipeProcess> m_proc;
-    ProcessPipe m_pipes;
-    std::unique_ptr<FILE, decltype(&fclose)> m_fpStdOut;
+    tstring m_errMes;
+    std::vector<RGYHDR10PlusFrame> m_frames; //jsonから読み込んだメタデータ
+    std::vector<int> m_frameIdx;             //フレーム番号 -> m_framesのindex (メタデータがなければ-1)
     std::pair<int, std::vector<uint8_t>> m_buffer;
 };
 
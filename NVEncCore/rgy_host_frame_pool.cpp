@@ -0,0 +1,225 @@
+﻿// -----------------------------------------------------------------------------------------
+// QSVEnc/NVEnc by rigaya
+// -----------------------------------------------------------------------------------------
+// The MIT License
+//
+// Copyright (c) 2011-2016 rigaya
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// --------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include "rgy_osdep.h"
+#include "rgy_host_frame_pool.h"
+#if !(defined(_WIN32) || defined(_WIN64))
+#include <sys/mman.h>
+#endif
+
+static const size_t RGY_HOST_PAGE_SIZE = 4096;
+static const size_t RGY_HOST_HUGE_PAGE_SIZE = (size_t)2 << 20;
+static const size_t RGY_HOST_POOL_KEEP_BYTES = (size_t)256 << 20; //reserveとは別に、未使用のまま保持するバッファの上限
+
+RGYHostFramePool::RGYHostFramePool() :
+    m_mtx(),
+    m_hugePage(RGY_HOST_HUGEPAGE_AUTO),
+    m_pin(),
+    m_unpin(),
+    m_free(),
+    m_freeBytes(0),
+    m_reservedBytes(0),
+    m_stats() {
+}
+
+RGYHostFramePool::~RGYHostFramePool() {
+    clear();
+}
+
+RGYHostFramePool *RGYHostFramePool::get() {
+    //取得したバッファの解放時にプールを参照するので、
+    //静的オブジェクトの破棄順に依存しないよう、あえて破棄せずプロセスの終了とともに破棄させる
+    static RGYHostFramePool *pool = new RGYHostFramePool();
+    return pool;
+}
+
+void RGYHostFramePool::setHugePage(RGYHostHugePage mode) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_hugePage = mode;
+}
+
+void RGYHostFramePool::setPinFunc(std::function<bool(void *ptr, size_t size)> pin, std::function<void(void *ptr)> unpin) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_pin = pin;
+    m_unpin = unpin;
+}
+
+size_t RGYHostFramePool::roundSize(size_t size) const {
+    //huge pageを使う場合は、huge pageの境界までを同じバッファとして扱う
+    const size_t unit = (m_hugePage != RGY_HOST_HUGEPAGE_OFF && size >= RGY_HOST_HUGE_PAGE_SIZE) ? RGY_HOST_HUGE_PAGE_SIZE : RGY_HOST_PAGE_SIZE;
+    return (std::max<size_t>(size, 1) + unit - 1) & ~(unit - 1);
+}
+
+bool RGYHostFramePool::sysAlloc(Block& block, size_t size) {
+    block.ptr = nullptr;
+    block.size = size;
+    block.hugepage = false;
+    block.pinned = false;
+    const bool huge = m_hugePage != RGY_HOST_HUGEPAGE_OFF && size >= RGY_HOST_HUGE_PAGE_SIZE;
+    if (huge && m_hugePage == RGY_HOST_HUGEPAGE_ON) {
+#if defined(_WIN32) || defined(_WIN64)
+        //SeLockMemoryPrivilegeがない場合は失敗するので、その場合は通常の確保に切り替える
+        const size_t large_page = GetLargePageMinimum();
+        if (large_page > 0 && size % large_page == 0) {
+            block.ptr = (uint8_t *)VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        }
+#elif defined(MAP_HUGETLB)
+        //huge pageが予約されていない場合は失敗するので、その場合は通常の確保に切り替える
+        void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        block.ptr = (ptr != MAP_FAILED) ? (uint8_t *)ptr : nullptr;
+#endif
+        if (block.ptr) {
+            block.hugepage = true;
+            m_stats.hugepage_bytes += size;
+        }
+    }
+    if (block.ptr == nullptr) {
+        block.ptr = (uint8_t *)_aligned_malloc(size, (huge) ? RGY_HOST_HUGE_PAGE_SIZE : RGY_HOST_PAGE_SIZE);
+        if (block.ptr == nullptr) {
+            return false;
+        }
+#if !(defined(_WIN32) || defined(_WIN64)) && defined(MADV_HUGEPAGE)
+        if (huge) {
+            madvise(block.ptr, size, MADV_HUGEPAGE);
+        }
+#endif
+    }
+    m_stats.sys_alloc_count++;
+    m_stats.sys_alloc_bytes += size;
+    return true;
+}
+
+void RGYHostFramePool::sysFree(Block& block) {
+    if (block.pinned && m_unpin) {
+        m_unpin(block.ptr);
+    }
+    if (block.hugepage) {
+#if defined(_WIN32) || defined(_WIN64)
+        VirtualFree(block.ptr, 0, MEM_RELEASE);
+#else
+        munmap(block.ptr, block.size);
+#endif
+    } else {
+        _aligned_free(block.ptr);
+    }
+    block.ptr = nullptr;
+}
+
+bool RGYHostFramePool::pin(Block& block) {
+    if (!m_pin || !m_pin(block.ptr, block.size)) {
+        return false;
+    }
+    block.pinned = true;
+    m_stats.pinned_bytes += block.size;
+    return true;
+}
+
+void RGYHostFramePool::release(const Block& block) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_free.push_back(block);
+    m_freeBytes += block.size;
+    //上限を超えたら、古いものから解放する
+    const size_t keep_bytes = std::max(m_reservedBytes, RGY_HOST_POOL_KEEP_BYTES);
+    while (m_freeBytes > keep_bytes && m_free.size() > 0) {
+        m_freeBytes -= m_free.front().size;
+        sysFree(m_free.front());
+        m_free.erase(m_free.begin());
+    }
+}
+
+std::shared_ptr<uint8_t> RGYHostFramePool::wrap(const Block& block) {
+    return std::shared_ptr<uint8_t>(block.ptr, [this, block](uint8_t *) { release(block); });
+}
+
+bool RGYHostFramePool::reserve(size_t size, int count, bool pinned) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    const size_t block_size = roundSize(size);
+    m_reservedBytes += block_size * count;
+    int available = (int)std::count_if(m_free.begin(), m_free.end(), [block_size, pinned](const Block& block) {
+        return block.size == block_size && block.pinned == pinned;
+    });
+    for (; available < count; available++) {
+        Block block;
+        if (!sysAlloc(block, block_size)) {
+            return false;
+        }
+        if (pinned && !pin(block)) {
+            sysFree(block);
+            return false;
+        }
+        m_free.push_back(block);
+        m_freeBytes += block.size;
+    }
+    return true;
+}
+
+std::shared_ptr<uint8_t> RGYHostFramePool::alloc(size_t size, bool pinned) {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    m_stats.alloc_count++;
+    const size_t block_size = roundSize(size);
+    //同じサイズのものを新しいものから探す (ページロックの有無が一致するものを優先する)
+    //ページロックしたバッファは、ページロック不要の要求には渡さない
+    //そうでないと、clear()やsetPinFunc(nullptr)の後まで残ったり、想定外のスレッドでunpinされたりする
+    auto found = m_free.rend();
+    for (auto it = m_free.rbegin(); it != m_free.rend(); it++) {
+        if (it->size == block_size && (it->pinned == pinned || (pinned && found == m_free.rend()))) {
+            found = it;
+            if (found->pinned == pinned) break;
+        }
+    }
+    Block block;
+    if (found != m_free.rend()) {
+        block = *found;
+        m_free.erase(std::next(found).base());
+        m_freeBytes -= block.size;
+        m_stats.reuse_count++;
+    } else if (!sysAlloc(block, block_size)) {
+        return nullptr;
+    }
+    if (pinned && !block.pinned && !pin(block)) {
+        m_free.push_back(block);
+        m_freeBytes += block.size;
+        return nullptr;
+    }
+    return wrap(block);
+}
+
+void RGYHostFramePool::clear() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    for (auto& block : m_free) {
+        sysFree(block);
+    }
+    m_free.clear();
+    m_freeBytes = 0;
+    m_reservedBytes = 0;
+}
+
+RGYHostFramePoolStats RGYHostFramePool::stats() {
+    std::lock_guard<std::mutex> lock(m_mtx);
+    return m_stats;
+}
@@ -0,0 +1,110 @@
+﻿// -----------------------------------------------------------------------------------------
+// QSVEnc/NVEnc by rigaya
+// -----------------------------------------------------------------------------------------
+// The MIT License
+//
+// Copyright (c) 2011-2016 rigaya
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// --------------------------------------------------------------------------------------------
+
+#pragma once
+#ifndef __RGY_HOST_FRAME_POOL_H__
+#define __RGY_HOST_FRAME_POOL_H__
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <functional>
+
+//ホスト側フレームバッファのhuge pageの使用方法
+enum RGYHostHugePage : int {
+    RGY_HOST_HUGEPAGE_OFF = 0,  //通常のページで確保する
+    RGY_HOST_HUGEPAGE_AUTO,     //transparent huge pageを使用する (Linuxのみ、2MB以上のバッファ)
+    RGY_HOST_HUGEPAGE_ON,       //明示的にhuge pageで確保し、失敗したらautoと同じ動作とする
+};
+
+struct RGYHostFramePoolStats {
+    uint64_t alloc_count;     //確保要求の回数
+    uint64_t reuse_count;     //プールから再利用した回数
+    uint64_t sys_alloc_count; //システムから確保した回数
+    uint64_t sys_alloc_bytes; //システムから確保したバイト数
+    uint64_t hugepage_bytes;  //そのうち、明示的にhuge pageで確保できたバイト数
+    uint64_t pinned_bytes;    //そのうち、ページロックしたバイト数
+};
+
+//入力フレームや読み込み・書き出し用の作業領域など、フレーム単位のホスト側バッファのプール
+//各コンポーネントがばらばらに確保していたバッファをここから取得することで、
+//huge pageによるTLBミスの削減や、ページロックによるDMA転送の効率化をまとめて適用する
+//取得したバッファはshared_ptrの解放時にプールに戻り、同じサイズの要求で再利用される
+class RGYHostFramePool {
+public:
+    //プロセス全体で共有するプールを取得する (初回呼び出し時に作成)
+    static RGYHostFramePool *get();
+
+    //以降にシステムから確保するバッファのhuge pageの使用方法を設定する
+    void setHugePage(RGYHostHugePage mode);
+
+    //ページロックを行う関数を設定する (CUDAのcudaHostRegisterなど)
+    //pinはpinned=trueで要求されたバッファの確保時に、unpinはそのバッファをシステムに返却する際に呼ばれる
+    void setPinFunc(std::function<bool(void *ptr, size_t size)> pin, std::function<void(void *ptr)> unpin);
+
+    //sizeバイト以上のバッファをcount個確保してプールに保持しておく (パイプラインの深さ分を事前に確保する)
+    bool reserve(size_t size, int count, bool pinned);
+
+    //sizeバイト以上のバッファを取得する (ページ境界にアライン)
+    //pinned=trueの場合、ページロックできなければnullptrを返す
+    std::shared_ptr<uint8_t> alloc(size_t size, bool pinned = false);
+
+    //プールに保持している未使用のバッファをすべてシステムに返却する
+    //ページロックしたバッファはunpinしてから解放するので、デバイスの破棄前に呼ぶ必要がある
+    void clear();
+
+    RGYHostFramePoolStats stats();
+protected:
+    RGYHostFramePool();
+    ~RGYHostFramePool();
+
+    struct Block {
+        uint8_t *ptr;
+        size_t size;
+        bool hugepage; //明示的にhuge pageで確保したか
+        bool pinned;   //ページロックしたか
+    };
+    size_t roundSize(size_t size) const;
+    bool sysAlloc(Block& block, size_t size);
+    void sysFree(Block& block);
+    bool pin(Block& block);
+    void release(const Block& block);
+    std::shared_ptr<uint8_t> wrap(const Block& block);
+
+    std::mutex m_mtx;
+    RGYHostHugePage m_hugePage;
+    std::function<bool(void *ptr, size_t size)> m_pin;
+    std::function<void(void *ptr)> m_unpin;
+    std::vector<Block> m_free;  //未使用のバッファ
+    size_t m_freeBytes;         //未使用のバッファの合計サイズ
+    size_t m_reservedBytes;     //reserveで要求された合計サイズ (これを超えて未使用のバッファを保持しない)
+    RGYHostFramePoolStats m_stats;
+};
+
+#endif //__RGY_HOST_FRAME_POOL_H__
@@ -29,24 +29,13 @@
 #include <iostream>
 #include <fstream>
 #include <set>
+#include <algorithm>
 #include "rgy_input.h"
 #include "cpu_info.h"
+#include "rgy_thread_pool.h"
 
-RGYConvertCSPPrm::RGYConvertCSPPrm() :
-    abort(false),
-    dst(nullptr),
-    src(nullptr),
-    interlaced(false),
-    width(0),
-    src_y_pitch_byte(0),
-    src_uv_pitch_byte(0),
-    dst_y_pitch_byte(0),
-    height(0),
-    dst_height(0),
-    crop(nullptr) {
-
-}
-
+//L2キャッシュの情報が取得できない場合に仮定するコアあたりのL2サイズ
+static const int RGY_CONVERT_CSP_DEFAULT_L2_SIZE = 512 * 1024;
 
 RGYConvertCSP::RGYConvertCSP() : RGYConvertCSP(0) {
 }
@@ -57,22 +46,12 @@ RGYConvertCSP::RGYConvertCSP(int threads) :
     m_csp_to(RGY_CSP_NA),
     m_uv_only(false),
     m_threads(threads),
-    m_th(), m_heStart(), m_heFin(), m_heFinCopy(),
-    m_prm() {
+    m_tileBytes(0),
+    m_tileThreads(0),
+    m_pad() {
 };
 
 RGYConvertCSP::~RGYConvertCSP() {
-    m_prm.abort = true;
-    for (size_t i = 0; i < m_heStart.size(); i++) {
-        SetEvent(m_heStart[i].get());
-    }
-    for (size_t i = 0; i < m_th.size(); i++) {
-        m_th[i].join();
-    }
-    m_heFinCopy.clear();
-    m_heStart.clear();
-    m_heFin.clear();
-    m_th.clear();
 };
 const ConvertCSP *RGYConvertCSP::getFunc(RGY_CSP csp_from, RGY_CSP csp_to, bool uv_only, uint32_t simd) {
     if (m_csp == nullptr
@@ -85,55 +64,155 @@ const ConvertCSP *RGYConvertCSP::getFunc(RGY_CSP csp_from, RGY_CSP csp_to, bool
     return m_csp;
 }
 
+bool RGYConvertCSP::setPadding(const sInputCrop& pad) {
+    if (m_csp == nullptr || m_uv_only
+        || pad.e.left < 0 || pad.e.up < 0 || pad.e.right < 0 || pad.e.bottom < 0) {
+        return false;
+    }
+    //yuy2からの変換は色差の出力先を輝度の先頭から計算するため、変換先をずらせない
+    if (m_csp->csp_from == RGY_CSP_YUY2) {
+        return false;
+    }
+    switch (m_csp->csp_to) {
+    case RGY_CSP_NV12:
+    case RGY_CSP_P010:
+        if ((pad.e.left | pad.e.up | pad.e.right | pad.e.bottom) & 1) {
+            return false;
+        }
+        break;
+    case RGY_CSP_NV16:
+    case RGY_CSP_P210:
+        if ((pad.e.left | pad.e.right) & 1) {
+            return false;
+        }
+        break;
+    case RGY_CSP_YUV444:
+    case RGY_CSP_YUV444_16:
+        break;
+    default:
+        return false;
+    }
+    m_pad = pad;
+    return true;
+}
+
+template<typename T>
+static void pad_fill_rect(void *plane, int pitch_byte, int x, int y, int w, int h, T value) {
+    for (int j = 0; j < h; j++) {
+        T *ptr = (T *)((uint8_t *)plane + (size_t)(y + j) * pitch_byte) + x;
+        std::fill_n(ptr, w, value);
+    }
+}
+
+template<typename T>
+static void pad_fill_band(void *plane, int pitch_byte, const sInputCrop& pad, int out_width, int out_height, int y_shift, int band_start, int band_len, bool first, bool last, T value) {
+    const int padded_width = pad.e.left + out_width + pad.e.right;
+    const int row_start = (pad.e.up + band_start) >> y_shift;
+    const int row_end = (pad.e.up + band_start + band_len) >> y_shift;
+    pad_fill_rect<T>(plane, pitch_byte, 0,                         row_start, pad.e.left,  row_end - row_start, value);
+    pad_fill_rect<T>(plane, pitch_byte, pad.e.left + out_width, row_start, pad.e.right, row_end - row_start, value);
+    if (first) {
+        pad_fill_rect<T>(plane, pitch_byte, 0, 0, padded_width, pad.e.up >> y_shift, value);
+    }
+    if (last) {
+        const int bottom_start = (pad.e.up + out_height) >> y_shift;
+        const int bottom_end = (pad.e.up + out_height + pad.e.bottom) >> y_shift;
+        pad_fill_rect<T>(plane, pitch_byte, 0, bottom_start, padded_width, bottom_end - bottom_start, value);
+    }
+}
+
+void RGYConvertCSP::fillPadding(void **dst, int dst_y_pitch_byte, int width, int height, const int *crop, int band_id, int band_n, int plane_start, int plane_end) {
+    const auto y_range = thread_y_range(crop[1], height - crop[3], band_id, band_n);
+    const int out_width  = width  - crop[0] - crop[2];
+    const int out_height = height - crop[1] - crop[3];
+    const bool first = band_id == 0;
+    const bool last  = band_id == band_n - 1;
+    const int bit_depth = RGY_CSP_BIT_DEPTH[m_csp->csp_to];
+    const int chroma_y_shift = (RGY_CSP_CHROMA_FORMAT[m_csp->csp_to] == RGY_CHROMAFMT_YUV420) ? 1 : 0;
+    const int planes = (RGY_CSP_CHROMA_FORMAT[m_csp->csp_to] == RGY_CHROMAFMT_YUV444) ? 3 : 2;
+    //NVEncFilterPadと同じく、輝度は16、色差は128で埋める
+    const int value_y  = 16  << (bit_depth - 8);
+    const int value_uv = 128 << (bit_depth - 8);
+    for (int i = plane_start; i < std::min(plane_end, planes); i++) {
+        const int y_shift = (i == 0) ? 0 : chroma_y_shift;
+        const int value = (i == 0) ? value_y : value_uv;
+        if (bit_depth > 8) {
+            pad_fill_band<uint16_t>(dst[i], dst_y_pitch_byte, m_pad, out_width, out_height, y_shift, y_range.start_dst, y_range.len, first, last, (uint16_t)value);
+        } else {
+            pad_fill_band<uint8_t>(dst[i], dst_y_pitch_byte, m_pad, out_width, out_height, y_shift, y_range.start_dst, y_range.len, first, last, (uint8_t)value);
+        }
+    }
+}
+
+int RGYConvertCSP::runTiled(const std::function<void(int band_id, int band_n)>& run_band, int width, int dst_y_pitch_byte, int height, const int *crop) {
+    auto pool = RGYThreadPool::get();
+    if (m_tileBytes == 0) {
+        //入力と出力のバンドがコアあたりのL2の半分に収まるようにする
+        const auto cpu = get_cpu_info();
+        const auto& l2 = cpu.caches[1];
+        const int l2_per_core = (l2.size > 0 && l2.count > 0) ? (int)(l2.size / l2.count) : RGY_CONVERT_CSP_DEFAULT_L2_SIZE;
+        m_tileBytes = std::max(l2_per_core / 2, 64 * 1024);
+        m_tileThreads = std::max(1, (int)cpu.physical_cores);
+        pool->enableAffinity();
+    }
+    //輝度と色差は同じバンドの中で続けて処理されるので、両方を合わせた1行あたりのバイト数で分割する
+    const int line_bytes = std::max(1, (int)(((int64_t)width * (RGY_CSP_BIT_PER_PIXEL[m_csp->csp_from] + RGY_CSP_BIT_PER_PIXEL[m_csp->csp_to]) + 7) / 8));
+    const int band_lines = std::max(4, (m_tileBytes / line_bytes) & ~3);
+    const int process_lines = height - crop[1] - crop[3];
+    const int band_n = (dst_y_pitch_byte % 128 != 0) ? 1 : std::max(1, (process_lines + band_lines - 1) / band_lines);
+    pool->parallel_for(band_n, m_tileThreads, [&](int band_id) {
+        run_band(band_id, band_n);
+    }, true);
+    return 0;
+}
+
 int RGYConvertCSP::run(int interlaced, void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int *crop) {
+    //paddingを行う場合は、変換先をpadding分ずらしておき、
+    //輝度は各バンドの変換直後にそのバンドの周囲を埋める
+    //色差の行の分割は変換関数によって異なり、隣のバンドの書き込みと重なりうるので、全バンドの終了後にまとめて埋める
+    const bool padding = cropEnabled(m_pad);
+    void *dst_content[3] = { dst[0], dst[1], dst[2] };
+    if (padding) {
+        const int pixel_byte = (RGY_CSP_BIT_DEPTH[m_csp->csp_to] > 8) ? 2 : 1;
+        const int chroma_y_shift = (RGY_CSP_CHROMA_FORMAT[m_csp->csp_to] == RGY_CHROMAFMT_YUV420) ? 1 : 0;
+        for (int i = 0; i < 3; i++) {
+            const int y_offset = (i == 0) ? m_pad.e.up : (m_pad.e.up >> chroma_y_shift);
+            dst_content[i] = (uint8_t *)dst[i] + (size_t)y_offset * dst_y_pitch_byte + m_pad.e.left * pixel_byte;
+        }
+    }
+    auto run_band = [&](int band_id, int band_n) {
+        m_csp->func[interlaced](dst_content, src,
+            width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte,
+            height, dst_height, band_id, band_n, crop);
+        if (padding) {
+            fillPadding(dst, dst_y_pitch_byte, width, height, crop, band_id, band_n, 0, 1);
+        }
+    };
+    auto fill_chroma = [&]() {
+        if (padding) {
+            fillPadding(dst, dst_y_pitch_byte, width, height, crop, 0, 1, 1, 3);
+        }
+        return 0;
+    };
     if (m_threads == 0) {
         const int div = (m_csp->simd == 0) ? 2 : 4;
         const int max = (m_csp->simd == 0) ? 8 : 4;
         m_threads = (dst_y_pitch_byte % 128 != 0) ? 1 : std::min(max, ((int)get_cpu_info().physical_cores + div) / div);
+    } else if (m_threads == RGY_THREAD_CSP_TILED) {
+        runTiled(run_band, width, dst_y_pitch_byte, height, crop);
+        return fill_chroma();
     }
-    if (m_threads > 1 && m_th.size() == 0) {
-        m_heFinCopy.clear();
-        m_heStart.clear();
-        m_heFin.clear();
-        for (int ith = 1; ith < m_threads; ith++) {
-            auto heStart = std::unique_ptr<void, handle_deleter>(CreateEvent(nullptr, false, false, nullptr), handle_deleter());
-            auto heFin = std::unique_ptr<void, handle_deleter>(CreateEvent(nullptr, false, false, nullptr), handle_deleter());
-            m_th.push_back(std::thread([heStart = heStart.get(), heFin = heFin.get(), ithId = ith, threadN = m_threads, prm = &m_prm, cspfunc = &m_csp]() {
-                WaitForSingleObject((HANDLE)heStart, INFINITE);
-                while (!prm->abort) {
-                    (*cspfunc)->func[prm->interlaced](prm->dst, prm->src,
-                        prm->width, prm->src_y_pitch_byte, prm->src_uv_pitch_byte, prm->dst_y_pitch_byte,
-                        prm->height, prm->dst_height, ithId, threadN, prm->crop);
-                    SetEvent((HANDLE)heFin);
-                    WaitForSingleObject((HANDLE)heStart, INFINITE);
-                }
-            }));
-            m_heFinCopy.push_back(heFin.get());
-            m_heStart.push_back(std::move(heStart));
-            m_heFin.push_back(std::move(heFin));
-        }
-    }
-    m_prm.abort = false;
-    m_prm.interlaced = interlaced;
-    m_prm.dst = dst;
-    m_prm.src = src;
-    m_prm.width = width;
-    m_prm.src_y_pitch_byte = src_y_pitch_byte;
-    m_prm.src_uv_pitch_byte = src_uv_pitch_byte;
-    m_prm.dst_y_pitch_byte = dst_y_pitch_byte;
-    m_prm.height = height;
-    m_prm.dst_height = dst_height;
-    m_prm.crop = crop;
-    for (size_t i = 0; i < m_heStart.size(); i++) {
-        SetEvent(m_heStart[i].get());
+    if (m_threads <= 1) {
+        run_band(0, 1);
+        return fill_chroma();
     }
-    m_csp->func[interlaced](dst, src,
-        width, src_y_pitch_byte, src_uv_pitch_byte, dst_y_pitch_byte,
-        height, dst_height, 0, (int)m_th.size()+1, crop);
-    if (m_th.size() > 0) {
-        WaitForMultipleObjects((uint32_t)m_heFinCopy.size(), m_heFinCopy.data(), TRUE, INFINITE);
-    }
-    return 0;
+    //共有のスレッドプールでバンド単位に分割して処理する
+    //処理の偏りを吸収できるよう、スレッド数より多めに分割しておく
+    const int band_n = m_threads * RGY_CONVERT_CSP_BANDS_PER_THREAD;
+    RGYThreadPool::get()->parallel_for(band_n, m_threads, [&](int band_id) {
+        run_band(band_id, band_n);
+    });
+    return fill_chroma();
 }
 
 #if !FOR_AUO
@@ -312,7 +391,7 @@ RGY_ERR initReaders(
     const int subburnTrackId,
     const bool vpp_afs,
     const bool vpp_rff,
-    RGYListRef<RGYFrameDataQP> *qpTableListRef,
+    RGYObjectPool<RGYFrameDataQP> *qpTableListRef,
     CPerfMonitor *perfMonitor,
     shared_ptr<RGYLog> log
 ) {
@@ -383,11 +462,13 @@ RGY_ERR initReaders(
     RGYInputPrm inputPrm;
     inputPrm.threadCsp = ctrl->threadCsp;
     inputPrm.simdCsp = ctrl->simdCsp;
+    inputPrm.readMode = ctrl->inputReadMode;
     RGYInputPrm *pInputPrm = &inputPrm;
 
     auto subBurnTrack = std::make_unique<SubtitleSelect>();
     SubtitleSelect *subBurnTrackPtr = subBurnTrack.get();
 
+    RGYInputRawPrm inputPrmRaw(inputPrm);
     RGYInputAvsPrm inputPrmAvs(inputPrm);
 #if ENABLE_AVSW_READER
     RGYInputAvcodecPrm inputInfoAVCuvid(inputPrm);
@@ -452,6 +533,10 @@ RGY_ERR initReaders(
         inputInfoAVCuvid.seekSec = common->seekSec;
         inputInfoAVCuvid.logFramePosList = ctrl->logFramePosList.c_str();
         inputInfoAVCuvid.threadInput = ctrl->threadInput;
+        inputInfoAVCuvid.decodeQueue = ctrl->avswDecodeQueue;
+        inputInfoAVCuvid.decodeThreads = ctrl->avswThreads;
+        inputInfoAVCuvid.decodeThreadType = ctrl->avswThreadType;
+        inputInfoAVCuvid.inputIndex = ctrl->inputIndex;
         inputInfoAVCuvid.queueInfo = (perfMonitor) ? perfMonitor->GetQueueInfoPtr() : nullptr;
         inputInfoAVCuvid.HWDecCodecCsp = &HWDecCodecCsp;
         inputInfoAVCuvid.videoDetectPulldown = !vpp_rff && !vpp_afs && common->AVSyncMode == RGY_AVSYNC_ASSUME_CFR;
@@ -482,6 +567,12 @@ RGY_ERR initReaders(
             return RGY_ERR_UNSUPPORTED;
         }
         log->write(RGY_LOG_DEBUG, _T("raw/y4m reader selected.\n"));
+        inputPrmRaw.prefetch = ctrl->inputPrefetch;
+        inputPrmRaw.queueInfo = (perfMonitor) ? perfMonitor->GetQueueInfoPtr() : nullptr;
+        inputPrmRaw.seekSec = common->seekSec;
+        inputPrmRaw.nTrimCount = common->nTrimCount;
+        inputPrmRaw.pTrimList = common->pTrimList;
+        pInputPrm = &inputPrmRaw;
         pFileReader.reset(new RGYInputRaw());
         break; }
     }
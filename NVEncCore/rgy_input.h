@@ -31,6 +31,7 @@
 
 #include <memory>
 #include <thread>
+#include <functional>
 #include "rgy_osdep.h"
 #include "rgy_tchar.h"
 #include "rgy_log.h"
@@ -86,22 +87,6 @@ static int trackID(int trackID) {
 }
 #endif //#if ENABLE_AVSW_READER
 
-struct RGYConvertCSPPrm {
-    bool abort;
-    void **dst;
-    const void **src;
-    int interlaced;
-    int width;
-    int src_y_pitch_byte;
-    int src_uv_pitch_byte;
-    int dst_y_pitch_byte;
-    int height;
-    int dst_height;
-    int *crop;
-
-    RGYConvertCSPPrm();
-};
-
 class RGYConvertCSP {
 private:
     const ConvertCSP *m_csp;
@@ -109,17 +94,21 @@ private:
     RGY_CSP m_csp_to;
     bool m_uv_only;
     int m_threads;
-    std::vector<std::thread> m_th;
-    std::vector<std::unique_ptr<void, handle_deleter>> m_heStart;
-    std::vector<std::unique_ptr<void, handle_deleter>> m_heFin;
-    std::vector<HANDLE> m_heFinCopy;
-    RGYConvertCSPPrm m_prm;
+    int m_tileBytes;   //RGY_THREAD_CSP_TILED時に1バンドで扱うバイト数の目安
+    int m_tileThreads; //RGY_THREAD_CSP_TILED時に使用するスレッド数の上限
+    sInputCrop m_pad;  //変換と同時に付加するpadding
+
+    int runTiled(const std::function<void(int band_id, int band_n)>& run_band, int width, int dst_y_pitch_byte, int height, const int *crop);
+    void fillPadding(void **dst, int dst_y_pitch_byte, int width, int height, const int *crop, int band_id, int band_n, int plane_start, int plane_end);
 public:
     RGYConvertCSP();
     RGYConvertCSP(int threads);
     ~RGYConvertCSP();
     const ConvertCSP *getFunc(RGY_CSP csp_from, RGY_CSP csp_to, bool uv_only, uint32_t simd);
     const ConvertCSP *getFunc() const { return m_csp; };
+    //変換と同時に出力の周囲にpaddingを付加する (getFunc()の後に呼ぶこと)
+    //dstには、padding後の大きさのフレームを渡す
+    bool setPadding(const sInputCrop& pad);
 
     int run(int interlaced, void **dst, const void **src, int width, int src_y_pitch_byte, int src_uv_pitch_byte, int dst_y_pitch_byte, int height, int dst_height, int *crop);
 };
@@ -128,8 +117,9 @@ class RGYInputPrm {
 public:
     int threadCsp;
     uint32_t simdCsp;
+    RGYInputReadMode readMode;
 
-    RGYInputPrm() : threadCsp(-1), simdCsp(0) {};
+    RGYInputPrm() : threadCsp(-1), simdCsp(0), readMode(RGY_INPUT_READ_AUTO) {};
     virtual ~RGYInputPrm() {};
 };
 
@@ -191,9 +181,10 @@ public:
 #if ENABLE_AVSW_READER
 #pragma warning(push)
 #pragma warning(disable: 4100)
-    //音声・字幕パケットの配列を取得する
-    virtual vector<AVPacket> GetStreamDataPackets(int inputFrame) {
-        return vector<AVPacket>();
+    //音声・字幕パケットをpacketsの末尾に追加する
+    //パケットの中身はAVBufferRefの参照ごと渡し、コピーは行わない
+    //packetsは呼び出し側で使いまわし、毎フレームの確保を避ける
+    virtual void GetStreamDataPackets(int inputFrame, vector<AVPacket>& packets) {
     }
 
     //音声・字幕のコーデックコンテキストを取得する
@@ -287,7 +278,7 @@ RGY_ERR initReaders(
     const int subburnTrackId,
     const bool vpp_afs,
     const bool vpp_rff,
-    RGYListRef<RGYFrameDataQP> *qpTableListRef,
+    RGYObjectPool<RGYFrameDataQP> *qpTableListRef,
     CPerfMonitor *perfMonitor,
     shared_ptr<RGYLog> log
 );
@@ -71,6 +71,43 @@ static inline void extend_array_size(VideoFrameData *dataset) {
     memset(dataset->frame + current_cap, 0, sizeof(dataset->frame[0]) * (dataset->capacity - current_cap));
 }
 
+//入力ファイルのインデックスのキャッシュ (入力ファイル名 + 拡張子)
+static const TCHAR *RGY_AV_INDEX_EXT = _T(".avidx");
+static const char RGY_AV_INDEX_MAGIC[8] = { 'R', 'G', 'Y', 'A', 'V', 'I', 'D', 'X' };
+static const uint32_t RGY_AV_INDEX_VERSION = 1;
+//キャッシュが入力ファイルと一致しているかの確認に使用する先頭部分の大きさ
+static const size_t RGY_AV_INDEX_HASH_SIZE = 1024 * 1024;
+//フレームレート解析の条件
+static const uint32_t RGY_AV_INDEX_ANALYZE_PULLDOWN   = 0x01;
+static const uint32_t RGY_AV_INDEX_ANALYZE_LOWLATENCY = 0x02;
+
+struct RGYAVIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t fileSize;      //入力ファイルのサイズ
+    int64_t mtime;          //入力ファイルの更新時刻
+    uint64_t headHash;      //入力ファイルの先頭部分のハッシュ
+    int32_t streamIndex;    //動画のストリームの番号
+    int32_t timebaseNum;    //動画のtimebase
+    int32_t timebaseDen;
+    int32_t analyzeSec;     //フレームレート解析の条件
+    uint32_t analyzeFlags;
+    int32_t fpsNum;         //フレームレート解析の結果
+    int32_t fpsDen;
+    int32_t ptsInvalid;
+    int32_t packetCount;    //動画のパケット数
+    uint32_t keyframeCount; //インデックスに含まれるキーフレームの数
+};
+
+static uint64_t hash_fnv1a64(const uint8_t *data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
 RGYInputAvcodecPrm::RGYInputAvcodecPrm(RGYInputPrm base) :
     RGYInputPrm(base),
     memType(0),
@@ -101,6 +138,10 @@ RGYInputAvcodecPrm::RGYInputAvcodecPrm(RGYInputPrm base) :
     logFramePosList(nullptr),
     logCopyFrameData(nullptr),
     threadInput(0),
+    decodeQueue(0),
+    decodeThreads(0),
+    decodeThreadType(RGY_AVSW_THREAD_AUTO),
+    inputIndex(false),
     queueInfo(nullptr),
     HWDecCodecCsp(nullptr),
     videoDetectPulldown(false),
@@ -118,6 +159,8 @@ RGYInputAvcodec::RGYInputAvcodec() :
     m_Demux(),
     m_logFramePosList(),
     m_hevcMp42AnnexbBuffer(),
+    m_hdr10plusNalList(),
+    m_unnalBuffer(),
     m_cap2ass() {
     memset(&m_Demux.format, 0, sizeof(m_Demux.format));
     memset(&m_Demux.video,  0, sizeof(m_Demux.video));
@@ -129,6 +172,15 @@ RGYInputAvcodec::~RGYInputAvcodec() {
 }
 
 void RGYInputAvcodec::CloseThread() {
+    //デコードスレッドはqVideoPktを待っている可能性があるので、読み込みスレッドより先に終了させる
+    m_Demux.thread.bAbortDecode = true;
+    if (m_Demux.thread.thDecode.joinable()) {
+        AddMessage(RGY_LOG_DEBUG, _T("Closing Decode thread.\n"));
+        m_Demux.qVideoFrame.set_capacity(SIZE_MAX);
+        m_Demux.thread.thDecode.join();
+        AddMessage(RGY_LOG_DEBUG, _T("Closed Decode thread.\n"));
+    }
+    m_Demux.thread.bAbortDecode = false;
     m_Demux.thread.bAbortInput = true;
     if (m_Demux.thread.thInput.joinable()) {
         AddMessage(RGY_LOG_DEBUG, _T("Closing Input thread.\n"));
@@ -242,6 +294,9 @@ void RGYInputAvcodec::Close() {
     AddMessage(RGY_LOG_DEBUG, _T("Closing...\n"));
     //リソースの解放
     CloseThread();
+    SaveIndex();
+    m_Demux.index = AVDemuxIndex();
+    m_Demux.qVideoFrame.close([](AVFrame **frame) { av_frame_free(frame); });
     m_Demux.qVideoPkt.close([](AVPacket *pkt) { av_packet_unref(pkt); });
     for (uint32_t i = 0; i < m_Demux.qStreamPktL1.size(); i++) {
         av_packet_unref(&m_Demux.qStreamPktL1[i]);
@@ -456,12 +511,139 @@ void RGYInputAvcodec::hevcMp42Annexb(AVPacket *pkt) {
     m_hevcMp42AnnexbBuffer.clear();
 }
 
+void RGYInputAvcodec::estimateAvgFramerate(AVRational fpsDecoder, bool bPulldown, const std::vector<int>& frameDurationList, const vector<std::pair<int, int>>& durationHistgram) {
+    const bool fpsDecoderInvalid = (fpsDecoder.den == 0 || fpsDecoder.num == 0);
+    //durationが0でなく、最も頻繁に出てきたもの
+    const auto& mostPopularDuration = durationHistgram[durationHistgram.size() > 1 && durationHistgram[0].first == 0];
+
+    struct Rational64 {
+        uint64_t num;
+        uint64_t den;
+    } estimatedAvgFps = { 0 }, nAvgFramerate64 = { 0 }, fpsDecoder64 = { (uint64_t)fpsDecoder.num, (uint64_t)fpsDecoder.den };
+    if (mostPopularDuration.first == 0) {
+        m_Demux.video.streamPtsInvalid |= RGY_PTS_ALL_INVALID;
+    } else {
+        //avgFpsとtargetFpsが近いかどうか
+        auto fps_near = [](double avgFps, double targetFps) { return std::abs(1 - avgFps / targetFps) < 0.5; };
+        //durationの平均を求める (ただし、先頭は信頼ならないので、cutoff分は計算に含めない)
+        //std::accumulateの初期値に"(uint64_t)0"と与えることで、64bitによる計算を実行させ、桁あふれを防ぐ
+        //大きすぎるtimebaseの時に必要
+        double avgDuration = std::accumulate(frameDurationList.begin(), frameDurationList.end(), (uint64_t)0, [this](const uint64_t sum, const int& duration) { return sum + duration; }) / (double)(frameDurationList.size());
+        if (bPulldown) {
+            avgDuration *= 1.25;
+        }
+        double avgFps = m_Demux.video.stream->time_base.den / (double)(avgDuration * m_Demux.video.stream->time_base.num);
+        double torrelance = (fps_near(avgFps, 25.0) || fps_near(avgFps, 50.0)) ? 0.05 : 0.0008; //25fps, 50fps近辺は基準が甘くてよい
+        if (mostPopularDuration.second / (double)frameDurationList.size() > 0.95 && std::abs(1 - mostPopularDuration.first / avgDuration) < torrelance) {
+            avgDuration = mostPopularDuration.first;
+            AddMessage(RGY_LOG_DEBUG, _T("using popular duration...\n"));
+        }
+        //durationから求めた平均fpsを計算する
+        const uint64_t mul = (uint64_t)ceil(1001.0 / m_Demux.video.stream->time_base.num);
+        estimatedAvgFps.num = (uint64_t)(m_Demux.video.stream->time_base.den / avgDuration * (double)m_Demux.video.stream->time_base.num * mul + 0.5);
+        estimatedAvgFps.den = (uint64_t)m_Demux.video.stream->time_base.num * mul;
+
+        AddMessage(RGY_LOG_DEBUG, _T("fps mul:         %d\n"),    mul);
+        AddMessage(RGY_LOG_DEBUG, _T("raw avgDuration: %lf\n"),   avgDuration);
+        AddMessage(RGY_LOG_DEBUG, _T("estimatedAvgFps: %I64u/%I64u\n"), estimatedAvgFps.num, estimatedAvgFps.den);
+    }
+
+    if (m_Demux.video.streamPtsInvalid & RGY_PTS_ALL_INVALID) {
+        //ptsとdurationをpkt_timebaseで適当に作成する
+        nAvgFramerate64 = (fpsDecoderInvalid) ? estimatedAvgFps : fpsDecoder64;
+    } else {
+        if (fpsDecoderInvalid) {
+            nAvgFramerate64 = estimatedAvgFps;
+        } else {
+            double dFpsDecoder = fpsDecoder.num / (double)fpsDecoder.den;
+            double dEstimatedAvgFps = estimatedAvgFps.num / (double)estimatedAvgFps.den;
+            //2フレーム分程度がもたらす誤差があっても許容する
+            if (std::abs(dFpsDecoder / dEstimatedAvgFps - 1.0) < (2.0 / frameDurationList.size())) {
+                AddMessage(RGY_LOG_DEBUG, _T("use decoder fps...\n"));
+                nAvgFramerate64 = fpsDecoder64;
+            } else {
+                double dEstimatedAvgFpsCompare = estimatedAvgFps.num / (double)(estimatedAvgFps.den + ((dFpsDecoder < dEstimatedAvgFps) ? 1 : -1));
+                //durationから求めた平均fpsがデコーダの出したfpsの近似値と分かれば、デコーダの出したfpsを採用する
+                nAvgFramerate64 = (std::abs(dEstimatedAvgFps - dFpsDecoder) < std::abs(dEstimatedAvgFpsCompare - dFpsDecoder)) ? fpsDecoder64 : estimatedAvgFps;
+            }
+        }
+    }
+    AddMessage(RGY_LOG_DEBUG, _T("final AvgFps (raw64): %I64u/%I64u\n"), estimatedAvgFps.num, estimatedAvgFps.den);
+
+    //フレームレートが2000fpsを超えることは考えにくいので、誤判定
+    //ほかのなにか使えそうな値で代用する
+    const auto codec_timebase = av_stream_get_codec_timebase(m_Demux.video.stream);
+    if (nAvgFramerate64.num / (double)nAvgFramerate64.den > 2000.0) {
+        if (fpsDecoder.den > 0 && fpsDecoder.num > 0) {
+            nAvgFramerate64.num = fpsDecoder.num;
+            nAvgFramerate64.den = fpsDecoder.den;
+        } else if (codec_timebase.den > 0
+                && codec_timebase.num > 0) {
+            const AVCodec *codec = avcodec_find_decoder(m_Demux.video.stream->codecpar->codec_id);
+            AVCodecContext *pCodecCtx = avcodec_alloc_context3(codec);
+            nAvgFramerate64.num = codec_timebase.den * pCodecCtx->ticks_per_frame;
+            nAvgFramerate64.den = codec_timebase.num;
+            avcodec_free_context(&pCodecCtx);
+        }
+    }
+
+    rgy_reduce(nAvgFramerate64.num, nAvgFramerate64.den);
+    m_Demux.video.nAvgFramerate = av_make_q((int)nAvgFramerate64.num, (int)nAvgFramerate64.den);
+    AddMessage(RGY_LOG_DEBUG, _T("final AvgFps (gcd): %d/%d\n"), m_Demux.video.nAvgFramerate.num, m_Demux.video.nAvgFramerate.den);
+
+    struct KnownFpsList {
+        std::vector<int> base;
+        std::vector<int> mul;
+        int timebase_num;
+    };
+    const KnownFpsList knownFpsSmall = {
+        std::vector<int>{1, 2, 3, 4, 5, 10},
+        std::vector<int>{1},
+        1
+    };
+    const KnownFpsList knownFps1 = {
+        std::vector<int>{10, 12, 25},
+        std::vector<int>{1, 2, 3, 4, 5, 6, 10, 12, 20},
+        1
+    };
+    const KnownFpsList knownFps1001 = {
+        std::vector<int>{12000, 15000},
+        std::vector<int>{1, 2, 3, 4, 6, 8, 12, 16},
+        1001
+    };
+    const double fpsAvg = av_q2d(m_Demux.video.nAvgFramerate);
+    double fpsDiff = std::numeric_limits<double>::max();
+    AVRational fpsNear = m_Demux.video.nAvgFramerate;
+    auto round_fps = [&fpsDiff, &fpsNear, fpsAvg](const KnownFpsList& known_fps) {
+        for (auto b : known_fps.base) {
+            for (auto m : known_fps.mul) {
+                double fpsKnown = b * m / (double)known_fps.timebase_num;
+                double diff = std::abs(fpsKnown - fpsAvg);
+                if (diff < fpsDiff) {
+                    fpsDiff = diff;
+                    fpsNear = av_make_q(b * m, known_fps.timebase_num);
+                }
+            }
+        }
+    };
+    round_fps(knownFpsSmall);
+    round_fps(knownFps1);
+    round_fps(knownFps1001);
+    if (fpsDiff / fpsAvg < 2.0 / 60.0) {
+        m_Demux.video.nAvgFramerate = fpsNear;
+    }
+
+    AddMessage(RGY_LOG_DEBUG, _T("final AvgFps (round): %d/%d\n\n"), m_Demux.video.nAvgFramerate.num, m_Demux.video.nAvgFramerate.den);
+}
+
 RGY_ERR RGYInputAvcodec::getFirstFramePosAndFrameRate(const sTrim *pTrimList, int nTrimCount, bool bDetectpulldown, bool lowLatency) {
     AVRational fpsDecoder = m_Demux.video.stream->avg_frame_rate;
     const bool fpsDecoderInvalid = (fpsDecoder.den == 0 || fpsDecoder.num == 0);
     //timebaseが60で割り切れない場合には、ptsが完全には割り切れない値である場合があり、より多くのフレーム数を解析する必要がある
-    int maxCheckFrames = (m_Demux.format.analyzeSec == 0) ? ((m_Demux.video.stream->time_base.den >= 1000 && m_Demux.video.stream->time_base.den % 60) ? 128 : ((lowLatency) ? 12 : 48)) : 7200;
-    int maxCheckSec = (m_Demux.format.analyzeSec == 0) ? INT_MAX : m_Demux.format.analyzeSec;
+    //--input-analyzeの指定があっても、インデックスに解析結果がある場合は、ptsの状態の確認に必要な分だけ読めばよい
+    const bool analyzeLong = m_Demux.format.analyzeSec != 0 && !m_Demux.index.fpsValid;
+    int maxCheckFrames = (!analyzeLong) ? ((m_Demux.video.stream->time_base.den >= 1000 && m_Demux.video.stream->time_base.den % 60) ? 128 : ((lowLatency) ? 12 : 48)) : 7200;
+    int maxCheckSec = (!analyzeLong) ? INT_MAX : m_Demux.format.analyzeSec;
     AddMessage(RGY_LOG_DEBUG, _T("fps decoder invalid: %s\n"), fpsDecoderInvalid ? _T("true") : _T("false"));
 
     AVPacket pkt;
@@ -568,7 +750,10 @@ RGY_ERR RGYInputAvcodec::getFirstFramePosAndFrameRate(const sTrim *pTrimList, in
         }
 
         //ここでやめてよいか判定する
-        if (i_retry == 0) {
+        if (m_Demux.index.fpsValid) {
+            //フレームレートはインデックスの解析結果を使用するので、再解析は不要
+            break;
+        } else if (i_retry == 0) {
             //初回は、唯一のdurationが得られている場合を除き再解析する
             if (durationHistgram.size() <= 1) {
                 break;
@@ -585,127 +770,17 @@ RGY_ERR RGYInputAvcodec::getFirstFramePosAndFrameRate(const sTrim *pTrimList, in
         m_Demux.frames.clearPtsStatus();
     }
 
-    //durationが0でなく、最も頻繁に出てきたもの
-    auto& mostPopularDuration = durationHistgram[durationHistgram.size() > 1 && durationHistgram[0].first == 0];
-
-    struct Rational64 {
-        uint64_t num;
-        uint64_t den;
-    } estimatedAvgFps = { 0 }, nAvgFramerate64 = { 0 }, fpsDecoder64 = { (uint64_t)fpsDecoder.num, (uint64_t)fpsDecoder.den };
-    if (mostPopularDuration.first == 0) {
-        m_Demux.video.streamPtsInvalid |= RGY_PTS_ALL_INVALID;
+    if (m_Demux.index.fpsValid) {
+        //インデックスにキャッシュした解析結果を使用する
+        m_Demux.video.nAvgFramerate = m_Demux.index.avgFramerate;
+        m_Demux.video.streamPtsInvalid |= (m_Demux.index.ptsInvalid & RGY_PTS_ALL_INVALID);
+        AddMessage(RGY_LOG_DEBUG, _T("use AvgFps from index: %d/%d\n\n"), m_Demux.video.nAvgFramerate.num, m_Demux.video.nAvgFramerate.den);
     } else {
-        //avgFpsとtargetFpsが近いかどうか
-        auto fps_near = [](double avgFps, double targetFps) { return std::abs(1 - avgFps / targetFps) < 0.5; };
-        //durationの平均を求める (ただし、先頭は信頼ならないので、cutoff分は計算に含めない)
-        //std::accumulateの初期値に"(uint64_t)0"と与えることで、64bitによる計算を実行させ、桁あふれを防ぐ
-        //大きすぎるtimebaseの時に必要
-        double avgDuration = std::accumulate(frameDurationList.begin(), frameDurationList.end(), (uint64_t)0, [this](const uint64_t sum, const int& duration) { return sum + duration; }) / (double)(frameDurationList.size());
-        if (bPulldown) {
-            avgDuration *= 1.25;
-        }
-        double avgFps = m_Demux.video.stream->time_base.den / (double)(avgDuration * m_Demux.video.stream->time_base.num);
-        double torrelance = (fps_near(avgFps, 25.0) || fps_near(avgFps, 50.0)) ? 0.05 : 0.0008; //25fps, 50fps近辺は基準が甘くてよい
-        if (mostPopularDuration.second / (double)frameDurationList.size() > 0.95 && std::abs(1 - mostPopularDuration.first / avgDuration) < torrelance) {
-            avgDuration = mostPopularDuration.first;
-            AddMessage(RGY_LOG_DEBUG, _T("using popular duration...\n"));
-        }
-        //durationから求めた平均fpsを計算する
-        const uint64_t mul = (uint64_t)ceil(1001.0 / m_Demux.video.stream->time_base.num);
-        estimatedAvgFps.num = (uint64_t)(m_Demux.video.stream->time_base.den / avgDuration * (double)m_Demux.video.stream->time_base.num * mul + 0.5);
-        estimatedAvgFps.den = (uint64_t)m_Demux.video.stream->time_base.num * mul;
-
-        AddMessage(RGY_LOG_DEBUG, _T("fps mul:         %d\n"),    mul);
-        AddMessage(RGY_LOG_DEBUG, _T("raw avgDuration: %lf\n"),   avgDuration);
-        AddMessage(RGY_LOG_DEBUG, _T("estimatedAvgFps: %I64u/%I64u\n"), estimatedAvgFps.num, estimatedAvgFps.den);
-    }
-
-    if (m_Demux.video.streamPtsInvalid & RGY_PTS_ALL_INVALID) {
-        //ptsとdurationをpkt_timebaseで適当に作成する
-        nAvgFramerate64 = (fpsDecoderInvalid) ? estimatedAvgFps : fpsDecoder64;
-    } else {
-        if (fpsDecoderInvalid) {
-            nAvgFramerate64 = estimatedAvgFps;
-        } else {
-            double dFpsDecoder = fpsDecoder.num / (double)fpsDecoder.den;
-            double dEstimatedAvgFps = estimatedAvgFps.num / (double)estimatedAvgFps.den;
-            //2フレーム分程度がもたらす誤差があっても許容する
-            if (std::abs(dFpsDecoder / dEstimatedAvgFps - 1.0) < (2.0 / frameDurationList.size())) {
-                AddMessage(RGY_LOG_DEBUG, _T("use decoder fps...\n"));
-                nAvgFramerate64 = fpsDecoder64;
-            } else {
-                double dEstimatedAvgFpsCompare = estimatedAvgFps.num / (double)(estimatedAvgFps.den + ((dFpsDecoder < dEstimatedAvgFps) ? 1 : -1));
-                //durationから求めた平均fpsがデコーダの出したfpsの近似値と分かれば、デコーダの出したfpsを採用する
-                nAvgFramerate64 = (std::abs(dEstimatedAvgFps - dFpsDecoder) < std::abs(dEstimatedAvgFpsCompare - dFpsDecoder)) ? fpsDecoder64 : estimatedAvgFps;
-            }
-        }
-    }
-    AddMessage(RGY_LOG_DEBUG, _T("final AvgFps (raw64): %I64u/%I64u\n"), estimatedAvgFps.num, estimatedAvgFps.den);
-
-    //フレームレートが2000fpsを超えることは考えにくいので、誤判定
-    //ほかのなにか使えそうな値で代用する
-    const auto codec_timebase = av_stream_get_codec_timebase(m_Demux.video.stream);
-    if (nAvgFramerate64.num / (double)nAvgFramerate64.den > 2000.0) {
-        if (fpsDecoder.den > 0 && fpsDecoder.num > 0) {
-            nAvgFramerate64.num = fpsDecoder.num;
-            nAvgFramerate64.den = fpsDecoder.den;
-        } else if (codec_timebase.den > 0
-                && codec_timebase.num > 0) {
-            const AVCodec *codec = avcodec_find_decoder(m_Demux.video.stream->codecpar->codec_id);
-            AVCodecContext *pCodecCtx = avcodec_alloc_context3(codec);
-            nAvgFramerate64.num = codec_timebase.den * pCodecCtx->ticks_per_frame;
-            nAvgFramerate64.den = codec_timebase.num;
-            avcodec_free_context(&pCodecCtx);
-        }
+        estimateAvgFramerate(fpsDecoder, bPulldown, frameDurationList, durationHistgram);
     }
-
-    rgy_reduce(nAvgFramerate64.num, nAvgFramerate64.den);
-    m_Demux.video.nAvgFramerate = av_make_q((int)nAvgFramerate64.num, (int)nAvgFramerate64.den);
-    AddMessage(RGY_LOG_DEBUG, _T("final AvgFps (gcd): %d/%d\n"), m_Demux.video.nAvgFramerate.num, m_Demux.video.nAvgFramerate.den);
-
-    struct KnownFpsList {
-        std::vector<int> base;
-        std::vector<int> mul;
-        int timebase_num;
-    };
-    const KnownFpsList knownFpsSmall = {
-        std::vector<int>{1, 2, 3, 4, 5, 10},
-        std::vector<int>{1},
-        1
-    };
-    const KnownFpsList knownFps1 = {
-        std::vector<int>{10, 12, 25},
-        std::vector<int>{1, 2, 3, 4, 5, 6, 10, 12, 20},
-        1
-    };
-    const KnownFpsList knownFps1001 = {
-        std::vector<int>{12000, 15000},
-        std::vector<int>{1, 2, 3, 4, 6, 8, 12, 16},
-        1001
-    };
-    const double fpsAvg = av_q2d(m_Demux.video.nAvgFramerate);
-    double fpsDiff = std::numeric_limits<double>::max();
-    AVRational fpsNear = m_Demux.video.nAvgFramerate;
-    auto round_fps = [&fpsDiff, &fpsNear, fpsAvg](const KnownFpsList& known_fps) {
-        for (auto b : known_fps.base) {
-            for (auto m : known_fps.mul) {
-                double fpsKnown = b * m / (double)known_fps.timebase_num;
-                double diff = std::abs(fpsKnown - fpsAvg);
-                if (diff < fpsDiff) {
-                    fpsDiff = diff;
-                    fpsNear = av_make_q(b * m, known_fps.timebase_num);
-                }
-            }
-        }
-    };
-    round_fps(knownFpsSmall);
-    round_fps(knownFps1);
-    round_fps(knownFps1001);
-    if (fpsDiff / fpsAvg < 2.0 / 60.0) {
-        m_Demux.video.nAvgFramerate = fpsNear;
-    }
-
-    AddMessage(RGY_LOG_DEBUG, _T("final AvgFps (round): %d/%d\n\n"), m_Demux.video.nAvgFramerate.num, m_Demux.video.nAvgFramerate.den);
+    //インデックスに保存する解析結果
+    m_Demux.index.avgFramerate = m_Demux.video.nAvgFramerate;
+    m_Demux.index.ptsInvalid = m_Demux.video.streamPtsInvalid & RGY_PTS_ALL_INVALID;
 
     auto trimList = make_vector(pTrimList, nTrimCount);
     //出力時の音声・字幕解析用に1パケットコピーしておく
@@ -762,6 +837,180 @@ RGY_ERR RGYInputAvcodec::getFirstFramePosAndFrameRate(const sTrim *pTrimList, in
     return RGY_ERR_NONE;
 }
 
+void RGYInputAvcodec::InitIndex(const TCHAR *strFileName, const RGYInputAvcodecPrm *input_prm) {
+    m_Demux.index = AVDemuxIndex();
+    if (m_Demux.format.isPipe) {
+        AddMessage(RGY_LOG_DEBUG, _T("input index disabled for pipe input.\n"));
+        return;
+    }
+    FILE *fp = nullptr;
+    if (_tfopen_s(&fp, strFileName, _T("rb")) != 0 || fp == nullptr) {
+        AddMessage(RGY_LOG_DEBUG, _T("input index disabled: failed to open \"%s\".\n"), strFileName);
+        return;
+    }
+    std::unique_ptr<FILE, decltype(&fclose)> fpInput(fp, fclose);
+    //ファイルサイズ、更新時刻、先頭部分のハッシュで入力ファイルが変わっていないかを判定する
+    std::vector<uint8_t> head(RGY_AV_INDEX_HASH_SIZE);
+    head.resize(fread(head.data(), 1, head.size(), fp));
+    if (_fseeki64(fp, 0, SEEK_END) != 0) {
+        return;
+    }
+    const int64_t fileSize = _ftelli64(fp);
+    const int64_t mtime = rgy_get_file_mtime(fp);
+    if (fileSize <= 0 || mtime < 0) {
+        return;
+    }
+    m_Demux.index.fileSize = (uint64_t)fileSize;
+    m_Demux.index.mtime = mtime;
+    m_Demux.index.headHash = hash_fnv1a64(head.data(), head.size());
+    m_Demux.index.streamIndex = m_Demux.video.index;
+    m_Demux.index.analyzeSec = m_Demux.format.analyzeSec;
+    m_Demux.index.analyzeFlags = ((input_prm->videoDetectPulldown) ? RGY_AV_INDEX_ANALYZE_PULLDOWN : 0)
+                               | ((input_prm->lowLatency) ? RGY_AV_INDEX_ANALYZE_LOWLATENCY : 0);
+    m_Demux.index.avgFramerate = av_make_q(0, 1);
+    m_Demux.index.filename = tstring(strFileName) + RGY_AV_INDEX_EXT;
+    m_Demux.index.enable = true;
+    m_Demux.index.loaded = LoadIndex();
+    //キャッシュがない場合のみ、キーフレームを記録して読み込み終了時に保存する
+    m_Demux.index.recording = !m_Demux.index.loaded;
+}
+
+bool RGYInputAvcodec::LoadIndex() {
+    FILE *fp = nullptr;
+    if (_tfopen_s(&fp, m_Demux.index.filename.c_str(), _T("rb")) != 0 || fp == nullptr) {
+        AddMessage(RGY_LOG_DEBUG, _T("input index \"%s\" not found.\n"), m_Demux.index.filename.c_str());
+        return false;
+    }
+    std::unique_ptr<FILE, decltype(&fclose)> fpIndex(fp, fclose);
+    RGYAVIndexHeader header = { 0 };
+    if (fread(&header, 1, sizeof(header), fp) != sizeof(header)
+        || memcmp(header.magic, RGY_AV_INDEX_MAGIC, sizeof(header.magic)) != 0
+        || header.version != RGY_AV_INDEX_VERSION
+        || header.fileSize != m_Demux.index.fileSize
+        || header.mtime != m_Demux.index.mtime
+        || header.headHash != m_Demux.index.headHash
+        || header.streamIndex != m_Demux.index.streamIndex
+        || header.timebaseNum != m_Demux.video.stream->time_base.num
+        || header.timebaseDen != m_Demux.video.stream->time_base.den
+        || header.packetCount <= 0
+        || header.keyframeCount == 0
+        || header.keyframeCount > (uint32_t)header.packetCount) {
+        AddMessage(RGY_LOG_DEBUG, _T("input index \"%s\" does not match the input, rebuilding.\n"), m_Demux.index.filename.c_str());
+        return false;
+    }
+    std::vector<AVDemuxIndexKeyframe> keyframes(header.keyframeCount);
+    if (fread(keyframes.data(), sizeof(keyframes[0]), keyframes.size(), fp) != keyframes.size()) {
+        return false;
+    }
+    //キーフレームの番号が正しく並んでいるかを確認する
+    for (size_t i = 0; i < keyframes.size(); i++) {
+        if (keyframes[i].packetIdx < ((i > 0) ? keyframes[i-1].packetIdx + 1 : 0)
+            || keyframes[i].packetIdx >= header.packetCount) {
+            return false;
+        }
+    }
+    m_Demux.index.keyframes = std::move(keyframes);
+    //フレームレート解析の結果は、解析の条件が同じ場合のみ使用する
+    m_Demux.index.fpsValid = header.analyzeSec == m_Demux.index.analyzeSec
+        && header.analyzeFlags == m_Demux.index.analyzeFlags
+        && header.fpsNum > 0 && header.fpsDen > 0;
+    if (m_Demux.index.fpsValid) {
+        m_Demux.index.avgFramerate = av_make_q(header.fpsNum, header.fpsDen);
+        m_Demux.index.ptsInvalid = header.ptsInvalid;
+    }
+    AddMessage(RGY_LOG_DEBUG, _T("loaded input index \"%s\": %d packets, %d keyframes%s.\n"), m_Demux.index.filename.c_str(),
+        header.packetCount, (int)m_Demux.index.keyframes.size(), (m_Demux.index.fpsValid) ? _T(", framerate") : _T(""));
+    return true;
+}
+
+void RGYInputAvcodec::SaveIndex() {
+    //ファイル先頭から最後まで読み込んだ場合のみ、キーフレームの一覧が揃っている
+    if (!m_Demux.index.enable || !m_Demux.index.recording || !m_Demux.frames.isEof()
+        || m_Demux.index.keyframes.size() == 0) {
+        return;
+    }
+    FILE *fp = nullptr;
+    if (_tfopen_s(&fp, m_Demux.index.filename.c_str(), _T("wb")) != 0 || fp == nullptr) {
+        AddMessage(RGY_LOG_DEBUG, _T("failed to open \"%s\" to save input index.\n"), m_Demux.index.filename.c_str());
+        return;
+    }
+    RGYAVIndexHeader header = { 0 };
+    memcpy(header.magic, RGY_AV_INDEX_MAGIC, sizeof(header.magic));
+    header.version = RGY_AV_INDEX_VERSION;
+    header.fileSize = m_Demux.index.fileSize;
+    header.mtime = m_Demux.index.mtime;
+    header.headHash = m_Demux.index.headHash;
+    header.streamIndex = m_Demux.index.streamIndex;
+    header.timebaseNum = m_Demux.video.stream->time_base.num;
+    header.timebaseDen = m_Demux.video.stream->time_base.den;
+    header.analyzeSec = m_Demux.index.analyzeSec;
+    header.analyzeFlags = m_Demux.index.analyzeFlags;
+    header.fpsNum = m_Demux.index.avgFramerate.num;
+    header.fpsDen = m_Demux.index.avgFramerate.den;
+    header.ptsInvalid = m_Demux.index.ptsInvalid;
+    header.packetCount = m_Demux.index.packetCount;
+    header.keyframeCount = (uint32_t)m_Demux.index.keyframes.size();
+    bool ret = fwrite(&header, 1, sizeof(header), fp) == sizeof(header)
+        && fwrite(m_Demux.index.keyframes.data(), sizeof(m_Demux.index.keyframes[0]), m_Demux.index.keyframes.size(), fp) == m_Demux.index.keyframes.size();
+    ret = (fclose(fp) == 0) && ret;
+    if (!ret) {
+        //書き込みに失敗した場合は、不完全なキャッシュを残さない
+        _tremove(m_Demux.index.filename.c_str());
+        AddMessage(RGY_LOG_DEBUG, _T("failed to save input index to \"%s\".\n"), m_Demux.index.filename.c_str());
+        return;
+    }
+    AddMessage(RGY_LOG_DEBUG, _T("saved input index to \"%s\": %d packets, %d keyframes.\n"), m_Demux.index.filename.c_str(),
+        m_Demux.index.packetCount, (int)m_Demux.index.keyframes.size());
+}
+
+int RGYInputAvcodec::seekToIndexKeyframe(const AVDemuxIndexKeyframe& keyframe) {
+    //tsなどtimestampが不連続になりうる形式では、ファイル上の位置で直接シークする
+    const auto iformat = m_Demux.format.formatCtx->iformat;
+    if (keyframe.pos >= 0
+        && !(iformat->flags & AVFMT_NO_BYTE_SEEK)
+        && (iformat->flags & (AVFMT_TS_DISCONT | AVFMT_GENERIC_INDEX))) {
+        return av_seek_frame(m_Demux.format.formatCtx, m_Demux.video.index, keyframe.pos, AVSEEK_FLAG_BYTE);
+    }
+    const int64_t timestamp = (keyframe.dts != AV_NOPTS_VALUE) ? keyframe.dts : keyframe.pts;
+    if (timestamp == AV_NOPTS_VALUE) {
+        return AVERROR(EINVAL);
+    }
+    return av_seek_frame(m_Demux.format.formatCtx, m_Demux.video.index, timestamp, AVSEEK_FLAG_BACKWARD);
+}
+
+RGY_ERR RGYInputAvcodec::seekIndexForTrim(int trimStart) {
+    //trimの開始フレームの手前のキーフレームを探す
+    //デコード順と表示順の入れ替わりを考慮し、AV_FRAME_MAX_REORDERだけ余裕を持たせる
+    const AVDemuxIndexKeyframe *target = nullptr;
+    for (const auto& keyframe : m_Demux.index.keyframes) {
+        if (keyframe.packetIdx + (int)AV_FRAME_MAX_REORDER > trimStart) {
+            break;
+        }
+        if (keyframe.packetIdx > 0) {
+            target = &keyframe;
+        }
+    }
+    if (target == nullptr) {
+        return RGY_ERR_NONE;
+    }
+    if (0 > seekToIndexKeyframe(*target)) {
+        //シークに失敗した場合は、先頭から読み込む
+        AddMessage(RGY_LOG_DEBUG, _T("failed to seek to keyframe #%d for trim, reading from the start.\n"), target->packetIdx);
+        if (0 > seekToIndexKeyframe(m_Demux.index.keyframes[0])
+            && 0 > av_seek_frame(m_Demux.format.formatCtx, m_Demux.video.index, 0, AVSEEK_FLAG_BACKWARD | AVSEEK_FLAG_BYTE)) {
+            AddMessage(RGY_LOG_ERROR, _T("failed to seek back to the start of the input.\n"));
+            return RGY_ERR_UNKNOWN;
+        }
+        return RGY_ERR_NONE;
+    }
+    //飛ばしたパケット数はgetSampleでm_trimParam.offsetに加えられる
+    m_Demux.index.trimSkip = target->packetIdx;
+    m_Demux.index.packetCount = target->packetIdx;
+    m_Demux.index.recording = false;
+    AddMessage(RGY_LOG_DEBUG, _T("seek to keyframe #%d by input index for trim start %d.\n"), target->packetIdx, trimStart);
+    return RGY_ERR_NONE;
+}
+
 RGY_ERR RGYInputAvcodec::parseHDRData() {
     //まずはstreamのside_dataを探す
     int size = 0;
@@ -892,7 +1141,9 @@ RGY_ERR RGYInputAvcodec::parseHDR10plus(AVPacket *pkt) {
     if (m_Demux.video.stream->codec->codec_id != AV_CODEC_ID_HEVC) {
         return RGY_ERR_NONE;
     }
-    const auto nal_list = parse_nal_unit_hevc(pkt->data, pkt->size);
+    auto& nal_list = m_hdr10plusNalList;
+    nal_list.clear();
+    parse_nal_unit_hevc(pkt->data, pkt->size, nal_list);
     for (const auto& nal_unit : nal_list) {
         if (nal_unit.type != NALU_HEVC_PREFIX_SEI) {
             continue;
@@ -915,8 +1166,12 @@ RGY_ERR RGYInputAvcodec::parseHDR10plus(AVPacket *pkt) {
             && ptr[1] == 0x01
             && ptr[2] == USER_DATA_REGISTERED_ITU_T_T35) {
             ptr += 3;
-            const auto data_unnal = unnal(ptr, nal_unit.ptr + nal_unit.size - ptr);
-            ptr = data_unnal.data();
+            const size_t size_nal = nal_unit.ptr + nal_unit.size - ptr;
+            if (m_unnalBuffer.size() < size_nal) {
+                m_unnalBuffer.resize(size_nal);
+            }
+            unnal(m_unnalBuffer.data(), ptr, size_nal);
+            ptr = m_unnalBuffer.data();
             size_t size = 0;
             while (*ptr == 0xff) {
                 size += *ptr++;
@@ -1483,11 +1738,30 @@ RGY_ERR RGYInputAvcodec::Init(const TCHAR *strFileName, VideoInfo *inputInfo, co
             m_inputVideoInfo.codecExtra = m_Demux.video.extradata;
             m_inputVideoInfo.codecExtraSize = m_Demux.video.extradataSize;
         }
+        if (input_prm->inputIndex) {
+            InitIndex(strFileName, input_prm);
+        }
         if (input_prm->seekSec > 0.0f) {
             AVPacket firstpkt;
             getSample(&firstpkt); //現在のtimestampを取得する
             const auto seek_time = av_rescale_q(1, av_d2q((double)input_prm->seekSec, 1<<24), m_Demux.video.stream->time_base);
-            int seek_ret = av_seek_frame(m_Demux.format.formatCtx, m_Demux.video.index, firstpkt.pts + seek_time, 0);
+            int seek_ret = -1;
+            if (m_Demux.index.loaded && firstpkt.pts != AV_NOPTS_VALUE) {
+                //インデックスがあれば、指定位置の手前のキーフレームに直接シークする
+                const AVDemuxIndexKeyframe *target = nullptr;
+                for (const auto& keyframe : m_Demux.index.keyframes) {
+                    if (keyframe.pts != AV_NOPTS_VALUE && keyframe.pts <= firstpkt.pts + seek_time) {
+                        target = &keyframe;
+                    }
+                }
+                if (target) {
+                    seek_ret = seekToIndexKeyframe(*target);
+                    AddMessage(RGY_LOG_DEBUG, _T("seek to keyframe #%d by input index: %s.\n"), target->packetIdx, (0 > seek_ret) ? _T("failed") : _T("success"));
+                }
+            }
+            if (0 > seek_ret) {
+                seek_ret = av_seek_frame(m_Demux.format.formatCtx, m_Demux.video.index, firstpkt.pts + seek_time, 0);
+            }
             if (0 > seek_ret) {
                 seek_ret = av_seek_frame(m_Demux.format.formatCtx, m_Demux.video.index, firstpkt.pts + seek_time, AVSEEK_FLAG_ANY);
             }
@@ -1498,6 +1772,11 @@ RGY_ERR RGYInputAvcodec::Init(const TCHAR *strFileName, VideoInfo *inputInfo, co
             }
             //seekのために行ったgetSampleの結果は破棄する
             m_Demux.frames.clear();
+            m_Demux.index.recording = false;
+        } else if (m_Demux.index.loaded && input_prm->nTrimCount > 0) {
+            if (RGY_ERR_NONE != (sts = seekIndexForTrim(input_prm->pTrimList[0].start))) {
+                return sts;
+            }
         }
 
         //parserはseek後に初期化すること
@@ -1658,12 +1937,22 @@ RGY_ERR RGYInputAvcodec::Init(const TCHAR *strFileName, VideoInfo *inputInfo, co
                 return RGY_ERR_UNKNOWN;
             }
             cpu_info_t cpu_info;
-            if (get_cpu_info(&cpu_info)) {
-                AVDictionary *pDict = nullptr;
-                av_dict_set_int(&pDict, "threads", std::min(cpu_info.logical_cores, 16u), 0);
+            m_Demux.thread.decodeThreads = input_prm->decodeThreads;
+            if (m_Demux.thread.decodeThreads <= 0 && get_cpu_info(&cpu_info)) {
+                m_Demux.thread.decodeThreads = (int)std::min(cpu_info.logical_cores, 16u);
+            }
+            AVDictionary *pDict = nullptr;
+            if (m_Demux.thread.decodeThreads > 0) {
+                av_dict_set_int(&pDict, "threads", m_Demux.thread.decodeThreads, 0);
+            }
+            if (input_prm->decodeThreadType != RGY_AVSW_THREAD_AUTO) {
+                av_dict_set(&pDict, "thread_type", (input_prm->decodeThreadType == RGY_AVSW_THREAD_SLICE) ? "slice" : "frame", 0);
+            }
+            if (pDict) {
                 if (0 > (ret = av_opt_set_dict(m_Demux.video.codecCtxDecode, &pDict))) {
                     AddMessage(RGY_LOG_ERROR, _T("Failed to set threads for decode (codec: %s): %s\n"),
                         char_to_tstring(avcodec_get_name(m_Demux.video.stream->codecpar->codec_id)).c_str(), qsv_av_err2str(ret).c_str());
+                    av_dict_free(&pDict);
                     return RGY_ERR_UNKNOWN;
                 }
                 av_dict_free(&pDict);
@@ -1720,6 +2009,10 @@ RGY_ERR RGYInputAvcodec::Init(const TCHAR *strFileName, VideoInfo *inputInfo, co
                 AddMessage(RGY_LOG_ERROR, _T("Failed to allocate frame for decoder.\n"));
                 return RGY_ERR_NULL_PTR;
             }
+            AddMessage(RGY_LOG_DEBUG, _T("decoder threads: %d, thread type: %s.\n"),
+                m_Demux.video.codecCtxDecode->thread_count,
+                (m_Demux.video.codecCtxDecode->active_thread_type & FF_THREAD_FRAME) ? _T("frame")
+                    : ((m_Demux.video.codecCtxDecode->active_thread_type & FF_THREAD_SLICE) ? _T("slice") : _T("none")));
             m_Demux.video.qpTableListRef = input_prm->qpTableListRef;
         } else {
             //HWデコードの場合は、色変換がかからないので、入力フォーマットがそのまま出力フォーマットとなる
@@ -1795,6 +2088,16 @@ RGY_ERR RGYInputAvcodec::Init(const TCHAR *strFileName, VideoInfo *inputInfo, co
             //入力をスレッド化しない場合には、自動的に同期が保たれるので、ここでの制限は必要ない
             m_Demux.qVideoPkt.set_capacity(256);
         }
+        //swデコードの場合は、デコードをデコードスレッドで先行して行い、
+        //呼び出し元のスレッドではパケットの読み込みと色変換のみを行うようにする
+        m_Demux.thread.decodeQueue = (m_Demux.video.codecCtxDecode) ? input_prm->decodeQueue : 0;
+        if (m_Demux.thread.decodeQueue > 0) {
+            m_Demux.qVideoFrame.init(1024, m_Demux.thread.decodeQueue);
+            m_Demux.thread.bAbortDecode = false;
+            m_Demux.thread.decodeSts = RGY_ERR_NONE;
+            m_Demux.thread.thDecode = std::thread(&RGYInputAvcodec::ThreadFuncDecode, this);
+            AddMessage(RGY_LOG_DEBUG, _T("Started Decode thread, queue %d frames.\n"), m_Demux.thread.decodeQueue);
+        }
     } else {
         //音声との同期とかに使うので、動画の情報を格納する
         m_Demux.video.nAvgFramerate = av_make_q(input_prm->videoAvgFramerate.first, input_prm->videoAvgFramerate.second);
@@ -2084,6 +2387,7 @@ int RGYInputAvcodec::getSample(AVPacket *pkt, bool bTreatFirstPacketAsKeyframe)
             if (!bTreatFirstPacketAsKeyframe && !m_Demux.video.gotFirstKeyframe && !keyframe) {
                 av_packet_unref(pkt);
                 i_samples++;
+                m_Demux.index.packetCount++;
                 continue;
             } else {
                 if (!m_Demux.video.gotFirstKeyframe) {
@@ -2105,7 +2409,8 @@ int RGYInputAvcodec::getSample(AVPacket *pkt, bool bTreatFirstPacketAsKeyframe)
                     //そのため、getSampleでも最初のキーフレームを取得するまでパケットを出力しない
                     //だが、これが原因でtrimの値とずれを生じてしまう
                     //そこで、そのぶんのずれを記録しておき、Trim値などに補正をかける
-                    m_trimParam.offset = i_samples;
+                    //インデックスを使ってtrimの手前までシークした場合は、飛ばしたパケット数も加える
+                    m_trimParam.offset = m_Demux.index.trimSkip + i_samples;
                     AddMessage(RGY_LOG_DEBUG, _T("found first key frame: timestamp %lld (%s), offset %d\n"),
                         (long long int)m_Demux.video.streamFirstKeyPts, getTimestampString(m_Demux.video.streamFirstKeyPts, m_Demux.video.stream->time_base).c_str(),
                         m_trimParam.offset);
@@ -2121,6 +2426,16 @@ int RGYInputAvcodec::getSample(AVPacket *pkt, bool bTreatFirstPacketAsKeyframe)
                     m_trimParam.offset++;
                 }
 #endif //#if ENCODER_NVENC
+                if (m_Demux.index.recording && keyframe) {
+                    AVDemuxIndexKeyframe indexKeyframe = { 0 };
+                    indexKeyframe.pts = pkt->pts;
+                    indexKeyframe.dts = pkt->dts;
+                    indexKeyframe.pos = pkt->pos;
+                    indexKeyframe.packetIdx = m_Demux.index.packetCount;
+                    indexKeyframe.flags = pkt->flags;
+                    m_Demux.index.keyframes.push_back(indexKeyframe);
+                }
+                m_Demux.index.packetCount++;
                 m_Demux.frames.add(pos);
             }
             //ptsの確定したところまで、音声を出力する
@@ -2133,6 +2448,13 @@ int RGYInputAvcodec::getSample(AVPacket *pkt, bool bTreatFirstPacketAsKeyframe)
                 const auto timestamp = (pkt->pts == AV_NOPTS_VALUE) ? pkt->dts : pkt->pts;
                 AddMessage(RGY_LOG_WARN, _T("corrupt packet in stream %d: %lld (%s)\n"), pkt->stream_index, (long long int)timestamp, getTimestampString(timestamp, stream->stream->time_base).c_str());
             }
+            //Writer側へはAVBufferRefの参照ごと渡すので、参照カウントのないパケットはここで参照カウント付きにしておく
+            //(Writer側ではpkt.buf == nullptrのパケットはflush用として扱われる)
+            if (pkt->buf == nullptr && av_packet_make_refcounted(pkt) < 0) {
+                AddMessage(RGY_LOG_WARN, _T("Failed to make packet refcounted in stream %d, packet dropped.\n"), pkt->stream_index);
+                av_packet_unref(pkt);
+                continue;
+            }
             //音声/字幕パケットはひとまずすべてバッファに格納する
             m_Demux.qStreamPktL1.push_back(*pkt);
         } else {
@@ -2280,7 +2602,8 @@ void RGYInputAvcodec::GetAudioDataPacketsWhenNoVideoRead(int inputFrame) {
             AVDemuxStream *pStream = getPacketStreamData(&pkt);
             const auto delay_ts = av_rescale_q(pStream->addDelayMs, av_make_q(1, 1000), pStream->timebase);
             pkt.pts += delay_ts;
-            if (checkStreamPacketToAdd(&pkt, pStream)) {
+            if (checkStreamPacketToAdd(&pkt, pStream)
+                && (pkt.buf != nullptr || av_packet_make_refcounted(&pkt) >= 0)) {
                 m_Demux.qStreamPktL1.push_back(pkt);
             } else {
                 av_packet_unref(&pkt); //Writer側に渡さないパケットはここで開放する
@@ -2356,18 +2679,18 @@ void RGYInputAvcodec::CheckAndMoveStreamPacketList() {
     }
 }
 
-vector<AVPacket> RGYInputAvcodec::GetStreamDataPackets(int inputFrame) {
+void RGYInputAvcodec::GetStreamDataPackets(int inputFrame, vector<AVPacket>& packets) {
     if (!m_Demux.video.readVideo) {
         GetAudioDataPacketsWhenNoVideoRead(inputFrame);
     }
 
     //出力するパケットを選択する
-    vector<AVPacket> packets;
+    //AVPacketの構造体のみをコピーし、データはAVBufferRefの参照ごとWriter側に渡す
+    packets.reserve(packets.size() + m_Demux.qStreamPktL2.size());
     AVPacket pkt;
     while (m_Demux.qStreamPktL2.front_copy_and_pop_no_lock(&pkt, (m_Demux.thread.queueInfo) ? &m_Demux.thread.queueInfo->usage_aud_in : nullptr)) {
         packets.push_back(pkt);
     }
-    return std::move(packets);
 }
 
 vector<AVDemuxStream> RGYInputAvcodec::GetInputStreamInfo() {
@@ -2454,93 +2777,141 @@ RGY_ERR RGYInputAvcodec::GetHeader(RGYBitstream *pBitstream) {
     return RGY_ERR_NONE;
 }
 
+//パケットをデコーダに送り、1フレーム分デコードしてframeに格納する
+RGY_ERR RGYInputAvcodec::DecodeFrame(AVFrame *frame, bool decodeThread) {
+    for (;;) {
+        AVPacket pkt;
+        av_init_packet(&pkt);
+        if (!decodeThread
+            && !m_Demux.thread.thInput.joinable() //入力スレッドがなければ、自分で読み込む
+            && m_Demux.qVideoPkt.get_keep_length() > 0) { //keep_length == 0なら読み込みは終了していて、これ以上読み込む必要はない
+            if (0 == getSample(&pkt)) {
+                m_Demux.qVideoPkt.push(pkt);
+            }
+        }
+
+        bool bGetPacket = false;
+        for (int i = 0; false == (bGetPacket = m_Demux.qVideoPkt.front_copy_no_lock(&pkt, (m_Demux.thread.queueInfo) ? &m_Demux.thread.queueInfo->usage_vid_in : nullptr))
+            //デコードスレッドでは、keep_length > 0の間は読み込みが終了していないので、パケットが積まれるのを待つ
+            && (m_Demux.qVideoPkt.size() > 0 || (decodeThread && m_Demux.qVideoPkt.get_keep_length() > 0)); i++) {
+            if (decodeThread && m_Demux.thread.bAbortDecode) {
+                return RGY_ERR_ABORTED;
+            }
+            m_Demux.qVideoPkt.wait_for_push();
+        }
+        if (!bGetPacket) {
+            //flushするためのパケット
+            pkt.data = nullptr;
+            pkt.size = 0;
+        }
+        int ret = avcodec_send_packet(m_Demux.video.codecCtxDecode, &pkt);
+        //AVERROR(EAGAIN) -> パケットを送る前に受け取る必要がある
+        //パケットが受け取られていないのでpopしない
+        if (ret != AVERROR(EAGAIN)) {
+            m_Demux.qVideoPkt.pop();
+            av_packet_unref(&pkt);
+        }
+        if (ret == AVERROR_EOF) { //これ以上パケットを送れない
+            AddMessage(RGY_LOG_DEBUG, _T("failed to send packet to video decoder, already flushed: %s.\n"), qsv_av_err2str(ret).c_str());
+        } else if (ret < 0 && ret != AVERROR(EAGAIN)) {
+            AddMessage(RGY_LOG_ERROR, _T("failed to send packet to video decoder: %s.\n"), qsv_av_err2str(ret).c_str());
+            return RGY_ERR_UNDEFINED_BEHAVIOR;
+        }
+        ret = avcodec_receive_frame(m_Demux.video.codecCtxDecode, frame);
+        if (ret == AVERROR(EAGAIN)) { //もっとパケットを送る必要がある
+            continue;
+        }
+        if (ret == AVERROR_EOF) {
+            //最後まで読み込んだ
+            return RGY_ERR_MORE_DATA;
+        }
+        if (ret < 0) {
+            AddMessage(RGY_LOG_ERROR, _T("failed to receive frame from video decoder: %s.\n"), qsv_av_err2str(ret).c_str());
+            return RGY_ERR_UNDEFINED_BEHAVIOR;
+        }
+        return RGY_ERR_NONE;
+    }
+}
+
+//デコードしたフレームをqVideoFrameから取り出す (デコードスレッド使用時)
+RGY_ERR RGYInputAvcodec::GetDecodedFrame(AVFrame **frame) {
+    //フレームの並べ替えとデコーダのスレッドの分だけ先にパケットを読んでおかないと、デコードスレッドが止まってしまう
+    const size_t pktAhead = AV_FRAME_MAX_REORDER + std::max(m_Demux.thread.decodeThreads, 1) + m_Demux.thread.decodeQueue;
+    for (;;) {
+        //フレームが取り出せる場合でも毎回補充しておかないと、デコード済みのフレームがある間に
+        //パケットを使い切ってしまい、デコードスレッドが先行できなくなる
+        while (m_Demux.qVideoPkt.get_keep_length() > 0 //keep_length == 0なら読み込みは終了している
+            && m_Demux.qVideoPkt.size() < pktAhead) {
+            AVPacket pkt;
+            if (0 == getSample(&pkt)) {
+                m_Demux.qVideoPkt.push(pkt);
+            }
+        }
+        if (m_Demux.qVideoFrame.front_copy_and_pop_no_lock(frame)) {
+            break;
+        }
+        const auto sts = (RGY_ERR)m_Demux.thread.decodeSts.load();
+        if (sts != RGY_ERR_NONE) {
+            //デコードスレッドは最後のフレームを積んでから終了状態をセットするので、もう一度確認する
+            if (m_Demux.qVideoFrame.front_copy_and_pop_no_lock(frame)) {
+                break;
+            }
+            return sts;
+        }
+        m_Demux.qVideoFrame.wait_for_push();
+    }
+    return RGY_ERR_NONE;
+}
+
 #pragma warning(push)
 #pragma warning(disable:4100)
 RGY_ERR RGYInputAvcodec::LoadNextFrame(RGYFrame *pSurface) {
     if (m_Demux.video.codecCtxDecode) {
         //動画のデコードを行う
-        int got_frame = 0;
-        while (!got_frame) {
-            AVPacket pkt;
-            av_init_packet(&pkt);
-            if (!m_Demux.thread.thInput.joinable() //入力スレッドがなければ、自分で読み込む
-                && m_Demux.qVideoPkt.get_keep_length() > 0) { //keep_length == 0なら読み込みは終了していて、これ以上読み込む必要はない
-                if (0 == getSample(&pkt)) {
-                    m_Demux.qVideoPkt.push(pkt);
-                }
-            }
-
-            bool bGetPacket = false;
-            for (int i = 0; false == (bGetPacket = m_Demux.qVideoPkt.front_copy_no_lock(&pkt, (m_Demux.thread.queueInfo) ? &m_Demux.thread.queueInfo->usage_vid_in : nullptr)) && m_Demux.qVideoPkt.size() > 0; i++) {
-                m_Demux.qVideoPkt.wait_for_push();
-            }
-            if (!bGetPacket) {
-                //flushするためのパケット
-                pkt.data = nullptr;
-                pkt.size = 0;
-            }
-            int ret = avcodec_send_packet(m_Demux.video.codecCtxDecode, &pkt);
-            //AVERROR(EAGAIN) -> パケットを送る前に受け取る必要がある
-            //パケットが受け取られていないのでpopしない
-            if (ret != AVERROR(EAGAIN)) {
-                m_Demux.qVideoPkt.pop();
-                av_packet_unref(&pkt);
-            }
-            if (ret == AVERROR_EOF) { //これ以上パケットを送れない
-                AddMessage(RGY_LOG_DEBUG, _T("failed to send packet to video decoder, already flushed: %s.\n"), qsv_av_err2str(ret).c_str());
-            } else if (ret < 0 && ret != AVERROR(EAGAIN)) {
-                AddMessage(RGY_LOG_ERROR, _T("failed to send packet to video decoder: %s.\n"), qsv_av_err2str(ret).c_str());
-                return RGY_ERR_UNDEFINED_BEHAVIOR;
-            }
-            ret = avcodec_receive_frame(m_Demux.video.codecCtxDecode, m_Demux.video.frame);
-            if (ret == AVERROR(EAGAIN)) { //もっとパケットを送る必要がある
-                continue;
-            }
-            if (ret == AVERROR_EOF) {
-                //最後まで読み込んだ
-                return RGY_ERR_MORE_DATA;
-            }
-            if (ret < 0) {
-                AddMessage(RGY_LOG_ERROR, _T("failed to receive frame from video decoder: %s.\n"), qsv_av_err2str(ret).c_str());
-                return RGY_ERR_UNDEFINED_BEHAVIOR;
-            }
-            got_frame = TRUE;
+        //デコードスレッドがあれば、デコード済みのフレームを受け取る (参照を受け取るだけでコピーはしない)
+        AVFrame *frame = m_Demux.video.frame;
+        const bool decodeThread = m_Demux.thread.thDecode.joinable();
+        auto sts = (decodeThread) ? GetDecodedFrame(&frame) : DecodeFrame(frame, false);
+        if (sts != RGY_ERR_NONE) {
+            return sts;
         }
-        pSurface->setTimestamp(m_Demux.video.frame->pts);
-        pSurface->setDuration(m_Demux.video.frame->pkt_duration);
+        pSurface->setTimestamp(frame->pts);
+        pSurface->setDuration(frame->pkt_duration);
         if (pSurface->picstruct() == RGY_PICSTRUCT_AUTO) { //autoの時は、frameのインタレ情報をセットする
-            pSurface->setPicstruct(picstruct_avframe_to_rgy(m_Demux.video.frame));
+            pSurface->setPicstruct(picstruct_avframe_to_rgy(frame));
         }
 #if ENCODER_NVENC
         pSurface->dataList().clear();
         if (m_Demux.video.qpTableListRef != nullptr) {
             int qp_stride = 0;
             int qscale_type = 0;
-            const auto qp_table = av_frame_get_qp_table(m_Demux.video.frame, &qp_stride, &qscale_type);
+            const auto qp_table = av_frame_get_qp_table(frame, &qp_stride, &qscale_type);
             if (qp_table != nullptr) {
                 auto table = m_Demux.video.qpTableListRef->get();
                 const int qpw = (qp_stride) ? qp_stride : (pSurface->width() + 15) / 16;
                 const int qph = (qp_stride) ? (pSurface->height() + 15) / 16 : 1;
-                table->setQPTable(qp_table, qpw, qph, qp_stride, qscale_type, m_Demux.video.frame->pict_type, m_Demux.video.frame->pts);
+                table->setQPTable(qp_table, qpw, qph, qp_stride, qscale_type, frame->pict_type, frame->pts);
                 pSurface->dataList().push_back(table);
             }
         }
         {
-            auto hdr10plus = std::shared_ptr<RGYFrameData>(getHDR10plusMetaData(m_Demux.video.frame));
+            auto hdr10plus = std::shared_ptr<RGYFrameData>(getHDR10plusMetaData(frame));
             if (hdr10plus) {
                 pSurface->dataList().push_back(hdr10plus);
             }
         }
 #endif //#if ENCODER_NVENC
-        //フレームデータをコピー
+        //フレームデータをコピー (色変換は共有のスレッドプールで並列に行われる)
         void *dst_array[3];
         pSurface->ptrArray(dst_array, m_convert->getFunc()->csp_to == RGY_CSP_RGB24 || m_convert->getFunc()->csp_to == RGY_CSP_RGB32);
-        m_convert->run(m_Demux.video.frame->interlaced_frame != 0,
-            dst_array, (const void **)m_Demux.video.frame->data,
-            m_inputVideoInfo.srcWidth, m_Demux.video.frame->linesize[0], m_Demux.video.frame->linesize[1], pSurface->pitch(),
+        m_convert->run(frame->interlaced_frame != 0,
+            dst_array, (const void **)frame->data,
+            m_inputVideoInfo.srcWidth, frame->linesize[0], frame->linesize[1], pSurface->pitch(),
             m_inputVideoInfo.srcHeight, m_inputVideoInfo.srcHeight, m_inputVideoInfo.crop.c);
-        if (got_frame) {
-            av_frame_unref(m_Demux.video.frame);
+        if (decodeThread) {
+            av_frame_free(&frame);
+        } else {
+            av_frame_unref(frame);
         }
         m_encSatusInfo->m_sData.frameIn++;
     } else {
@@ -2595,6 +2966,28 @@ RGY_ERR RGYInputAvcodec::ThreadFuncRead() {
     return RGY_ERR_NONE;
 }
 
+RGY_ERR RGYInputAvcodec::ThreadFuncDecode() {
+    RGY_ERR sts = RGY_ERR_NONE;
+    while (!m_Demux.thread.bAbortDecode) {
+        //デコードしたフレームは、参照を持ったままキューで呼び出し元のスレッドに渡す
+        AVFrame *frame = av_frame_alloc();
+        if (frame == nullptr) {
+            AddMessage(RGY_LOG_ERROR, _T("Failed to allocate frame for decoder.\n"));
+            sts = RGY_ERR_NULL_PTR;
+            break;
+        }
+        if ((sts = DecodeFrame(frame, true)) != RGY_ERR_NONE) {
+            av_frame_free(&frame);
+            break;
+        }
+        m_Demux.qVideoFrame.push(frame);
+    }
+    //最後のフレームを積んでから終了状態をセットする
+    m_Demux.thread.decodeSts = (sts != RGY_ERR_NONE) ? sts : RGY_ERR_ABORTED;
+    AddMessage(RGY_LOG_DEBUG, _T("Decode thread finished: %s.\n"), get_err_mes(sts));
+    return sts;
+}
+
 const AVMasteringDisplayMetadata *RGYInputAvcodec::getMasteringDisplay() const {
     return m_Demux.video.masteringDisplay;
 };
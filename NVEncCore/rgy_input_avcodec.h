@@ -34,6 +34,7 @@
 
 #if ENABLE_AVSW_READER
 #include "rgy_avutil.h"
+#include "rgy_bitstream.h"
 #include "rgy_queue.h"
 #include "rgy_perf_monitor.h"
 #include "convert_csp.h"
@@ -714,16 +715,52 @@ typedef struct AVDemuxVideo {
     AVMasteringDisplayMetadata *masteringDisplay;    //入力ファイルから抽出したHDRメタ情報
     AVContentLightMetadata   *contentLight;          //入力ファイルから抽出したHDRメタ情報
 
-    RGYListRef<RGYFrameDataQP> *qpTableListRef;      //qp tableを格納するときのベース構造体
+    RGYObjectPool<RGYFrameDataQP> *qpTableListRef;      //qp tableを格納するときのベース構造体
 } AVDemuxVideo;
 
 typedef struct AVDemuxThread {
     int                          threadInput;        //入力スレッドを使用する
     std::atomic<bool>            bAbortInput;        //読み込みスレッドに停止を通知する
     std::thread                  thInput;            //読み込みスレッド
+    int                          decodeQueue;        //デコードスレッドで先行してデコードしておくフレーム数 (0ならデコードスレッドを使用しない)
+    int                          decodeThreads;      //libavcodecのデコーダの使用するスレッド数
+    std::atomic<bool>            bAbortDecode;       //デコードスレッドに停止を通知する
+    std::atomic<int>             decodeSts;          //デコードスレッドの終了状態 (終了するまではRGY_ERR_NONE)
+    std::thread                  thDecode;           //デコードスレッド
     PerfQueueInfo               *queueInfo;          //キューの情報を格納する構造体
 } AVDemuxThread;
 
+//入力ファイルのインデックスのキーフレームの情報
+typedef struct AVDemuxIndexKeyframe {
+    int64_t  pts;
+    int64_t  dts;
+    int64_t  pos;          //ファイル上のバイト位置 (不明な場合は-1)
+    int32_t  packetIdx;    //ファイル先頭からの動画パケットの番号 (trimのフレーム番号に対応する)
+    int32_t  flags;        //パケットのフラグ (AV_PKT_FLAG_xxx)
+} AVDemuxIndexKeyframe;
+
+//入力ファイルのインデックス (--input-index)
+//ファイルを先頭から最後まで読み込んだ際に作成して入力ファイルの隣にキャッシュしておき、
+//次回以降はフレームレートの解析の省略と、seek/trimでのキーフレームへの直接のシークに使用する
+typedef struct AVDemuxIndex {
+    bool                         enable;        //インデックスを使用する
+    bool                         loaded;        //キャッシュからキーフレームの情報を読み込んだ
+    bool                         fpsValid;      //キャッシュのフレームレート解析の結果が使用できる
+    bool                         recording;     //ファイル先頭から読み込んでおり、キーフレームを記録している
+    tstring                      filename;      //インデックスのファイル名
+    uint64_t                     fileSize;      //入力ファイルのサイズ
+    int64_t                      mtime;         //入力ファイルの更新時刻
+    uint64_t                     headHash;      //入力ファイルの先頭部分のハッシュ
+    int                          streamIndex;   //動画のストリームの番号
+    int                          analyzeSec;    //フレームレート解析の条件
+    uint32_t                     analyzeFlags;  //フレームレート解析の条件 (pulldown検出, lowlatency)
+    AVRational                   avgFramerate;  //フレームレート解析の結果
+    int                          ptsInvalid;    //フレームレート解析の結果 (RGY_PTS_ALL_INVALID)
+    int                          packetCount;   //ファイル先頭から読み込んだ動画パケットの数
+    int                          trimSkip;      //trimのためにシークで飛ばした動画パケットの数
+    vector<AVDemuxIndexKeyframe> keyframes;     //キーフレームの一覧 (デコード順)
+} AVDemuxIndex;
+
 typedef struct AVDemuxer {
     AVDemuxFormat            format;
     AVDemuxVideo             video;
@@ -731,7 +768,9 @@ typedef struct AVDemuxer {
     vector<AVDemuxStream>    stream;
     vector<const AVChapter*> chapter;
     AVDemuxThread            thread;
+    AVDemuxIndex             index;
     RGYQueueSPSP<AVPacket>   qVideoPkt;
+    RGYQueueSPSP<AVFrame*>   qVideoFrame;        //デコードスレッドでデコードしたフレーム (参照カウントで保持し、コピーはしない)
     deque<AVPacket>          qStreamPktL1;
     RGYQueueSPSP<AVPacket>   qStreamPktL2;
 } AVDemuxer;
@@ -934,6 +973,10 @@ public:
     const TCHAR   *logFramePosList;         //FramePosListの内容を入力終了時に出力する (デバッグ用)
     const TCHAR   *logCopyFrameData;        //frame情報copy関数のログ出力先 (デバッグ用)
     int            threadInput;             //入力スレッドを有効にする
+    int            decodeQueue;             //デコードスレッドで先行してデコードしておくフレーム数 (0でデコードスレッドを使用しない)
+    int            decodeThreads;           //libavcodecのデコーダの使用するスレッド数 (0で自動)
+    RGYAVSWThreadType decodeThreadType;     //libavcodecのデコーダのスレッド並列の方法
+    bool           inputIndex;              //入力ファイルのインデックスをキャッシュする
     PerfQueueInfo *queueInfo;               //キューの情報を格納する構造体
     DeviceCodecCsp *HWDecCodecCsp;          //HWデコーダのサポートするコーデックと色空間
     bool           videoDetectPulldown;     //pulldownの検出を試みるかどうか
@@ -941,7 +984,7 @@ public:
     bool           parseHDRmetadata;        //HDR関連のmeta情報を取得する
     bool           hdr10plusMetadataCopy;  //HDR10plus関連のmeta情報を取得する
     bool           interlaceAutoFrame;      //フレームごとにインタレの検出を行う
-    RGYListRef<RGYFrameDataQP> *qpTableListRef; //qp tableを格納するときのベース構造体
+    RGYObjectPool<RGYFrameDataQP> *qpTableListRef; //qp tableを格納するときのベース構造体
     bool           lowLatency;
     RGYOptList     inputOpt;                //入力オプション
 
@@ -980,7 +1023,7 @@ public:
     double GetInputVideoDuration();
 
     //音声・字幕パケットの配列を取得する
-    virtual vector<AVPacket> GetStreamDataPackets(int inputFrame) override;
+    virtual void GetStreamDataPackets(int inputFrame, vector<AVPacket>& packets) override;
 
     //音声・字幕のコーデックコンテキストを取得する
     virtual vector<AVDemuxStream> GetInputStreamInfo() override;
@@ -1066,9 +1109,38 @@ protected:
     //fpsDecoderはdecoderの推定したfps
     RGY_ERR getFirstFramePosAndFrameRate(const sTrim *pTrimList, int nTrimCount, bool bDetectpulldown, bool lowLatency);
 
+    //解析したフレームのdurationから、平均フレームレートを推定する
+    void estimateAvgFramerate(AVRational fpsDecoder, bool bPulldown, const std::vector<int>& frameDurationList, const vector<std::pair<int, int>>& durationHistgram);
+
+    //入力ファイルのインデックスのキャッシュを確認し、使用できれば読み込む
+    void InitIndex(const TCHAR *strFileName, const RGYInputAvcodecPrm *input_prm);
+
+    //インデックスのキャッシュを読み込む
+    bool LoadIndex();
+
+    //ファイルを先頭から最後まで読み込んでいれば、インデックスを保存する
+    void SaveIndex();
+
+    //インデックスのキーフレームの位置にシークする
+    int seekToIndexKeyframe(const AVDemuxIndexKeyframe& keyframe);
+
+    //インデックスを使用して、最初のtrimの範囲の手前のキーフレームまでシークする
+    RGY_ERR seekIndexForTrim(int trimStart);
+
     //読み込みスレッド関数
     RGY_ERR ThreadFuncRead();
 
+    //パケットをデコーダに送り、1フレーム分デコードしてframeに格納する
+    //decodeThread=trueの場合は、パケットの読み込みは行わず、qVideoPktに積まれるのを待つ
+    RGY_ERR DecodeFrame(AVFrame *frame, bool decodeThread);
+
+    //デコードしたフレームをqVideoFrameから取り出す (デコードスレッド使用時)
+    //パケットの読み込みは呼び出し元のスレッドで行い、デコードスレッドに渡す
+    RGY_ERR GetDecodedFrame(AVFrame **frame);
+
+    //デコードスレッド関数
+    RGY_ERR ThreadFuncDecode();
+
     //指定したptsとtimebaseから、該当する動画フレームを取得する
     int getVideoFrameIdx(int64_t pts, AVRational timebase, int iStart);
 
@@ -1091,6 +1163,8 @@ protected:
     AVDemuxer        m_Demux;                      //デコード用情報
     tstring          m_logFramePosList;           //FramePosListの内容を入力終了時に出力する (デバッグ用)
     vector<uint8_t>  m_hevcMp42AnnexbBuffer;       //HEVCのmp4->AnnexB簡易変換用バッファ
+    vector<nal_info> m_hdr10plusNalList;           //HDR10+のメタデータ検出用のNAL unitの一覧 (使いまわす)
+    vector<uint8_t>  m_unnalBuffer;                //emulation prevention byte除去用バッファ (使いまわす)
     AVCaption2Ass    m_cap2ass;
 };
 
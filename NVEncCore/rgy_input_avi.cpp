@@ -26,6 +26,7 @@
 // ------------------------------------------------------------------------------------------
 
 #include "rgy_input_avi.h"
+#include "rgy_host_frame_pool.h"
 #if ENABLE_AVI_READER
 #pragma warning(disable:4312)
 #pragma warning(disable:4838)
@@ -214,7 +215,7 @@ RGY_ERR RGYInputAvi::LoadNextFrame(RGYFrame *pSurface) {
         uint32_t required_bufsize = m_inputVideoInfo.srcWidth * m_inputVideoInfo.srcHeight * 3;
         if (m_nBufSize < required_bufsize) {
             m_pBuffer.reset();
-            m_pBuffer = std::shared_ptr<uint8_t>((uint8_t *)_aligned_malloc(required_bufsize, 16), aligned_malloc_deleter());
+            m_pBuffer = RGYHostFramePool::get()->alloc(required_bufsize);
             if (!m_pBuffer.get()) {
                 return RGY_ERR_MEMORY_ALLOC;
             }
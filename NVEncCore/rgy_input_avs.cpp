@@ -191,19 +191,18 @@ RGY_ERR RGYInputAvs::InitAudio() {
     return RGY_ERR_NONE;
 }
 
-vector<AVPacket> RGYInputAvs::GetStreamDataPackets(int inputFrame) {
+void RGYInputAvs::GetStreamDataPackets(int inputFrame, vector<AVPacket>& packets) {
     UNREFERENCED_PARAMETER(inputFrame);
 
-    vector<AVPacket> pkts;
     if (m_audio.size() == 0) {
-        return pkts;
+        return;
     }
 
     const auto samplerate = av_make_q(m_sAVSinfo->audio_samples_per_second, 1);
     const auto fps = av_make_q(m_inputVideoInfo.fpsN, m_inputVideoInfo.fpsD);
     auto samples = (int)(av_rescale_q(m_encSatusInfo->m_sData.frameIn, samplerate, fps) - m_audioCurrentSample);
     if (samples <= 0) {
-        return pkts;
+        return;
     }
     if (m_audioCurrentSample + samples > m_sAVSinfo->num_audio_samples) {
         samples = (int)(m_sAVSinfo->num_audio_samples - m_audioCurrentSample);
@@ -212,7 +211,7 @@ vector<AVPacket> RGYInputAvs::GetStreamDataPackets(int inputFrame) {
     const int size = avs_bytes_per_channel_sample(m_sAVSinfo) * samples * m_sAVSinfo->nchannels;
     AVPacket pkt;
     if (av_new_packet(&pkt, size) < 0) {
-        return pkts;
+        return;
     }
     pkt.pts = m_audioCurrentSample;
     pkt.dts = m_audioCurrentSample;
@@ -224,11 +223,11 @@ vector<AVPacket> RGYInputAvs::GetStreamDataPackets(int inputFrame) {
     const auto avs_err = m_sAvisynth.f_clip_get_error(m_sAVSclip);
     if (avs_err) {
         AddMessage(RGY_LOG_ERROR, _T("Unknown error when reading audio frame from avisynth: %d.\n"), avs_err);
-        return pkts;
+        av_packet_unref(&pkt);
+        return;
     }
-    pkts.push_back(pkt);
+    packets.push_back(pkt);
     m_audioCurrentSample += samples;
-    return pkts;
 }
 #endif //#if ENABLE_AVSW_READER
 
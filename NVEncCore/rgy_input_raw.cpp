@@ -26,11 +26,49 @@
 // ------------------------------------------------------------------------------------------
 
 #include <sstream>
+#include <limits>
+#include <chrono>
 #include <fcntl.h>
+#if !(defined(_WIN32) || defined(_WIN64))
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif //#if !(defined(_WIN32) || defined(_WIN64))
 #include "rgy_input_raw.h"
+#include "rgy_host_frame_pool.h"
+#include "rgy_perf_monitor.h"
 
 #if ENABLE_RAW_READER
 
+//direct読み込みでのファイル位置・バッファ・読み込みサイズのアライメント
+static const size_t RGY_INPUT_DIRECT_ALIGN = 4096;
+//mmap読み込みで、読み込み済みの領域をこのサイズごとに物理メモリから解放する
+static const uint64_t RGY_INPUT_MMAP_RELEASE_SIZE = 64 * 1024 * 1024;
+//色変換のSIMD関数は行末を越えて読み込むことがあるので、読み込んだ領域の後ろに読み込み可能な領域をこれだけ確保する
+static const size_t RGY_INPUT_READ_SLACK = 64;
+
+static const TCHAR *get_input_read_mode_str(RGYInputReadMode mode) {
+    const auto str = get_chr_from_value(list_input_read_mode, mode);
+    return (str) ? str : _T("unknown");
+}
+
+//y4mのフレーム位置のインデックスのキャッシュ (入力ファイル名 + 拡張子)
+static const TCHAR *RGY_Y4M_INDEX_EXT = _T(".y4midx");
+static const char RGY_Y4M_INDEX_MAGIC[8] = { 'R', 'G', 'Y', 'Y', '4', 'M', 'I', 'X' };
+static const uint32_t RGY_Y4M_INDEX_VERSION = 1;
+
+struct RGYY4MIndexHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t fileSize;   //入力ファイルのサイズ
+    int64_t mtime;       //入力ファイルの更新時刻
+    uint64_t dataOffset; //最初のフレームの位置
+    uint64_t frameSize;  //1フレームのデータの大きさ (フレームヘッダを除く)
+    uint64_t frameCount; //インデックスに含まれるフレーム数
+};
+
 RGY_ERR RGYInputRaw::ParseY4MHeader(char *buf, VideoInfo *pInfo) {
     char *p, *q = nullptr;
 
@@ -149,10 +187,50 @@ RGY_ERR RGYInputRaw::ParseY4MHeader(char *buf, VideoInfo *pInfo) {
     return RGY_ERR_NONE;
 }
 
+RGYInputRawPrm::RGYInputRawPrm(RGYInputPrm base) :
+    RGYInputPrm(base),
+    prefetch(0),
+    queueInfo(nullptr),
+    seekSec(0.0f),
+    nTrimCount(0),
+    pTrimList(nullptr) {
+
+}
+
 RGYInputRaw::RGYInputRaw() :
     m_fSource(NULL),
     m_nBufSize(0),
-    m_pBuffer() {
+    m_pBuffer(),
+    m_readMode(RGY_INPUT_READ_STDIO),
+    m_fileSize(0),
+    m_filePos(0),
+    m_mapPtr(nullptr),
+    m_mapReleased(0),
+    m_mapTail(),
+    m_mapTailStart(0),
+#if defined(_WIN32) || defined(_WIN64)
+    m_mapHandle(NULL),
+    m_directHandle(INVALID_HANDLE_VALUE),
+#else
+    m_directFd(-1),
+#endif
+    m_directBuf(),
+    m_directBufSize(0),
+    m_directBufStart(0),
+    m_directBufLen(0),
+    m_dataOffset(0),
+    m_seekable(false),
+    m_frameOffset(),
+    m_frameCount(INT_MAX),
+    m_seekFrame(0),
+    m_readFrame(0),
+    m_queueInfo(nullptr),
+    m_prefetchBuf(),
+    m_qPrefetchFree(),
+    m_qPrefetchFrame(),
+    m_prefetchErr(RGY_ERR_NONE),
+    m_prefetchAbort(false),
+    m_prefetchThread() {
     m_readerName = _T("raw");
 }
 
@@ -161,6 +239,14 @@ RGYInputRaw::~RGYInputRaw() {
 }
 
 void RGYInputRaw::Close() {
+    ClosePrefetch();
+    CloseReadMode();
+    m_dataOffset = 0;
+    m_seekable = false;
+    m_frameOffset.clear();
+    m_frameCount = INT_MAX;
+    m_seekFrame = 0;
+    m_readFrame = 0;
     if (m_fSource) {
         fclose(m_fSource);
         m_fSource = NULL;
@@ -170,6 +256,503 @@ void RGYInputRaw::Close() {
     RGYInput::Close();
 }
 
+void RGYInputRaw::CloseReadMode() {
+#if defined(_WIN32) || defined(_WIN64)
+    if (m_mapPtr) {
+        UnmapViewOfFile(m_mapPtr);
+    }
+    if (m_mapHandle) {
+        CloseHandle(m_mapHandle);
+        m_mapHandle = NULL;
+    }
+    if (m_directHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(m_directHandle);
+        m_directHandle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (m_mapPtr) {
+        munmap(m_mapPtr, m_fileSize);
+    }
+    if (m_directFd >= 0) {
+        close(m_directFd);
+        m_directFd = -1;
+    }
+#endif
+    m_mapPtr = nullptr;
+    m_mapReleased = 0;
+    m_mapTail.clear();
+    m_mapTailStart = 0;
+    m_directBuf.reset();
+    m_directBufSize = 0;
+    m_directBufStart = 0;
+    m_directBufLen = 0;
+    m_fileSize = 0;
+    m_filePos = 0;
+    m_readMode = RGY_INPUT_READ_STDIO;
+}
+
+void RGYInputRaw::InitReadMode(const TCHAR *strFileName, RGYInputReadMode readMode, bool use_stdin) {
+    m_readMode = RGY_INPUT_READ_STDIO;
+    if (use_stdin) {
+        if (readMode != RGY_INPUT_READ_AUTO && readMode != RGY_INPUT_READ_STDIO) {
+            AddMessage(RGY_LOG_WARN, _T("--input-read-mode %s is not supported for stdin, switching to stdio.\n"), get_input_read_mode_str(readMode));
+        }
+        return;
+    }
+    bool isRegularFile = false;
+    bool isBlockDevice = false;
+#if defined(_WIN32) || defined(_WIN64)
+    const HANDLE hFile = (HANDLE)_get_osfhandle(_fileno(m_fSource));
+    LARGE_INTEGER fileSize = { 0 };
+    if (GetFileType(hFile) == FILE_TYPE_DISK && GetFileSizeEx(hFile, &fileSize)) {
+        isRegularFile = true;
+        m_fileSize = fileSize.QuadPart;
+    }
+#else
+    struct stat st = { 0 };
+    const int fd = fileno(m_fSource);
+    if (fstat(fd, &st) == 0) {
+        isRegularFile = S_ISREG(st.st_mode);
+        isBlockDevice = S_ISBLK(st.st_mode);
+        if (isBlockDevice) {
+            //m_fSourceと共有しているファイル位置を動かしてしまうので、元の位置に戻しておく
+            const auto cur = lseek(fd, 0, SEEK_CUR);
+            const auto end = lseek(fd, 0, SEEK_END);
+            m_fileSize = (cur >= 0 && end >= 0 && lseek(fd, cur, SEEK_SET) == cur) ? (uint64_t)end : 0;
+        } else {
+            m_fileSize = (uint64_t)st.st_size;
+        }
+    }
+#endif
+    if (readMode == RGY_INPUT_READ_AUTO) {
+        //ブロックデバイスはキャッシュを経由しないdirect、通常のファイルはmmapとする
+        //32bitではファイル全体をマップできないことがあるのでstdioとする
+        if (isBlockDevice) {
+            readMode = RGY_INPUT_READ_DIRECT;
+        } else if (isRegularFile && sizeof(void *) >= 8) {
+            readMode = RGY_INPUT_READ_MMAP;
+        } else {
+            readMode = RGY_INPUT_READ_STDIO;
+        }
+    } else if (readMode != RGY_INPUT_READ_STDIO && !isRegularFile && !isBlockDevice) {
+        AddMessage(RGY_LOG_WARN, _T("--input-read-mode %s is not supported for this input, switching to stdio.\n"), get_input_read_mode_str(readMode));
+        readMode = RGY_INPUT_READ_STDIO;
+    }
+    if (readMode != RGY_INPUT_READ_STDIO && m_fileSize == 0) {
+        readMode = RGY_INPUT_READ_STDIO;
+    }
+    //y4mのヘッダはstdioで読み込んでいるので、その続きから読み込む
+    m_filePos = (uint64_t)_ftelli64(m_fSource);
+    m_dataOffset = m_filePos;
+    m_seekable = m_fileSize > 0;
+    if (readMode == RGY_INPUT_READ_DIRECT) {
+        if (OpenDirect(strFileName) == RGY_ERR_NONE) {
+            m_readMode = RGY_INPUT_READ_DIRECT;
+        } else {
+            AddMessage(RGY_LOG_DEBUG, _T("failed to open file for direct read, switching to mmap.\n"));
+            readMode = RGY_INPUT_READ_MMAP;
+        }
+    }
+    if (readMode == RGY_INPUT_READ_MMAP) {
+        if (OpenMmap() == RGY_ERR_NONE) {
+            m_readMode = RGY_INPUT_READ_MMAP;
+        } else {
+            AddMessage(RGY_LOG_DEBUG, _T("failed to map file, switching to stdio.\n"));
+        }
+    }
+    AddMessage(RGY_LOG_DEBUG, _T("read mode: %s, file size %lld.\n"), get_input_read_mode_str(m_readMode), (long long)m_fileSize);
+}
+
+RGY_ERR RGYInputRaw::OpenMmap() {
+    if (m_fileSize > (uint64_t)std::numeric_limits<size_t>::max()) {
+        return RGY_ERR_UNSUPPORTED;
+    }
+#if defined(_WIN32) || defined(_WIN64)
+    const HANDLE hFile = (HANDLE)_get_osfhandle(_fileno(m_fSource));
+    m_mapHandle = CreateFileMapping(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapHandle == NULL) {
+        return RGY_ERR_NULL_PTR;
+    }
+    m_mapPtr = (uint8_t *)MapViewOfFile(m_mapHandle, FILE_MAP_READ, 0, 0, 0);
+    if (m_mapPtr == nullptr) {
+        CloseHandle(m_mapHandle);
+        m_mapHandle = NULL;
+        return RGY_ERR_NULL_PTR;
+    }
+#else
+    void *ptr = mmap(nullptr, (size_t)m_fileSize, PROT_READ, MAP_SHARED, fileno(m_fSource), 0);
+    if (ptr == MAP_FAILED) {
+        return RGY_ERR_NULL_PTR;
+    }
+    //先読みを積極的に行い、読み込み済みのページは早めに解放させる
+    madvise(ptr, (size_t)m_fileSize, MADV_SEQUENTIAL);
+    m_mapPtr = (uint8_t *)ptr;
+#endif
+    m_mapReleased = 0;
+    //マップした領域の終端の先は読み込めないので、最後のフレームを読み込む可能性のある範囲は
+    //後ろに余裕を持たせたバッファにコピーしておき、そちらを渡す
+    const size_t tailLen = (size_t)std::min<uint64_t>(m_fileSize, (uint64_t)m_nBufSize + 128);
+    m_mapTailStart = m_fileSize - tailLen;
+    m_mapTail.assign(tailLen + RGY_INPUT_READ_SLACK, 0);
+    memcpy(m_mapTail.data(), m_mapPtr + m_mapTailStart, tailLen);
+    return RGY_ERR_NONE;
+}
+
+RGY_ERR RGYInputRaw::OpenDirect(const TCHAR *strFileName) {
+#if defined(_WIN32) || defined(_WIN64)
+    m_directHandle = CreateFile(strFileName, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING,
+        FILE_FLAG_NO_BUFFERING | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (m_directHandle == INVALID_HANDLE_VALUE) {
+        return RGY_ERR_FILE_OPEN;
+    }
+#elif defined(O_DIRECT)
+    m_directFd = open(strFileName, O_RDONLY | O_DIRECT);
+    if (m_directFd < 0) {
+        return RGY_ERR_FILE_OPEN;
+    }
+#else
+    return RGY_ERR_UNSUPPORTED;
+#endif
+    //1フレーム (+y4mのフレームヘッダ) を2つ分保持できるようにし、
+    //読み残した部分を先頭に移動しながら、なるべく大きな単位で読み込む
+    const size_t frameSize = ((size_t)m_nBufSize + 128 + RGY_INPUT_DIRECT_ALIGN - 1) & ~(RGY_INPUT_DIRECT_ALIGN - 1);
+    m_directBufSize = std::max<size_t>(frameSize * 2, 4 * 1024 * 1024);
+    m_directBuf = RGYHostFramePool::get()->alloc(m_directBufSize + RGY_INPUT_READ_SLACK);
+    if (!m_directBuf) {
+        return RGY_ERR_NULL_PTR;
+    }
+    m_directBufStart = 0;
+    m_directBufLen = 0;
+    return RGY_ERR_NONE;
+}
+
+const uint8_t *RGYInputRaw::ReadData(size_t size) {
+    if (m_filePos + size > m_fileSize) {
+        return nullptr;
+    }
+    if (m_readMode == RGY_INPUT_READ_DIRECT) {
+        return ReadDataDirect(size);
+    }
+    const uint8_t *ptr = (m_filePos >= m_mapTailStart) ? m_mapTail.data() + (m_filePos - m_mapTailStart) : m_mapPtr + m_filePos;
+    m_filePos += size;
+    return ptr;
+}
+
+void RGYInputRaw::ReleaseMmap(const uint8_t *consumed) {
+#if !(defined(_WIN32) || defined(_WIN64))
+    //読み込み済みの領域は再び参照しないので、物理メモリから解放しておく
+    //先読み中は読み込み位置が先行しているので、色変換に渡した位置を基準にする
+    //終端付近はm_mapTailのコピーを渡しているので、解放の対象外とする
+    if ((uintptr_t)consumed < (uintptr_t)m_mapPtr || (uintptr_t)consumed >= (uintptr_t)m_mapPtr + m_mapTailStart) {
+        return;
+    }
+    const uint64_t releaseEnd = (uint64_t)(consumed - m_mapPtr) & ~(uint64_t)(RGY_INPUT_DIRECT_ALIGN - 1);
+    if (releaseEnd >= m_mapReleased + RGY_INPUT_MMAP_RELEASE_SIZE) {
+        madvise(m_mapPtr + m_mapReleased, (size_t)(releaseEnd - m_mapReleased), MADV_DONTNEED);
+        m_mapReleased = releaseEnd;
+    }
+#else
+    UNREFERENCED_PARAMETER(consumed);
+#endif
+}
+
+const uint8_t *RGYInputRaw::ReadDataDirect(size_t size) {
+    if (m_filePos < m_directBufStart || m_filePos + size > m_directBufStart + m_directBufLen) {
+        //未使用の部分をバッファの先頭に移動し、続きを読み込む
+        //ファイル上の位置・バッファ上の位置・読み込みサイズはすべてアラインしておく必要がある
+        const uint64_t keepStart = m_filePos & ~(uint64_t)(RGY_INPUT_DIRECT_ALIGN - 1);
+        const uint64_t bufEnd = m_directBufStart + m_directBufLen;
+        if (m_directBufStart <= keepStart && keepStart < bufEnd) {
+            const size_t keep = (size_t)(bufEnd - keepStart);
+            memmove(m_directBuf.get(), m_directBuf.get() + (keepStart - m_directBufStart), keep);
+            m_directBufLen = keep;
+        } else {
+            m_directBufLen = 0;
+        }
+        m_directBufStart = keepStart;
+        while (m_directBufLen < m_directBufSize) {
+            const uint64_t readPos = m_directBufStart + m_directBufLen;
+            const size_t readSize = m_directBufSize - m_directBufLen;
+#if defined(_WIN32) || defined(_WIN64)
+            OVERLAPPED overlapped = { 0 };
+            overlapped.Offset = (DWORD)readPos;
+            overlapped.OffsetHigh = (DWORD)(readPos >> 32);
+            DWORD bytesRead = 0;
+            if (!::ReadFile(m_directHandle, m_directBuf.get() + m_directBufLen, (DWORD)readSize, &bytesRead, &overlapped)) {
+                if (GetLastError() != ERROR_HANDLE_EOF) {
+                    AddMessage(RGY_LOG_ERROR, _T("failed to read file at %lld.\n"), (long long)readPos);
+                    return nullptr;
+                }
+            }
+#else
+            const auto bytesRead = pread(m_directFd, m_directBuf.get() + m_directBufLen, readSize, (off_t)readPos);
+            if (bytesRead < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                AddMessage(RGY_LOG_ERROR, _T("failed to read file at %lld: %s.\n"), (long long)readPos, char_to_tstring(strerror(errno)).c_str());
+                return nullptr;
+            }
+#endif
+            if (bytesRead == 0) {
+                break;
+            }
+            m_directBufLen += (size_t)bytesRead;
+            //アラインされていない長さしか読めなかったのはファイルの終端
+            if (bytesRead % RGY_INPUT_DIRECT_ALIGN) {
+                break;
+            }
+        }
+        if (m_filePos + size > m_directBufStart + m_directBufLen) {
+            return nullptr;
+        }
+    }
+    const uint8_t *ptr = m_directBuf.get() + (m_filePos - m_directBufStart);
+    m_filePos += size;
+    return ptr;
+}
+
+RGY_ERR RGYInputRaw::InitPrefetch(int prefetch) {
+    //先読み中のprefetchフレームと、色変換中の1フレーム分のバッファを用意する
+    const int slotCount = prefetch + 1;
+    if (m_readMode != RGY_INPUT_READ_MMAP) {
+        //mmapではマップした領域をそのまま渡すので、バッファは不要
+        for (int i = 0; i < slotCount; i++) {
+            auto buf = RGYHostFramePool::get()->alloc(m_nBufSize + RGY_INPUT_READ_SLACK);
+            if (!buf) {
+                AddMessage(RGY_LOG_ERROR, _T("Failed to allocate prefetch buffer.\n"));
+                return RGY_ERR_NULL_PTR;
+            }
+            m_prefetchBuf.push_back(buf);
+        }
+    }
+    //格納されるのは最大でもslotCount個だが、内部バッファの詰め直しを減らすため大きめに確保する
+    m_qPrefetchFree.init(std::max(slotCount, 1024));
+    m_qPrefetchFrame.init(std::max(slotCount, 1024));
+    for (int i = 0; i < slotCount; i++) {
+        m_qPrefetchFree.push(i);
+    }
+    m_prefetchErr = RGY_ERR_NONE;
+    m_prefetchAbort = false;
+    m_prefetchThread = std::thread(&RGYInputRaw::ThreadFuncPrefetch, this);
+    AddMessage(RGY_LOG_DEBUG, _T("started prefetch thread: %d frames.\n"), prefetch);
+    return RGY_ERR_NONE;
+}
+
+void RGYInputRaw::ClosePrefetch() {
+    m_prefetchAbort = true;
+    if (m_prefetchThread.joinable()) {
+        AddMessage(RGY_LOG_DEBUG, _T("Closing prefetch thread.\n"));
+        m_prefetchThread.join();
+        AddMessage(RGY_LOG_DEBUG, _T("Closed prefetch thread.\n"));
+    }
+    m_prefetchAbort = false;
+    m_qPrefetchFree.close();
+    m_qPrefetchFrame.close();
+    m_prefetchBuf.clear();
+    m_prefetchErr = RGY_ERR_NONE;
+}
+
+RGY_ERR RGYInputRaw::ThreadFuncPrefetch() {
+    //trimの範囲外のフレームはLoadNextFrameで読み込まずに飛ばされるので、ここでも読み込まない
+    //m_trimParamは先読みの開始前に確定しており、以降変更されない
+    const int maxFrame = getVideoTrimMaxFramIdx();
+    int nextFrame = 0;
+    while (!m_prefetchAbort) {
+        const auto inside = frame_inside_range(nextFrame, m_trimParam.list);
+        if (!inside.first) {
+            nextFrame = (inside.second < (int)m_trimParam.list.size()) ? m_trimParam.list[inside.second].start : maxFrame + 1;
+        }
+        //色変換が終わって空いたバッファを待つ
+        int slot = -1;
+        if (!m_qPrefetchFree.front_copy_and_pop_no_lock(&slot)) {
+            m_qPrefetchFree.wait_for_push();
+            continue;
+        }
+        RGYInputRawPrefetchFrame frame = { 0 };
+        frame.slot = slot;
+        uint8_t *buffer = (m_prefetchBuf.size() > 0) ? m_prefetchBuf[slot].get() : nullptr;
+        uint32_t frameSize = 0;
+        frame.err = (nextFrame > maxFrame) ? RGY_ERR_MORE_DATA : ReadFrameAt(nextFrame, &frame.ptr, buffer, &frameSize);
+        nextFrame++;
+        if (frame.err == RGY_ERR_NONE) {
+            if (m_readMode == RGY_INPUT_READ_DIRECT) {
+                //directの読み込みバッファは次の読み込みで上書きされるので、コピーしておく
+                memcpy(buffer, frame.ptr, frameSize);
+                frame.ptr = buffer;
+            } else if (m_readMode == RGY_INPUT_READ_MMAP) {
+                //ページフォルトによる読み込みをこのスレッドで済ませておく
+                const volatile uint8_t *ptr = frame.ptr;
+                for (uint32_t i = 0; i < frameSize; i += (uint32_t)RGY_INPUT_DIRECT_ALIGN) {
+                    (void)ptr[i];
+                }
+            }
+        }
+        m_qPrefetchFrame.push(frame);
+        if (frame.err != RGY_ERR_NONE) {
+            break;
+        }
+    }
+    return RGY_ERR_NONE;
+}
+
+RGY_ERR RGYInputRaw::InitSeekTrim(const TCHAR *strFileName, float seekSec, const sTrim *pTrimList, int nTrimCount) {
+    m_trimParam.list = make_vector(pTrimList, nTrimCount);
+    m_trimParam.offset = 0;
+    m_seekFrame = (seekSec > 0.0f) ? (int)(seekSec * (double)m_inputVideoInfo.fpsN / (double)m_inputVideoInfo.fpsD) : 0;
+    m_readFrame = 0;
+    if (m_seekable && m_inputVideoInfo.type == RGY_INPUT_FMT_RAW) {
+        m_frameCount = (int)std::min<uint64_t>((m_fileSize - m_dataOffset) / m_nBufSize, INT_MAX);
+    }
+    if (m_seekFrame == 0 && m_trimParam.list.size() == 0) {
+        return RGY_ERR_NONE;
+    }
+    if (m_seekable && m_inputVideoInfo.type == RGY_INPUT_FMT_Y4M) {
+        //y4mはフレームヘッダの長さが可変なので、フレームの位置を調べておく必要がある
+        //一度作成したインデックスは入力ファイルの隣にキャッシュし、次回以降はそれを使用する
+        const tstring indexFile = tstring(strFileName) + RGY_Y4M_INDEX_EXT;
+        const int64_t mtime = rgy_get_file_mtime(m_fSource);
+        if (LoadY4MFrameIndex(indexFile, mtime)) {
+            AddMessage(RGY_LOG_DEBUG, _T("loaded y4m frame index from \"%s\": %d frames.\n"), indexFile.c_str(), (int)m_frameOffset.size());
+        } else {
+            const auto timeStart = std::chrono::system_clock::now();
+            auto err = BuildY4MFrameIndex();
+            if (err != RGY_ERR_NONE) {
+                return err;
+            }
+            AddMessage(RGY_LOG_DEBUG, _T("built y4m frame index: %d frames, %.1f ms.\n"), (int)m_frameOffset.size(),
+                std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now() - timeStart).count() * 1e-3);
+            SaveY4MFrameIndex(indexFile, mtime);
+        }
+        m_frameCount = (int)m_frameOffset.size();
+    }
+    if (m_seekable && m_trimParam.list.size() > 0 && m_trimParam.list[0].start > 0) {
+        //最初のtrimの範囲の先頭まではシークで飛ばし、そのぶんのずれをoffsetとして記録する
+        m_trimParam.offset = m_trimParam.list[0].start;
+        for (auto& trim : m_trimParam.list) {
+            trim.start -= m_trimParam.offset;
+            if (trim.fin != TRIM_MAX) {
+                trim.fin -= m_trimParam.offset;
+            }
+        }
+        AddMessage(RGY_LOG_DEBUG, _T("adjust trim by offset %d.\n"), m_trimParam.offset);
+    }
+    if (m_seekFrame > 0) {
+        AddMessage(RGY_LOG_DEBUG, _T("seek to frame %d (%s).\n"), m_seekFrame, (m_seekable) ? _T("seek") : _T("skip"));
+    }
+    if (m_seekFrame + m_trimParam.offset >= m_frameCount) {
+        AddMessage(RGY_LOG_ERROR, _T("seek/trim position (frame %d) exceeds number of frames in the input (%d).\n"), m_seekFrame + m_trimParam.offset, m_frameCount);
+        return RGY_ERR_INVALID_PARAM;
+    }
+    return RGY_ERR_NONE;
+}
+
+RGY_ERR RGYInputRaw::BuildY4MFrameIndex() {
+    m_frameOffset.clear();
+    //フレームヘッダは"FRAME" + 最大64文字のパラメータ + 改行
+    char buf[128];
+    for (uint64_t pos = m_dataOffset; pos < m_fileSize; ) {
+        const char *header = buf;
+        size_t headerSize = 0;
+        if (m_mapPtr) {
+            header = (const char *)m_mapPtr + pos;
+            headerSize = (size_t)std::min<uint64_t>(sizeof(buf), m_fileSize - pos);
+        } else {
+            if (_fseeki64(m_fSource, pos, SEEK_SET) != 0) {
+                break;
+            }
+            headerSize = _fread_nolock(buf, 1, sizeof(buf), m_fSource);
+        }
+        if (headerSize < strlen("FRAME") || memcmp(header, "FRAME", strlen("FRAME")) != 0) {
+            break;
+        }
+        const char *lf = (const char *)memchr(header, '\n', headerSize);
+        if (lf == nullptr) {
+            break;
+        }
+        const uint64_t next = pos + (lf - header) + 1 + m_nBufSize;
+        if (next > m_fileSize) {
+            break; //途中で途切れているフレーム
+        }
+        m_frameOffset.push_back(pos);
+        pos = next;
+    }
+    //読み込み位置を最初のフレームに戻す
+    if (_fseeki64(m_fSource, m_dataOffset, SEEK_SET) != 0) {
+        AddMessage(RGY_LOG_ERROR, _T("failed to seek to the first frame.\n"));
+        return RGY_ERR_UNKNOWN;
+    }
+    return RGY_ERR_NONE;
+}
+
+bool RGYInputRaw::LoadY4MFrameIndex(const tstring& indexFile, int64_t mtime) {
+    FILE *fp = nullptr;
+    if (_tfopen_s(&fp, indexFile.c_str(), _T("rb")) != 0 || fp == nullptr) {
+        return false;
+    }
+    std::unique_ptr<FILE, decltype(&fclose)> fpIndex(fp, fclose);
+    RGYY4MIndexHeader header = { 0 };
+    if (fread(&header, 1, sizeof(header), fp) != sizeof(header)
+        || memcmp(header.magic, RGY_Y4M_INDEX_MAGIC, sizeof(header.magic)) != 0
+        || header.version != RGY_Y4M_INDEX_VERSION
+        || header.fileSize != m_fileSize
+        || header.mtime != mtime
+        || header.dataOffset != m_dataOffset
+        || header.frameSize != m_nBufSize
+        || header.frameCount > (uint64_t)INT_MAX) {
+        AddMessage(RGY_LOG_DEBUG, _T("y4m frame index \"%s\" does not match the input, rebuilding.\n"), indexFile.c_str());
+        return false;
+    }
+    std::vector<uint64_t> frameOffset((size_t)header.frameCount);
+    if (header.frameCount > 0
+        && fread(frameOffset.data(), sizeof(frameOffset[0]), frameOffset.size(), fp) != frameOffset.size()) {
+        return false;
+    }
+    //フレームの位置が正しく並んでいるかを確認する
+    for (size_t i = 0; i < frameOffset.size(); i++) {
+        const uint64_t prevEnd = (i > 0) ? frameOffset[i-1] + strlen("FRAME\n") + m_nBufSize : m_dataOffset;
+        if (frameOffset[i] < prevEnd || frameOffset[i] + strlen("FRAME\n") + m_nBufSize > m_fileSize) {
+            return false;
+        }
+    }
+    m_frameOffset = std::move(frameOffset);
+    return true;
+}
+
+void RGYInputRaw::SaveY4MFrameIndex(const tstring& indexFile, int64_t mtime) {
+    FILE *fp = nullptr;
+    if (_tfopen_s(&fp, indexFile.c_str(), _T("wb")) != 0 || fp == nullptr) {
+        AddMessage(RGY_LOG_DEBUG, _T("failed to open \"%s\" to save y4m frame index.\n"), indexFile.c_str());
+        return;
+    }
+    RGYY4MIndexHeader header = { 0 };
+    memcpy(header.magic, RGY_Y4M_INDEX_MAGIC, sizeof(header.magic));
+    header.version = RGY_Y4M_INDEX_VERSION;
+    header.fileSize = m_fileSize;
+    header.mtime = mtime;
+    header.dataOffset = m_dataOffset;
+    header.frameSize = m_nBufSize;
+    header.frameCount = m_frameOffset.size();
+    bool ret = fwrite(&header, 1, sizeof(header), fp) == sizeof(header)
+        && fwrite(m_frameOffset.data(), sizeof(m_frameOffset[0]), m_frameOffset.size(), fp) == m_frameOffset.size();
+    ret = (fclose(fp) == 0) && ret;
+    if (!ret) {
+        //書き込みに失敗した場合は、不完全なキャッシュを残さない
+        _tremove(indexFile.c_str());
+        AddMessage(RGY_LOG_DEBUG, _T("failed to save y4m frame index to \"%s\".\n"), indexFile.c_str());
+        return;
+    }
+    AddMessage(RGY_LOG_DEBUG, _T("saved y4m frame index to \"%s\".\n"), indexFile.c_str());
+}
+
+bool RGYInputRaw::SetPadding(const sInputCrop& pad) {
+    if (!m_convert || !m_convert->setPadding(pad)) {
+        return false;
+    }
+    AddMessage(RGY_LOG_DEBUG, _T("padding on input: left %d, top %d, right %d, bottom %d.\n"), pad.e.left, pad.e.up, pad.e.right, pad.e.bottom);
+    return true;
+}
+
 RGY_ERR RGYInputRaw::Init(const TCHAR *strFileName, VideoInfo *pInputInfo, const RGYInputPrm *prm) {
     memcpy(&m_inputVideoInfo, pInputInfo, sizeof(m_inputVideoInfo));
 
@@ -288,10 +871,23 @@ RGY_ERR RGYInputRaw::Init(const TCHAR *strFileName, VideoInfo *pInputInfo, const
         m_inputVideoInfo.csp = output_csp_if_lossless;
     }
 
-    m_pBuffer = std::shared_ptr<uint8_t>((uint8_t *)_aligned_malloc(bufferSize, 32), aligned_malloc_deleter());
-    if (!m_pBuffer) {
-        AddMessage(RGY_LOG_ERROR, _T("Failed to allocate input buffer.\n"));
-        return RGY_ERR_NULL_PTR;
+    m_nBufSize = bufferSize;
+    InitReadMode(strFileName, prm->readMode, use_stdin);
+    const RGYInputRawPrm *prmRaw = dynamic_cast<const RGYInputRawPrm *>(prm);
+    const int prefetch = (prmRaw) ? prmRaw->prefetch : 0;
+    if (prmRaw) {
+        auto err = InitSeekTrim(strFileName, prmRaw->seekSec, prmRaw->pTrimList, prmRaw->nTrimCount);
+        if (err != RGY_ERR_NONE) {
+            return err;
+        }
+    }
+    if (prefetch == 0 && m_readMode == RGY_INPUT_READ_STDIO) {
+        //mmap/directでは読み込んだ領域から直接色変換するので、m_pBufferは不要
+        m_pBuffer = RGYHostFramePool::get()->alloc(bufferSize);
+        if (!m_pBuffer) {
+            AddMessage(RGY_LOG_ERROR, _T("Failed to allocate input buffer.\n"));
+            return RGY_ERR_NULL_PTR;
+        }
     }
 
     m_inputVideoInfo.shift = ((m_inputVideoInfo.csp == RGY_CSP_P010 || m_inputVideoInfo.csp == RGY_CSP_P210) && m_inputVideoInfo.shift) ? m_inputVideoInfo.shift : 0;
@@ -302,20 +898,39 @@ RGY_ERR RGYInputRaw::Init(const TCHAR *strFileName, VideoInfo *pInputInfo, const
         return RGY_ERR_INVALID_COLOR_FORMAT;
     }
 
+    if (prefetch > 0) {
+        //読み込むフレームの大きさは色変換の関数から決まるので、その後で先読みを開始する
+        m_queueInfo = prmRaw->queueInfo;
+        auto err = InitPrefetch(prefetch);
+        if (err != RGY_ERR_NONE) {
+            return err;
+        }
+    }
+
     CreateInputInfo(m_readerName.c_str(), RGY_CSP_NAMES[m_convert->getFunc()->csp_from], RGY_CSP_NAMES[m_convert->getFunc()->csp_to], get_simd_str(m_convert->getFunc()->simd), &m_inputVideoInfo);
     AddMessage(RGY_LOG_DEBUG, m_inputInfo);
     *pInputInfo = m_inputVideoInfo;
     return RGY_ERR_NONE;
 }
 
-RGY_ERR RGYInputRaw::LoadNextFrame(RGYFrame *pSurface) {
-    //m_encSatusInfo->m_nInputFramesがtrimの結果必要なフレーム数を大きく超えたら、エンコードを打ち切る
-    //ちょうどのところで打ち切ると他のストリームに影響があるかもしれないので、余分に取得しておく
-    if (getVideoTrimMaxFramIdx() < (int)m_encSatusInfo->m_sData.frameIn - TRIM_OVERREAD_FRAMES) {
-        return RGY_ERR_MORE_DATA;
-    }
-
-    if (m_inputVideoInfo.type == RGY_INPUT_FMT_Y4M) {
+RGY_ERR RGYInputRaw::ReadFrame(const uint8_t **frameData, uint8_t *buffer, uint32_t *pFrameSize) {
+    if (m_inputVideoInfo.type == RGY_INPUT_FMT_Y4M && m_readMode != RGY_INPUT_READ_STDIO) {
+        const uint8_t *y4m_buf = ReadData(strlen("FRAME"));
+        if (y4m_buf == nullptr || memcmp(y4m_buf, "FRAME", strlen("FRAME")) != 0) {
+            AddMessage(RGY_LOG_DEBUG, _T("header1: finish.\n"));
+            return RGY_ERR_MORE_DATA;
+        }
+        for (int i = 0; ; i++) {
+            const uint8_t *c = ReadData(1);
+            if (c == nullptr || i >= 64) {
+                AddMessage(RGY_LOG_DEBUG, _T("header3: finish.\n"));
+                return RGY_ERR_MORE_DATA;
+            }
+            if (*c == '\n') {
+                break;
+            }
+        }
+    } else if (m_inputVideoInfo.type == RGY_INPUT_FMT_Y4M) {
         uint8_t y4m_buf[8] = { 0 };
         if (_fread_nolock(y4m_buf, 1, strlen("FRAME"), m_fSource) != strlen("FRAME")) {
             AddMessage(RGY_LOG_DEBUG, _T("header1: finish.\n"));
@@ -367,16 +982,108 @@ RGY_ERR RGYInputRaw::LoadNextFrame(RGYFrame *pSurface) {
         AddMessage(RGY_LOG_ERROR, _T("Unknown color foramt.\n"));
         return RGY_ERR_INVALID_COLOR_FORMAT;
     }
-    if (frameSize != _fread_nolock(m_pBuffer.get(), 1, frameSize, m_fSource)) {
+    *pFrameSize = frameSize;
+    if (m_readMode != RGY_INPUT_READ_STDIO) {
+        //mmap/directでは、読み込んだ領域から直接色変換する
+        *frameData = ReadData(frameSize);
+        if (*frameData == nullptr) {
+            AddMessage(RGY_LOG_DEBUG, _T("read: finish: %d.\n"), frameSize);
+            return RGY_ERR_MORE_DATA;
+        }
+    } else if (frameSize != _fread_nolock(buffer, 1, frameSize, m_fSource)) {
         AddMessage(RGY_LOG_DEBUG, _T("fread: finish: %d.\n"), frameSize);
         return RGY_ERR_MORE_DATA;
+    } else {
+        *frameData = buffer;
+    }
+    return RGY_ERR_NONE;
+
+}
+
+RGY_ERR RGYInputRaw::ReadFrameAt(int frame, const uint8_t **frameData, uint8_t *buffer, uint32_t *pFrameSize) {
+    const int srcFrame = m_seekFrame + m_trimParam.offset + frame;
+    if (srcFrame >= m_frameCount) {
+        return RGY_ERR_MORE_DATA;
+    }
+    if (srcFrame != m_readFrame) {
+        if (m_seekable) {
+            const uint64_t pos = (m_frameOffset.size() > 0) ? m_frameOffset[srcFrame] : m_dataOffset + (uint64_t)srcFrame * m_nBufSize;
+            if (m_readMode != RGY_INPUT_READ_STDIO) {
+                m_filePos = pos;
+            } else if (_fseeki64(m_fSource, pos, SEEK_SET) != 0) {
+                AddMessage(RGY_LOG_ERROR, _T("failed to seek to frame %d.\n"), srcFrame);
+                return RGY_ERR_UNKNOWN;
+            }
+            m_readFrame = srcFrame;
+        } else {
+            //パイプなどシークできない場合は、途中のフレームを読み捨てる
+            while (m_readFrame < srcFrame) {
+                auto err = ReadFrame(frameData, buffer, pFrameSize);
+                if (err != RGY_ERR_NONE) {
+                    return err;
+                }
+                m_readFrame++;
+            }
+        }
+    }
+    auto err = ReadFrame(frameData, buffer, pFrameSize);
+    if (err == RGY_ERR_NONE) {
+        m_readFrame++;
+    }
+    return err;
+}
+
+RGY_ERR RGYInputRaw::LoadNextFrame(RGYFrame *pSurface) {
+    //m_encSatusInfo->m_nInputFramesがtrimの結果必要なフレーム数を大きく超えたら、エンコードを打ち切る
+    //ちょうどのところで打ち切ると他のストリームに影響があるかもしれないので、余分に取得しておく
+    if (getVideoTrimMaxFramIdx() < (int)m_encSatusInfo->m_sData.frameIn - TRIM_OVERREAD_FRAMES) {
+        return RGY_ERR_MORE_DATA;
+    }
+
+    const int frame = (int)m_encSatusInfo->m_sData.frameIn;
+    if (m_seekFrame + m_trimParam.offset + frame >= m_frameCount) {
+        return RGY_ERR_MORE_DATA;
+    }
+    if (!frame_inside_range(frame, m_trimParam.list).first) {
+        //trimの範囲外のフレームはエンコーダ側で捨てられるので、読み込みも色変換も行わずに返す
+        //読み込み位置は、次に範囲内のフレームを読む際にシーク (シークできなければ読み捨て) で合わせる
+        m_encSatusInfo->m_sData.frameIn++;
+        return m_encSatusInfo->UpdateDisplay();
+    }
+
+    const uint8_t *frameData = nullptr;
+    int prefetchSlot = -1;
+    if (m_prefetchThread.joinable()) {
+        //先読みスレッドで読み込み済みのフレームを受け取る
+        if (m_prefetchErr != RGY_ERR_NONE) {
+            return m_prefetchErr;
+        }
+        RGYInputRawPrefetchFrame frame = { 0 };
+        while (!m_qPrefetchFrame.front_copy_and_pop_no_lock(&frame, (m_queueInfo) ? &m_queueInfo->usage_vid_in : nullptr)) {
+            m_qPrefetchFrame.wait_for_push();
+        }
+        if (frame.err != RGY_ERR_NONE) {
+            m_prefetchErr = frame.err;
+            return m_prefetchErr;
+        }
+        frameData = frame.ptr;
+        prefetchSlot = frame.slot;
+    } else {
+        uint32_t frameSize = 0;
+        auto err = ReadFrameAt(frame, &frameData, m_pBuffer.get(), &frameSize);
+        if (err != RGY_ERR_NONE) {
+            return err;
+        }
+    }
+    if (m_readMode == RGY_INPUT_READ_MMAP) {
+        ReleaseMmap(frameData);
     }
 
     void *dst_array[3];
     pSurface->ptrArray(dst_array, m_convert->getFunc()->csp_to == RGY_CSP_RGB24 || m_convert->getFunc()->csp_to == RGY_CSP_RGB32);
 
     const void *src_array[3];
-    src_array[0] = m_pBuffer.get();
+    src_array[0] = frameData;
     src_array[1] = (uint8_t *)src_array[0] + m_inputVideoInfo.srcPitch * m_inputVideoInfo.srcHeight;
     switch (m_convert->getFunc()->csp_from) {
     case RGY_CSP_YV12:
@@ -427,6 +1134,10 @@ RGY_ERR RGYInputRaw::LoadNextFrame(RGYFrame *pSurface) {
     m_convert->run((m_inputVideoInfo.picstruct & RGY_PICSTRUCT_INTERLACED) ? 1 : 0,
         dst_array, src_array, m_inputVideoInfo.srcWidth, m_inputVideoInfo.srcPitch,
         src_uv_pitch, pSurface->pitch(), m_inputVideoInfo.srcHeight, m_inputVideoInfo.srcHeight, m_inputVideoInfo.crop.c);
+    if (prefetchSlot >= 0) {
+        //色変換が終わったので、バッファを先読みスレッドに返却する
+        m_qPrefetchFree.push(prefetchSlot);
+    }
 
     m_encSatusInfo->m_sData.frameIn++;
     return m_encSatusInfo->UpdateDisplay();
@@ -29,10 +29,34 @@
 #ifndef __RGY_INPUT_RAW_H__
 #define __RGY_INPUT_RAW_H__
 
+#include <atomic>
+#include <thread>
 #include "rgy_input.h"
+#include "rgy_queue.h"
 
 #if ENABLE_RAW_READER
 
+struct PerfQueueInfo;
+
+class RGYInputRawPrm : public RGYInputPrm {
+public:
+    int prefetch;             //先読みするフレーム数 (0で先読みしない)
+    PerfQueueInfo *queueInfo; //キューの情報を格納する構造体
+    float seekSec;            //指定された秒数分先頭を飛ばす
+    int nTrimCount;           //Trimする動画フレームの領域の数
+    sTrim *pTrimList;         //Trimする動画フレームの領域のリスト
+
+    RGYInputRawPrm(RGYInputPrm base);
+    virtual ~RGYInputRawPrm() {};
+};
+
+//先読みスレッドから渡される、読み込み済みのフレーム
+struct RGYInputRawPrefetchFrame {
+    const uint8_t *ptr; //フレームデータの先頭
+    int slot;           //使用しているバッファのindex
+    RGY_ERR err;        //読み込み結果 (RGY_ERR_NONE以外なら、ptrは無効で以降のフレームはない)
+};
+
 class RGYInputRaw : public RGYInput {
 public:
     RGYInputRaw();
@@ -41,14 +65,78 @@ public:
     virtual RGY_ERR LoadNextFrame(RGYFrame *pSurface) override;
     virtual void Close() override;
 
+    //色変換と同時にpaddingを付加する (対応していない場合はfalse)
+    //以降、LoadNextFrameにはpadding後の大きさのフレームを渡す必要がある
+    bool SetPadding(const sInputCrop& pad);
+
 protected:
     virtual RGY_ERR Init(const TCHAR *strFileName, VideoInfo *pInputInfo, const RGYInputPrm *prm) override;
     RGY_ERR ParseY4MHeader(char *buf, VideoInfo *pInfo);
 
+    //ファイルの種類に応じて読み込み方法を決め、mmap/directの準備を行う
+    void InitReadMode(const TCHAR *strFileName, RGYInputReadMode readMode, bool use_stdin);
+    RGY_ERR OpenMmap();
+    RGY_ERR OpenDirect(const TCHAR *strFileName);
+    void CloseReadMode();
+    //mmap/direct: 現在位置からsizeバイトを読み込み、その先頭へのポインタを返す (次の呼び出しまで有効)
+    const uint8_t *ReadData(size_t size);
+    const uint8_t *ReadDataDirect(size_t size);
+    //1フレーム分のデータを読み込み、frameDataにその先頭を返す
+    //stdioではbufferに読み込み、mmap/directでは読み込んだ領域を直接返す
+    RGY_ERR ReadFrame(const uint8_t **frameData, uint8_t *buffer, uint32_t *pFrameSize);
+    //trim反映後のframe番目のフレームを読み込む
+    //シーク可能ならそのフレームの位置へシークし、そうでなければ途中のフレームを読み捨てる
+    RGY_ERR ReadFrameAt(int frame, const uint8_t **frameData, uint8_t *buffer, uint32_t *pFrameSize);
+    //mmap: consumedより前の読み込み済みの領域を物理メモリから解放する
+    void ReleaseMmap(const uint8_t *consumed);
+
+    //--seek/--trimを反映し、必要ならフレームの位置のインデックスを作成する
+    RGY_ERR InitSeekTrim(const TCHAR *strFileName, float seekSec, const sTrim *pTrimList, int nTrimCount);
+    RGY_ERR BuildY4MFrameIndex();
+    bool LoadY4MFrameIndex(const tstring& indexFile, int64_t mtime);
+    void SaveY4MFrameIndex(const tstring& indexFile, int64_t mtime);
+
+    RGY_ERR InitPrefetch(int prefetch);
+    void ClosePrefetch();
+    RGY_ERR ThreadFuncPrefetch();
+
     FILE *m_fSource;
 
     uint32_t m_nBufSize;
     shared_ptr<uint8_t> m_pBuffer;
+
+    RGYInputReadMode m_readMode;  //実際に使用している読み込み方法
+    uint64_t m_fileSize;          //mmap/direct: ファイルサイズ
+    uint64_t m_filePos;           //mmap/direct: 現在の読み込み位置
+    uint8_t *m_mapPtr;            //mmap: ファイルをマップした先頭
+    uint64_t m_mapReleased;       //mmap: 物理メモリから解放済みの位置
+    std::vector<uint8_t> m_mapTail; //mmap: ファイル終端付近のコピー (後ろに読み込み可能な余裕を持たせたもの)
+    uint64_t m_mapTailStart;      //mmap: m_mapTailの先頭のファイル上の位置
+#if defined(_WIN32) || defined(_WIN64)
+    HANDLE m_mapHandle;           //mmap: file mapping object
+    HANDLE m_directHandle;        //direct: FILE_FLAG_NO_BUFFERINGで開いたファイル
+#else
+    int m_directFd;               //direct: O_DIRECTで開いたファイル
+#endif
+    shared_ptr<uint8_t> m_directBuf; //direct: アラインした読み込みバッファ
+    size_t m_directBufSize;       //direct: m_directBufの大きさ
+    uint64_t m_directBufStart;    //direct: m_directBufの先頭のファイル上の位置
+    size_t m_directBufLen;        //direct: m_directBufに読み込み済みのデータの長さ
+
+    uint64_t m_dataOffset;               //最初のフレームのファイル上の位置
+    bool m_seekable;                     //フレームの位置へシーク可能か
+    std::vector<uint64_t> m_frameOffset; //y4m: 各フレームのヘッダ("FRAME")のファイル上の位置
+    int m_frameCount;                    //ファイル内のフレーム数 (不明ならINT_MAX)
+    int m_seekFrame;                     //--seekで飛ばすフレーム数
+    int m_readFrame;                     //次に読み込まれるフレームのファイル先頭からの番号 (読み込み側のスレッドのみ使用)
+
+    PerfQueueInfo *m_queueInfo;                             //キューの情報を格納する構造体
+    std::vector<shared_ptr<uint8_t>> m_prefetchBuf;         //先読み: フレームバッファ (mmapでは不要)
+    RGYQueueSPSP<int> m_qPrefetchFree;                      //先読み: 空いているバッファのindex
+    RGYQueueSPSP<RGYInputRawPrefetchFrame> m_qPrefetchFrame; //先読み: 読み込み済みのフレーム
+    RGY_ERR m_prefetchErr;                                  //先読み: 終端またはエラーで停止した場合の結果
+    std::atomic<bool> m_prefetchAbort;                      //先読みスレッドに停止を通知する
+    std::thread m_prefetchThread;                           //先読みスレッド
 };
 
 #endif //ENABLE_RAW_READER
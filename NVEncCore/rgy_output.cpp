@@ -27,7 +27,14 @@
 
 #include "rgy_output.h"
 #include "rgy_bitstream.h"
+#include "rgy_host_frame_pool.h"
 #include <smmintrin.h>
+#if !(defined(_WIN32) || defined(_WIN64))
+#include <climits>
+#include <cerrno>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif //#if !(defined(_WIN32) || defined(_WIN64))
 
 #if ENCODER_QSV
 
@@ -106,7 +113,9 @@ void RGYOutput::Close() {
 }
 
 RGYOutputRaw::RGYOutputRaw() :
-    m_seiNal()
+    m_seiNal(),
+    m_nalList(),
+    m_writeSpans()
 #if ENABLE_AVSW_READER
     , m_pBsfc()
 #endif //#if ENABLE_AVSW_READER
@@ -275,24 +284,76 @@ RGY_ERR RGYOutputRaw::Init(const TCHAR *strFileName, const VideoInfo *pVideoOutp
 }
 #pragma warning (pop)
 
+//これ以上のサイズをまとめて書き出す場合は、stdioのバッファへのコピーを避け、writevで直接書き出す
+static const size_t RGY_OUTPUT_WRITEV_MIN_SIZE = 1024 * 1024;
+
+RGY_ERR RGYOutputRaw::WriteSpans() {
+#if !(defined(_WIN32) || defined(_WIN64))
+    size_t totalSize = 0;
+    for (const auto& span : m_writeSpans) {
+        totalSize += span.second;
+    }
+    if (totalSize >= RGY_OUTPUT_WRITEV_MIN_SIZE) {
+        //stdioのバッファに残っているデータを先に書き出しておかないと、順序が入れ替わってしまう
+        if (fflush(m_fDest.get()) != 0) {
+            AddMessage(RGY_LOG_ERROR, _T("Error writing file.\nNot enough disk space!\n"));
+            return RGY_ERR_UNDEFINED_BEHAVIOR;
+        }
+        const int fd = fileno(m_fDest.get());
+        std::vector<struct iovec> iov;
+        iov.reserve(m_writeSpans.size());
+        for (const auto& span : m_writeSpans) {
+            if (span.second > 0) {
+                iov.push_back({ (void *)span.first, span.second });
+            }
+        }
+        size_t idx = 0;
+        while (idx < iov.size()) {
+            const int count = (int)std::min<size_t>(iov.size() - idx, IOV_MAX);
+            const auto ret = writev(fd, &iov[idx], count);
+            if (ret < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                AddMessage(RGY_LOG_ERROR, _T("Error writing file.\nNot enough disk space!\n"));
+                return RGY_ERR_UNDEFINED_BEHAVIOR;
+            }
+            //書き込めた分だけ進め、途中までしか書き込めなかった領域は残りから再開する
+            size_t written = (size_t)ret;
+            while (idx < iov.size() && written >= iov[idx].iov_len) {
+                written -= iov[idx].iov_len;
+                idx++;
+            }
+            if (written > 0) {
+                iov[idx].iov_base = (uint8_t *)iov[idx].iov_base + written;
+                iov[idx].iov_len -= written;
+            }
+        }
+        return RGY_ERR_NONE;
+    }
+#endif //#if !(defined(_WIN32) || defined(_WIN64))
+    for (const auto& span : m_writeSpans) {
+        WRITE_CHECK(_fwrite_nolock(span.first, 1, span.second, m_fDest.get()), span.second);
+    }
+    return RGY_ERR_NONE;
+}
+
 RGY_ERR RGYOutputRaw::WriteNextFrame(RGYBitstream *pBitstream) {
     if (pBitstream == nullptr) {
         AddMessage(RGY_LOG_ERROR, _T("Invalid call: WriteNextFrame\n"));
         return RGY_ERR_NULL_PTR;
     }
 
-    size_t nBytesWritten = 0;
     if (!m_noOutput) {
 #if ENABLE_AVSW_READER
         if (m_pBsfc) {
             uint8_t nal_type = 0;
-            std::vector<nal_info> nal_list;
+            auto& nal_list = m_nalList;
+            pBitstream->nalList(m_VideoOutputInfo.codec, nal_list);
             if (m_VideoOutputInfo.codec == RGY_CODEC_HEVC) {
                 nal_type = NALU_HEVC_SPS;
-                nal_list = parse_nal_unit_hevc(pBitstream->data(), pBitstream->size());
             } else if (m_VideoOutputInfo.codec == RGY_CODEC_H264) {
                 nal_type = NALU_H264_SPS;
-                nal_list = parse_nal_unit_h264(pBitstream->data(), pBitstream->size());
             }
             auto sps_nal = std::find_if(nal_list.begin(), nal_list.end(), [](nal_info info) { return info.type == NALU_HEVC_SPS; });
             if (sps_nal != nal_list.end()) {
@@ -327,34 +388,45 @@ RGY_ERR RGYOutputRaw::WriteNextFrame(RGYBitstream *pBitstream) {
                 }
                 memmove(pBitstream->data() + next_nal_new_offset, pBitstream->data() + next_nal_orig_offset, stream_orig_length - next_nal_orig_offset);
                 memcpy(pBitstream->data() + sps_nal_offset, pkt.data, pkt.size);
+                pBitstream->invalidateNalList();
                 av_packet_unref(&pkt);
             }
         }
 #endif //#if ENABLE_AVSW_READER
         if (m_seiNal.size()) {
-            const auto nal_list     = parse_nal_unit_hevc(pBitstream->data(), pBitstream->size());
+            auto& nal_list = m_nalList;
+            pBitstream->nalList(RGY_CODEC_HEVC, nal_list);
             const auto hevc_vps_nal = std::find_if(nal_list.begin(), nal_list.end(), [](nal_info info) { return info.type == NALU_HEVC_VPS; });
             const auto hevc_sps_nal = std::find_if(nal_list.begin(), nal_list.end(), [](nal_info info) { return info.type == NALU_HEVC_SPS; });
             const auto hevc_pps_nal = std::find_if(nal_list.begin(), nal_list.end(), [](nal_info info) { return info.type == NALU_HEVC_PPS; });
             const bool header_check = (nal_list.end() != hevc_vps_nal) && (nal_list.end() != hevc_sps_nal) && (nal_list.end() != hevc_pps_nal);
             if (header_check) {
-                nBytesWritten  = _fwrite_nolock(hevc_vps_nal->ptr, 1, hevc_vps_nal->size, m_fDest.get());
-                nBytesWritten += _fwrite_nolock(hevc_sps_nal->ptr, 1, hevc_sps_nal->size, m_fDest.get());
-                nBytesWritten += _fwrite_nolock(hevc_pps_nal->ptr, 1, hevc_pps_nal->size, m_fDest.get());
-                nBytesWritten += _fwrite_nolock(m_seiNal.data(),   1, m_seiNal.size(),    m_fDest.get());
+                m_writeSpans.clear();
+                m_writeSpans.push_back(std::make_pair(hevc_vps_nal->ptr, hevc_vps_nal->size));
+                m_writeSpans.push_back(std::make_pair(hevc_sps_nal->ptr, hevc_sps_nal->size));
+                m_writeSpans.push_back(std::make_pair(hevc_pps_nal->ptr, hevc_pps_nal->size));
+                m_writeSpans.push_back(std::make_pair((const uint8_t *)m_seiNal.data(), m_seiNal.size()));
                 for (const auto& nal : nal_list) {
                     if (nal.type != NALU_HEVC_VPS && nal.type != NALU_HEVC_SPS && nal.type != NALU_HEVC_PPS) {
-                        nBytesWritten += _fwrite_nolock(nal.ptr, 1, nal.size, m_fDest.get());
+                        m_writeSpans.push_back(std::make_pair(nal.ptr, nal.size));
                     }
                 }
+                auto sts = WriteSpans();
+                if (sts != RGY_ERR_NONE) {
+                    return sts;
+                }
             } else {
                 AddMessage(RGY_LOG_ERROR, _T("Unexpected HEVC header.\n"));
                 return RGY_ERR_UNDEFINED_BEHAVIOR;
             }
             m_seiNal.clear();
         } else {
-            nBytesWritten = _fwrite_nolock(pBitstream->data(), 1, pBitstream->size(), m_fDest.get());
-            WRITE_CHECK(nBytesWritten, pBitstream->size());
+            m_writeSpans.clear();
+            m_writeSpans.push_back(std::make_pair((const uint8_t *)pBitstream->data(), (size_t)pBitstream->size()));
+            auto sts = WriteSpans();
+            if (sts != RGY_ERR_NONE) {
+                return sts;
+            }
         }
     }
 
@@ -416,7 +488,7 @@ RGY_ERR RGYOutFrame::WriteNextFrame(RGYFrame *pSurface) {
 
     if (m_sourceHWMem) {
         if (m_readBuffer.get() == nullptr) {
-            m_readBuffer.reset((uint8_t *)_aligned_malloc(pSurface->pitch() + 128, 16));
+            m_readBuffer = RGYHostFramePool::get()->alloc(pSurface->pitch() + 128);
         }
     }
 
@@ -491,7 +563,7 @@ RGY_ERR RGYOutFrame::WriteNextFrame(RGYFrame *pSurface) {
         uint32_t uvHeight = pSurface->height() >> 1;
         uint32_t uvFrameOffset = ALIGN16(uvWidth * uvHeight + 16);
         if (m_UVBuffer.get() == nullptr) {
-            m_UVBuffer.reset((uint8_t *)_aligned_malloc(uvFrameOffset << 1, 32));
+            m_UVBuffer = RGYHostFramePool::get()->alloc(uvFrameOffset << 1);
         }
 
         alignas(16) static const uint16_t MASK_LOW8[] = {
@@ -176,8 +176,8 @@ protected:
     VideoInfo   m_VideoOutputInfo;
     shared_ptr<RGYLog> m_printMes;  //ログ出力
     unique_ptr<char, malloc_deleter>            m_outputBuffer;
-    unique_ptr<uint8_t, aligned_malloc_deleter> m_readBuffer;
-    unique_ptr<uint8_t, aligned_malloc_deleter> m_UVBuffer;
+    shared_ptr<uint8_t>                         m_readBuffer; //RGYHostFramePoolから取得
+    shared_ptr<uint8_t>                         m_UVBuffer;   //RGYHostFramePoolから取得
 };
 
 struct RGYOutputRawPrm {
@@ -198,7 +198,12 @@ public:
 protected:
     virtual RGY_ERR Init(const TCHAR *strFileName, const VideoInfo *pOutputInfo, const void *prm) override;
 
+    //m_writeSpansに登録された領域を順に書き出す
+    RGY_ERR WriteSpans();
+
     vector<uint8_t> m_seiNal;
+    vector<nal_info> m_nalList; //NAL unitの一覧 (フレームごとの確保を避けるため使いまわす)
+    vector<std::pair<const uint8_t *, size_t>> m_writeSpans; //書き出す領域の一覧 (フレームごとの確保を避けるため使いまわす)
 #if ENABLE_AVSW_READER
     unique_ptr<AVBSFContext, RGYAVDeleter<AVBSFContext>> m_pBsfc;
 #endif //#if ENABLE_AVSW_READER
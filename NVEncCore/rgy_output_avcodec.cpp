@@ -175,6 +175,15 @@ void RGYOutputAvcodec::CloseQueues() {
     m_Mux.thread.thAudEncodeAbort = true;
     m_Mux.thread.thAudProcessAbort = true;
     m_Mux.thread.abortOutput = true;
+    auto printBlockedTime = [this](const TCHAR *name, uint64_t count, double time_ms) {
+        if (count > 0) {
+            AddMessage(RGY_LOG_DEBUG, _T("%s: push blocked %llu times, %.1f ms.\n"), name, (unsigned long long)count, time_ms);
+        }
+    };
+    printBlockedTime(_T("video queue"),         m_Mux.thread.qVideobitstream.push_blocked_count(),     m_Mux.thread.qVideobitstream.push_blocked_time_ms());
+    printBlockedTime(_T("audio process queue"), m_Mux.thread.qAudioPacketProcess.push_blocked_count(), m_Mux.thread.qAudioPacketProcess.push_blocked_time_ms());
+    printBlockedTime(_T("audio encode queue"),  m_Mux.thread.qAudioFrameEncode.push_blocked_count(),   m_Mux.thread.qAudioFrameEncode.push_blocked_time_ms());
+    printBlockedTime(_T("audio output queue"),  m_Mux.thread.qAudioPacketOut.push_blocked_count(),     m_Mux.thread.qAudioPacketOut.push_blocked_time_ms());
     m_Mux.thread.qVideobitstream.close();
     m_Mux.thread.qVideobitstreamFreeI.close([](RGYBitstream *pBitstream) { pBitstream->clear(); });
     m_Mux.thread.qVideobitstreamFreePB.close([](RGYBitstream *pBitstream) { pBitstream->clear(); });
@@ -1799,7 +1808,8 @@ RGY_ERR RGYOutputAvcodec::Init(const TCHAR *strFileName, const VideoInfo *videoO
 }
 
 RGY_ERR RGYOutputAvcodec::AddH264HeaderToExtraData(const RGYBitstream *bitstream) {
-    std::vector<nal_info> nal_list = parse_nal_unit_h264(bitstream->data(), bitstream->size());
+    std::vector<nal_info> nal_list;
+    bitstream->nalList(RGY_CODEC_H264, nal_list);
     const auto h264_sps_nal = std::find_if(nal_list.begin(), nal_list.end(), [](nal_info info) { return info.type == NALU_H264_SPS; });
     const auto h264_pps_nal = std::find_if(nal_list.begin(), nal_list.end(), [](nal_info info) { return info.type == NALU_H264_PPS; });
     const bool header_check = (nal_list.end() != h264_sps_nal) && (nal_list.end() != h264_pps_nal);
@@ -1818,7 +1828,8 @@ RGY_ERR RGYOutputAvcodec::AddH264HeaderToExtraData(const RGYBitstream *bitstream
 
 //extradataにHEVCのヘッダーを追加する
 RGY_ERR RGYOutputAvcodec::AddHEVCHeaderToExtraData(const RGYBitstream *bitstream) {
-    std::vector<nal_info> nal_list = parse_nal_unit_hevc(bitstream->data(), bitstream->size());
+    std::vector<nal_info> nal_list;
+    bitstream->nalList(RGY_CODEC_HEVC, nal_list);
     const auto hevc_vps_nal = std::find_if(nal_list.begin(), nal_list.end(), [](nal_info info) { return info.type == NALU_HEVC_VPS; });
     const auto hevc_sps_nal = std::find_if(nal_list.begin(), nal_list.end(), [](nal_info info) { return info.type == NALU_HEVC_SPS; });
     const auto hevc_pps_nal = std::find_if(nal_list.begin(), nal_list.end(), [](nal_info info) { return info.type == NALU_HEVC_PPS; });
@@ -2189,15 +2200,15 @@ RGY_ERR RGYOutputAvcodec::WriteNextFrameInternal(RGYBitstream *bitstream, int64_
     VidCheckStreamAVParser(bitstream);
 #endif //#if ENCODER_VCEENC
 
-    std::vector<nal_info> nal_list;
+    auto& nal_list = m_nalList;
+    nal_list.clear();
     if (m_Mux.video.bsfc) {
         int target_nal = 0;
+        bitstream->nalList(m_VideoOutputInfo.codec, nal_list);
         if (m_VideoOutputInfo.codec == RGY_CODEC_HEVC) {
             target_nal = NALU_HEVC_SPS;
-            nal_list = parse_nal_unit_hevc(bitstream->data(), bitstream->size());
         } else if (m_VideoOutputInfo.codec == RGY_CODEC_H264) {
             target_nal = NALU_H264_SPS;
-            nal_list = parse_nal_unit_h264(bitstream->data(), bitstream->size());
         }
         auto sps_nal = std::find_if(nal_list.begin(), nal_list.end(), [target_nal](nal_info info) { return info.type == target_nal; });
         if (sps_nal != nal_list.end()) {
@@ -2232,6 +2243,7 @@ RGY_ERR RGYOutputAvcodec::WriteNextFrameInternal(RGYBitstream *bitstream, int64_
             }
             memmove(bitstream->data() + next_nal_new_offset, bitstream->data() + next_nal_orig_offset, stream_orig_length - next_nal_orig_offset);
             memcpy(bitstream->data() + sps_nal_offset, pkt.data, pkt.size);
+            bitstream->invalidateNalList();
             av_packet_unref(&pkt);
         }
     }
@@ -2240,9 +2252,8 @@ RGY_ERR RGYOutputAvcodec::WriteNextFrameInternal(RGYBitstream *bitstream, int64_
     bool isIDR = (bitstream->frametype() & (RGY_FRAMETYPE_IDR | RGY_FRAMETYPE_I)) != 0;
     if (m_Mux.video.streamOut->codecpar->field_order != AV_FIELD_PROGRESSIVE) {
         if (m_VideoOutputInfo.codec == RGY_CODEC_H264) {
-            if (nal_list.size() == 0) {
-                nal_list = parse_nal_unit_h264(bitstream->data(), bitstream->size());
-            }
+            //bsfで書き換えていなければ、キャッシュ済みの一覧が返る
+            bitstream->nalList(RGY_CODEC_H264, nal_list);
             //インタレ保持の際、IDRかどうかのフラグが正しく設定されていないことがある
             //どちらかのフィールドがIDRならIDRのフラグを立てる
             isIDR = std::find_if(nal_list.begin(), nal_list.end(), [](nal_info info) { return info.type == NALU_H264_IDR; }) != nal_list.end();
@@ -137,7 +137,14 @@ RGYParamControl::RGYParamControl() :
     perfMonitorSelectMatplot(0),
     perfMonitorInterval(RGY_DEFAULT_PERF_MONITOR_INTERVAL),
     parentProcessID(0),
-    lowLatency(false) {
+    lowLatency(false),
+    hostHugePage(RGY_HOST_HUGEPAGE_AUTO),
+    inputReadMode(RGY_INPUT_READ_AUTO),
+    inputPrefetch(0),
+    avswDecodeQueue(DEFAULT_AVSW_DECODE_QUEUE),
+    avswThreads(0),
+    avswThreadType(RGY_AVSW_THREAD_AUTO),
+    inputIndex(false) {
 
 }
 RGYParamControl::~RGYParamControl() {};
@@ -194,7 +201,7 @@ bool rearrange_trim_list(int frame, int offset, std::vector<sTrim> &trimList) {
     return false;
 }
 
-#if !FOR_AUO && (defined(_WIN32) || defined(_WIN64))
+#if !FOR_AUO
 unique_ptr<RGYHDR10Plus> initDynamicHDR10Plus(const tstring &dynamicHdr10plusJson, shared_ptr<RGYLog> log) {
     unique_ptr<RGYHDR10Plus> hdr10plus;
     if (!PathFileExists(dynamicHdr10plusJson.c_str())) {
@@ -202,14 +209,15 @@ unique_ptr<RGYHDR10Plus> initDynamicHDR10Plus(const tstring &dynamicHdr10plusJso
     } else {
         hdr10plus = std::unique_ptr<RGYHDR10Plus>(new RGYHDR10Plus());
         auto ret = hdr10plus->init(dynamicHdr10plusJson);
-        if (ret == RGY_ERR_NOT_FOUND) {
-            log->write(RGY_LOG_ERROR, _T("Cannot find \"%s\" required for --dhdr10-info.\n"), RGYHDR10Plus::HDR10PLUS_GEN_EXE_NAME);
-            hdr10plus.reset();
-        } else if (ret != RGY_ERR_NONE) {
+        if (ret != RGY_ERR_NONE) {
             log->write(RGY_LOG_ERROR, _T("Failed to initialize hdr10plus reader: %s.\n"), get_err_mes((RGY_ERR)ret));
+            if (hdr10plus->errMes().length() > 0) {
+                log->write(RGY_LOG_ERROR, _T("  %s"), hdr10plus->errMes().c_str());
+            }
             hdr10plus.reset();
+        } else {
+            log->write(RGY_LOG_DEBUG, _T("initialized hdr10plus reader: %s, %d frames.\n"), dynamicHdr10plusJson.c_str(), hdr10plus->frameCount());
         }
-        log->write(RGY_LOG_DEBUG, _T("initialized hdr10plus reader: %s\n"), dynamicHdr10plusJson.c_str());
     }
     return hdr10plus;
 }
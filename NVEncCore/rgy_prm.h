@@ -33,6 +33,7 @@
 #include "rgy_caption.h"
 #include "rgy_simd.h"
 #include "rgy_hdr10plus.h"
+#include "rgy_host_frame_pool.h"
 
 static const int BITSTREAM_BUFFER_SIZE =  4 * 1024 * 1024;
 static const int OUTPUT_BUF_SIZE       = 16 * 1024 * 1024;
@@ -40,6 +41,27 @@ static const int OUTPUT_BUF_SIZE       = 16 * 1024 * 1024;
 static const int RGY_DEFAULT_PERF_MONITOR_INTERVAL = 500;
 static const int DEFAULT_IGNORE_DECODE_ERROR = 10;
 
+//--thread-csp tiled : キャッシュサイズに合わせてバンド分割し、NUMAノードごとに固定したスレッドで色空間変換を行う
+static const int RGY_THREAD_CSP_TILED = -2;
+
+//raw/y4m読み込みでのファイルの読み込み方法
+enum RGYInputReadMode {
+    RGY_INPUT_READ_AUTO,   //通常のファイルならmmap、ブロックデバイスならdirect、それ以外 (パイプ等) はstdio
+    RGY_INPUT_READ_STDIO,  //freadで読み込む
+    RGY_INPUT_READ_MMAP,   //ファイルをメモリにマップし、直接色変換する
+    RGY_INPUT_READ_DIRECT, //キャッシュを経由せず (O_DIRECT)、アラインしたバッファに読み込む
+};
+
+//avswでのlibavcodecのデコーダのスレッド並列の方法
+enum RGYAVSWThreadType {
+    RGY_AVSW_THREAD_AUTO,  //libavcodecの既定 (frame/sliceのうちデコーダの対応するもの)
+    RGY_AVSW_THREAD_FRAME, //フレーム単位で並列化する (スループット優先)
+    RGY_AVSW_THREAD_SLICE, //スライス単位で並列化する (遅延優先)
+};
+
+//avswでデコードスレッドが先行してデコードしておくフレーム数の既定値
+static const int DEFAULT_AVSW_DECODE_QUEUE = 4;
+
 static const char *maxCLLSource = "copy";
 static const char *masterDisplaySource = "copy";
 
@@ -160,6 +182,13 @@ struct RGYParamControl {
     int     perfMonitorInterval;
     uint32_t parentProcessID;
     bool lowLatency;
+    RGYHostHugePage hostHugePage; //ホスト側フレームバッファのhuge pageの使用方法
+    RGYInputReadMode inputReadMode; //raw/y4m読み込みでのファイルの読み込み方法
+    int inputPrefetch; //raw/y4m読み込みで先読みするフレーム数 (0で先読みしない)
+    int avswDecodeQueue; //avswでデコードスレッドが先行してデコードしておくフレーム数 (0でデコードスレッドを使用しない)
+    int avswThreads; //avswでlibavcodecのデコーダが使用するスレッド数 (0で自動)
+    RGYAVSWThreadType avswThreadType; //avswでlibavcodecのデコーダのスレッド並列の方法
+    bool inputIndex; //avhw/avswで入力ファイルのインデックス (キーフレーム位置とフレームレート解析結果) をキャッシュする
 
     RGYParamControl();
     ~RGYParamControl();
@@ -169,6 +198,28 @@ bool trim_active(const sTrimParam *pTrim);
 std::pair<bool, int> frame_inside_range(int frame, const std::vector<sTrim> &trimList);
 bool rearrange_trim_list(int frame, int offset, std::vector<sTrim> &trimList);
 
+const CX_DESC list_host_hugepage[] = {
+    { _T("off"),  RGY_HOST_HUGEPAGE_OFF  },
+    { _T("auto"), RGY_HOST_HUGEPAGE_AUTO },
+    { _T("on"),   RGY_HOST_HUGEPAGE_ON   },
+    { NULL, 0 }
+};
+
+const CX_DESC list_input_read_mode[] = {
+    { _T("auto"),   RGY_INPUT_READ_AUTO   },
+    { _T("stdio"),  RGY_INPUT_READ_STDIO  },
+    { _T("mmap"),   RGY_INPUT_READ_MMAP   },
+    { _T("direct"), RGY_INPUT_READ_DIRECT },
+    { NULL, 0 }
+};
+
+const CX_DESC list_avsw_thread_type[] = {
+    { _T("auto"),  RGY_AVSW_THREAD_AUTO  },
+    { _T("frame"), RGY_AVSW_THREAD_FRAME },
+    { _T("slice"), RGY_AVSW_THREAD_SLICE },
+    { NULL, 0 }
+};
+
 const CX_DESC list_simd[] = {
     { _T("auto"),     -1  },
     { _T("none"),     NONE },
@@ -178,6 +229,7 @@ const CX_DESC list_simd[] = {
     { _T("sse41"),    SSE41|SSSE3|SSE3|SSE2 },
     { _T("avx"),      AVX|SSE42|SSE41|SSSE3|SSE3|SSE2 },
     { _T("avx2"),     AVX2|AVX|SSE42|SSE41|SSSE3|SSE3|SSE2 },
+    { _T("avx512"),   AVX512BW|AVX512VL|AVX512DQ|AVX512F|AVX2|AVX|SSE42|SSE41|SSSE3|SSE3|SSE2 },
     { NULL, 0 }
 };
 
@@ -34,6 +34,10 @@
 #include <atomic>
 #include <climits>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <thread>
 #include "rgy_osdep.h"
 #include "rgy_event.h"
 
@@ -58,7 +62,9 @@ public:
         m_nMallocAlign(32),
         m_nMaxCapacity(SIZE_MAX),
         m_nKeepLength(0),
-        m_pBufStart(), m_pBufFin(nullptr), m_pBufIn(nullptr), m_pBufOut(nullptr), m_bUsingData(false) {
+        m_pBufStart(), m_pBufFin(nullptr), m_pBufIn(nullptr), m_pBufOut(nullptr), m_bUsingData(false),
+        m_nSpinCount(QUEUE_SPIN_MIN),
+        m_nPushBlockedCount(0), m_nPushBlockedTime(0), m_nPopBlockedCount(0), m_nPopBlockedTime(0) {
         static_assert(std::is_pod<Type>::value == true, "RGYQueueSPSP is only for POD type.");
         //実際のメモリのアライメントに適切な2の倍数であるか確認する
         //そうでない場合は32をデフォルトとして使用
@@ -145,9 +151,8 @@ public:
     //キューのデータ量があらかじめ設定した上限に達した場合は、キューに空きができるまで待機する
     bool push(const Type& in) {
         //最初に決めた容量分までキューにデータがたまっていたら、キューに空きができるまで待機する
-        while (size() >= m_nMaxCapacity) {
-            ResetEvent(m_heEventPoped);
-            WaitForSingleObject(m_heEventPoped, 16);
+        if (size() >= m_nMaxCapacity) {
+            waitPoped();
         }
         if (m_pBufIn >= m_pBufFin) {
             //現時点でのm_pBufOut (この後別スレッドによって書き換わるかもしれない)
@@ -216,9 +221,20 @@ public:
     }
     //キューの最大サイズを設定する
     void set_capacity(size_t capacity) {
+        const auto prevCapacity = m_nMaxCapacity;
         m_nMaxCapacity = capacity;
         m_nPushRestartExtra = (std::min)(m_nPushRestartExtra, (int)std::min<size_t>(INT_MAX, m_nMaxCapacity) - 1);
+        //空き待ちしている押し込み側を起床させる
+        if (capacity > prevCapacity && m_heEventPoped) {
+            SetEvent(m_heEventPoped);
+        }
     }
+    //押し込み時に空き待ちで待機した回数と時間(ms)
+    uint64_t push_blocked_count() const { return m_nPushBlockedCount; }
+    double push_blocked_time_ms() const { return m_nPushBlockedTime * 1e-3; }
+    //wait_for_pushで待機した回数と時間(ms)
+    uint64_t pop_blocked_count() const { return m_nPopBlockedCount; }
+    double pop_blocked_time_ms() const { return m_nPopBlockedTime * 1e-3; }
     //indexの位置のコピーを取得する
     bool copy(Type *out, uint32_t index, size_t *pnSize = nullptr) {
         m_bUsingData++;
@@ -229,7 +245,7 @@ public:
         }
         m_bUsingData--;
         if (!bCopy) {
-            ResetEvent(m_heEventPushed);
+            resetPushEvent(nSize);
         }
         if (pnSize) {
             *pnSize = nSize;
@@ -247,7 +263,7 @@ public:
         }
         m_bUsingData--;
         if (!bCopy) {
-            ResetEvent(m_heEventPushed);
+            resetPushEvent(nSize);
         }
         if (pnSize) {
             *pnSize = nSize;
@@ -268,7 +284,7 @@ public:
         }
         m_bUsingData--;
         if (!bCopy) {
-            ResetEvent(m_heEventPushed);
+            resetPushEvent(nSize);
         }
         if (pnSize) {
             *pnSize = nSize;
@@ -289,19 +305,67 @@ public:
         }
         m_bUsingData--;
         if (!bCopy) {
-            ResetEvent(m_heEventPushed);
+            resetPushEvent(nSize);
         }
         return bCopy;
     }
     //要素が追加されるまで待機する
     void wait_for_push() {
-        WaitForSingleObject(m_heEventPushed, 16);
+        const auto start = std::chrono::high_resolution_clock::now();
+        if (WAIT_TIMEOUT != WaitForSingleObject(m_heEventPushed, 0)) {
+            return;
+        }
+        WaitForSingleObject(m_heEventPushed, QUEUE_WAIT_TIMEOUT_MS);
+        m_nPopBlockedCount++;
+        m_nPopBlockedTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
     }
     //要素が追加されるまで待機するイベントを取得
     HANDLE get_push_event() {
         return m_heEventPushed;
     }
 protected:
+    enum {
+        QUEUE_SPIN_MIN = 64,          //空き待ちでスピンする回数の下限
+        QUEUE_SPIN_MAX = 8192,        //空き待ちでスピンする回数の上限
+        QUEUE_WAIT_TIMEOUT_MS = 16,   //通常はイベントで起床するので、これは通知を取りこぼした場合の保険
+    };
+    //取り出しに失敗した際に、追加イベントをリセットする
+    //リセットの直前に押し込み側がセットしていた場合に備え、リセット後にsizeを再確認する
+    void resetPushEvent(size_t nSize) {
+        ResetEvent(m_heEventPushed);
+        if (size() > nSize) {
+            SetEvent(m_heEventPushed);
+        }
+    }
+    //キューに空きができるまで待機する
+    //まずスピンし、それで空きができなければイベントで待機する
+    //スピン中に空きができた場合はスピン回数を増やし、そうでなければ減らす
+    void waitPoped() {
+        const auto start = std::chrono::high_resolution_clock::now();
+        bool spinSucceeded = false;
+        for (int i = 0; i < m_nSpinCount; i++) {
+            _mm_pause();
+            if (size() < m_nMaxCapacity) {
+                spinSucceeded = true;
+                break;
+            }
+        }
+        if (spinSucceeded) {
+            m_nSpinCount = (std::min)(m_nSpinCount * 2, (int)QUEUE_SPIN_MAX);
+        } else {
+            m_nSpinCount = (std::max)(m_nSpinCount / 2, (int)QUEUE_SPIN_MIN);
+            while (size() >= m_nMaxCapacity) {
+                ResetEvent(m_heEventPoped);
+                //リセットの直前に取り出し側がセットしていた場合に備え、リセット後に再確認する
+                if (size() < m_nMaxCapacity) {
+                    break;
+                }
+                WaitForSingleObject(m_heEventPoped, QUEUE_WAIT_TIMEOUT_MS);
+            }
+        }
+        m_nPushBlockedCount++;
+        m_nPushBlockedTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    }
     //bufSize分の内部領域を確保する
     //m_nMaxCapacity以上確保してもかまわない
     //基本的には大きいほうがパフォーマンスは向上する
@@ -324,6 +388,408 @@ protected:
     std::atomic<queueData*> m_pBufIn; //キューにデータを格納する位置へのポインタ
     std::atomic<queueData*> m_pBufOut; //キューから取り出すべき先頭のデータへのポインタ
     std::atomic<int> m_bUsingData; //キューから読み出し中のスレッドの数
+    int m_nSpinCount; //空き待ちでスピンする回数 (押し込み側のみが使用)
+    std::atomic<uint64_t> m_nPushBlockedCount; //押し込み時に空き待ちした回数
+    std::atomic<uint64_t> m_nPushBlockedTime;  //押し込み時に空き待ちした時間 (us)
+    std::atomic<uint64_t> m_nPopBlockedCount;  //wait_for_pushで待機した回数
+    std::atomic<uint64_t> m_nPopBlockedTime;   //wait_for_pushで待機した時間 (us)
+};
+
+//複数の押し込みと複数の取り出しを並列に行うことが可能なキュー
+//各要素にシーケンス番号を持たせたリングバッファで、押し込み/取り出し位置の更新はatomicのみで行う
+//set_capacityでリングの大きさを超える上限が設定された場合は、リングが満杯になった時点で
+//押し込み/取り出しを一時的に止めてリングを拡大する
+//待機はキューが満杯/空になったときのみ行い、相手側は待機中のスレッドがいる場合のみ起床させる
+template<typename Type, size_t align_byte = 64>
+class RGYQueueMPMC {
+    struct queueSlot {
+        std::atomic<size_t> seq; //このスロットに格納/取り出し可能になる位置
+        Type data;
+    };
+    union queueData {
+        queueSlot slot;
+        char pad[((sizeof(queueSlot) + (align_byte-1)) & (~(align_byte-1)))];
+    };
+public:
+    RGYQueueMPMC() :
+        m_pBuf(),
+        m_nBufMask(0),
+        m_nMaxCapacity(0),
+        m_nKeepLength(0),
+        m_nPushRestartExtra(0),
+        m_nEnqueuePos(0),
+        m_nDequeuePos(0),
+        m_nActive(0),
+        m_bResizing(false),
+        m_bClosed(false),
+        m_nWaitingPush(0),
+        m_nWaitingPop(0),
+        m_nPushBlockedCount(0), m_nPushBlockedTime(0), m_nPopBlockedCount(0), m_nPopBlockedTime(0),
+        m_mtx(),
+        m_cvPushed(),
+        m_cvPoped() {
+        static_assert(std::is_pod<Type>::value == true, "RGYQueueMPMC is only for POD type.");
+        static_assert((align_byte & (align_byte - 1)) == 0, "align_byte must be power of 2.");
+    }
+    ~RGYQueueMPMC() {
+        close();
+    }
+    //キューが一定の長さに達しないとfront_copy/popできないように設定する
+    void set_keep_length(size_t keepLength) {
+        m_nKeepLength = keepLength;
+    }
+    size_t get_keep_length() {
+        return m_nKeepLength;
+    }
+    //キューを初期化する
+    //bufSizeはリングバッファの初期の大きさ (2の累乗に切り上げる)、maxCapacityのほうが大きければmaxCapacityに合わせる
+    //maxCapacityはキューに格納できる最大のデータ数 (set_capacityで変更可能)
+    void init(size_t bufSize = 1024, size_t maxCapacity = SIZE_MAX, int nPushRestart = 1) {
+        close();
+        size_t ringSize = 2;
+        const size_t requiredSize = (maxCapacity != SIZE_MAX) ? (std::max)(bufSize, maxCapacity) : bufSize;
+        while (ringSize < requiredSize) {
+            ringSize <<= 1;
+        }
+        m_pBuf = std::unique_ptr<queueData, aligned_malloc_deleter>(
+            (queueData *)_aligned_malloc(sizeof(queueData) * ringSize, (std::max<size_t>)(16, align_byte)), aligned_malloc_deleter());
+        m_nBufMask = ringSize - 1;
+        for (size_t i = 0; i < ringSize; i++) {
+            new (&m_pBuf.get()[i].slot.seq) std::atomic<size_t>(i);
+        }
+        m_nEnqueuePos = 0;
+        m_nDequeuePos = 0;
+        m_nMaxCapacity = (std::min)(maxCapacity, ringSize);
+        m_nKeepLength = 0;
+        m_bClosed = false;
+        m_nPushRestartExtra = clamp(nPushRestart - 1, 0, (int)std::min<size_t>(INT_MAX, m_nMaxCapacity) - 4);
+    }
+    //キューのデータをクリアする
+    // !! ほかのスレッドが押し込み/取り出しを行っていないときのみ有効 !!
+    void clear() {
+        if (!m_pBuf) return;
+        for (size_t i = 0; i <= m_nBufMask; i++) {
+            m_pBuf.get()[i].slot.seq.store(i);
+        }
+        m_nEnqueuePos = 0;
+        m_nDequeuePos = 0;
+    }
+    //キューのデータをクリアする際に、指定した関数で内部データを開放してから、データをクリアする
+    template<typename Func>
+    void clear(Func deleter) {
+        if (!m_pBuf) return;
+        Type data;
+        const auto keepLength = m_nKeepLength;
+        m_nKeepLength = 0;
+        while (front_copy_and_pop_no_lock(&data)) {
+            deleter(&data);
+        }
+        m_nKeepLength = keepLength;
+        clear();
+    }
+    //キューのデータをクリアし、リソースを破棄する
+    //以降のpushはfalseを返し、空き待ちしているpushも起床してfalseを返す
+    void close() {
+        m_bClosed = true;
+        {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            m_cvPoped.notify_all();
+            m_cvPushed.notify_all();
+        }
+        //拡大中のスレッドやバッファにアクセス中のスレッドがいなくなってから破棄する
+        for (bool expected = false; !m_bResizing.compare_exchange_weak(expected, true); expected = false) {
+            std::this_thread::yield();
+        }
+        while (m_nActive.load() > 0) {
+            std::this_thread::yield();
+        }
+        m_pBuf.reset();
+        m_nBufMask = 0;
+        m_nMaxCapacity = 0;
+        m_nEnqueuePos = 0;
+        m_nDequeuePos = 0;
+        m_bResizing = false;
+    }
+    //キューのデータをクリアする際に、指定した関数で内部データを開放してから、リソースを破棄する
+    template<typename Func>
+    void close(Func deleter) {
+        clear(deleter);
+        close();
+    }
+    //データをキューにコピーし押し込む
+    //キューのデータ量があらかじめ設定した上限に達した場合は、キューに空きができるまで待機する
+    //close済みの場合はfalseを返す
+    bool push(const Type& in) {
+        for (int spin = 0;;) {
+            if (m_bClosed) {
+                return false;
+            }
+            if (size() >= m_nMaxCapacity) {
+                //上限に達していたら、少しスピンしてから空きができるまで待機する
+                const auto start = std::chrono::high_resolution_clock::now();
+                while (size() >= m_nMaxCapacity && !m_bClosed) {
+                    if (spin++ < QUEUE_SPIN_COUNT) {
+                        _mm_pause();
+                    } else {
+                        waitPoped();
+                        spin = 0;
+                    }
+                }
+                m_nPushBlockedCount++;
+                m_nPushBlockedTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+                continue;
+            }
+            if (!enterBuf()) {
+                return false;
+            }
+            if (!m_pBuf) {
+                leaveBuf();
+                return false;
+            }
+            queueSlot *slot = nullptr;
+            size_t pos = m_nEnqueuePos.load(std::memory_order_relaxed);
+            bool ringFull = false;
+            for (;;) {
+                slot = &m_pBuf.get()[pos & m_nBufMask].slot;
+                const size_t seq = slot->seq.load(std::memory_order_acquire);
+                const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+                if (diff == 0) {
+                    if (m_nEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        break;
+                    }
+                } else if (diff < 0) {
+                    //リングバッファが満杯 (取り出し中のスロットがある)
+                    ringFull = true;
+                    break;
+                } else {
+                    pos = m_nEnqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+            if (ringFull) {
+                //上限がリングの大きさを超えていれば、リングを拡大する
+                const bool canGrow = m_nMaxCapacity > m_nBufMask + 1;
+                leaveBuf();
+                if (canGrow) {
+                    grow();
+                } else {
+                    _mm_pause();
+                }
+                continue;
+            }
+            memcpy(&slot->data, &in, sizeof(Type));
+            slot->seq.store(pos + 1, std::memory_order_release);
+            leaveBuf();
+            break;
+        }
+        //取り出し側が待機している場合のみ起床させる
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_nWaitingPop.load() > 0) {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            m_cvPushed.notify_all();
+        }
+        return true;
+    }
+    //キューのsizeを取得する
+    size_t size() const {
+        const size_t dequeuePos = m_nDequeuePos.load();
+        const size_t enqueuePos = m_nEnqueuePos.load();
+        return (enqueuePos > dequeuePos) ? enqueuePos - dequeuePos : 0;
+    }
+    //キューが空ならtrueを返す
+    bool empty() const {
+        return size() == 0;
+    }
+    //キューの最大サイズを取得する
+    size_t capacity() const {
+        return m_nMaxCapacity;
+    }
+    //キューの最大サイズを設定する (リングバッファの大きさを超える場合は、満杯になった時点でリングを拡大する)
+    void set_capacity(size_t capacity) {
+        if (m_bClosed) {
+            return;
+        }
+        const size_t prevCapacity = m_nMaxCapacity;
+        m_nMaxCapacity = capacity;
+        m_nPushRestartExtra = (std::min)(m_nPushRestartExtra.load(), (int)std::min<size_t>(INT_MAX, m_nMaxCapacity) - 1);
+        if (m_nMaxCapacity > prevCapacity && m_nWaitingPush.load() > 0) {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            m_cvPoped.notify_all();
+        }
+    }
+    //押し込み時に空き待ちで待機した回数と時間(ms)
+    uint64_t push_blocked_count() const { return m_nPushBlockedCount; }
+    double push_blocked_time_ms() const { return m_nPushBlockedTime * 1e-3; }
+    //wait_for_pushで待機した回数と時間(ms)
+    uint64_t pop_blocked_count() const { return m_nPopBlockedCount; }
+    double pop_blocked_time_ms() const { return m_nPopBlockedTime * 1e-3; }
+    //キューの先頭のデータを取り出しながら(outにコピーする)、キューから取り除く
+    //キューが空ならなにもせずfalseを返す
+    bool front_copy_and_pop_no_lock(Type *out, size_t *pnSize = nullptr) {
+        return popData(out, pnSize);
+    }
+    //キューの先頭のデータを取り除く
+    //キューが空ならfalseを返す
+    bool pop() {
+        return popData(nullptr, nullptr);
+    }
+    //要素が追加されるまで待機する
+    void wait_for_push(uint32_t millisec = 16) {
+        if (!empty()) return;
+        const auto start = std::chrono::high_resolution_clock::now();
+        {
+            std::unique_lock<std::mutex> lock(m_mtx);
+            m_nWaitingPop++;
+            m_cvPushed.wait_for(lock, std::chrono::milliseconds(millisec), [this]() { return !empty(); });
+            m_nWaitingPop--;
+        }
+        m_nPopBlockedCount++;
+        m_nPopBlockedTime += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+protected:
+    //待機状態に入るまでのスピン回数
+    static const int QUEUE_SPIN_COUNT = 256;
+
+    bool popData(Type *out, size_t *pnSize) {
+        if (!enterBuf()) {
+            if (pnSize) *pnSize = 0;
+            return false;
+        }
+        if (!m_pBuf) {
+            leaveBuf();
+            if (pnSize) *pnSize = 0;
+            return false;
+        }
+        size_t nSize = 0;
+        queueSlot *slot = nullptr;
+        size_t pos = m_nDequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            nSize = size();
+            if (nSize <= m_nKeepLength) {
+                leaveBuf();
+                if (pnSize) *pnSize = nSize;
+                return false;
+            }
+            slot = &m_pBuf.get()[pos & m_nBufMask].slot;
+            const size_t seq = slot->seq.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (m_nDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                //押し込み途中のスロット、あるいはキューが空
+                leaveBuf();
+                if (pnSize) *pnSize = nSize;
+                return false;
+            } else {
+                pos = m_nDequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        if (out) {
+            memcpy(out, &slot->data, sizeof(Type));
+        }
+        slot->seq.store(pos + m_nBufMask + 1, std::memory_order_release);
+        leaveBuf();
+        //押し込み側が待機しており、十分な空きができた場合のみ起床させる
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_nWaitingPush.load() > 0 && nSize <= m_nMaxCapacity - m_nPushRestartExtra) {
+            std::lock_guard<std::mutex> lock(m_mtx);
+            m_cvPoped.notify_all();
+        }
+        if (pnSize) {
+            *pnSize = nSize;
+        }
+        return true;
+    }
+    //キューに空きができるまで待機する
+    void waitPoped() {
+        std::unique_lock<std::mutex> lock(m_mtx);
+        m_nWaitingPush++;
+        //通知の取りこぼしに備え、一定時間ごとに再確認する
+        m_cvPoped.wait_for(lock, std::chrono::milliseconds(16), [this]() { return size() < m_nMaxCapacity || m_bClosed; });
+        m_nWaitingPush--;
+    }
+    //リングバッファへのアクセスを開始する (拡大中なら終わるまで待つ)
+    //close済みならfalseを返す
+    bool enterBuf() {
+        for (;;) {
+            m_nActive++;
+            if (!m_bResizing) {
+                if (m_bClosed) {
+                    m_nActive--;
+                    return false;
+                }
+                return true;
+            }
+            m_nActive--;
+            while (m_bResizing) {
+                _mm_pause();
+            }
+        }
+    }
+    void leaveBuf() {
+        m_nActive--;
+    }
+    //リングバッファを2倍に拡大する
+    //ほかのスレッドのアクセスが終わるのを待ってから、格納済みのデータを先頭から詰めなおす
+    void grow() {
+        bool expected = false;
+        if (!m_bResizing.compare_exchange_strong(expected, true)) {
+            //ほかのスレッドが拡大中
+            while (m_bResizing) {
+                _mm_pause();
+            }
+            return;
+        }
+        while (m_nActive.load() > 0) {
+            _mm_pause();
+        }
+        const size_t ringSize = m_nBufMask + 1;
+        const size_t dequeuePos = m_nDequeuePos.load();
+        const size_t nSize = size();
+        //待っている間に取り出されていれば、拡大は不要
+        if (!m_bClosed && nSize >= ringSize && m_nMaxCapacity > ringSize) {
+            const size_t newRingSize = ringSize << 1;
+            std::unique_ptr<queueData, aligned_malloc_deleter> newBuf(
+                (queueData *)_aligned_malloc(sizeof(queueData) * newRingSize, (std::max<size_t>)(16, align_byte)), aligned_malloc_deleter());
+            if (newBuf) {
+                for (size_t i = 0; i < newRingSize; i++) {
+                    if (i < nSize) {
+                        memcpy(&newBuf.get()[i].slot.data, &m_pBuf.get()[(dequeuePos + i) & m_nBufMask].slot.data, sizeof(Type));
+                        new (&newBuf.get()[i].slot.seq) std::atomic<size_t>(i + 1);
+                    } else {
+                        new (&newBuf.get()[i].slot.seq) std::atomic<size_t>(i);
+                    }
+                }
+                m_pBuf = std::move(newBuf);
+                m_nBufMask = newRingSize - 1;
+                //size()が一時的に大きな値とならないよう、押し込み位置を先に更新する
+                m_nEnqueuePos = nSize;
+                m_nDequeuePos = 0;
+            }
+        }
+        m_bResizing = false;
+    }
+
+    std::unique_ptr<queueData, aligned_malloc_deleter> m_pBuf; //リングバッファ
+    size_t m_nBufMask; //リングバッファの大きさ - 1
+    std::atomic<size_t> m_nMaxCapacity; //キューに詰められる有効なデータの最大数
+    size_t m_nKeepLength; //ある一定の長さを常にキュー内に保持するようにする
+    std::atomic<int> m_nPushRestartExtra; //キューに空きがこのぶんだけ余剰にないと空き通知を行わない (0 = ひとつあけば通知を行う)
+    alignas(64) std::atomic<size_t> m_nEnqueuePos; //次に押し込む位置
+    alignas(64) std::atomic<size_t> m_nDequeuePos; //次に取り出す位置
+    alignas(64) std::atomic<int> m_nActive; //リングバッファにアクセス中のスレッド数
+    std::atomic<bool> m_bResizing; //リングバッファの拡大中 (またはclose中)
+    std::atomic<bool> m_bClosed; //close済み
+    alignas(64) std::atomic<int> m_nWaitingPush; //空き待ちで待機中のスレッド数
+    std::atomic<int> m_nWaitingPop; //データ待ちで待機中のスレッド数
+    std::atomic<uint64_t> m_nPushBlockedCount; //押し込み時に空き待ちした回数
+    std::atomic<uint64_t> m_nPushBlockedTime;  //押し込み時に空き待ちした時間 (us)
+    std::atomic<uint64_t> m_nPopBlockedCount;  //wait_for_pushで待機した回数
+    std::atomic<uint64_t> m_nPopBlockedTime;   //wait_for_pushで待機した時間 (us)
+    std::mutex m_mtx;
+    std::condition_variable m_cvPushed; //データが追加されたときに通知する
+    std::condition_variable m_cvPoped;  //データが取り出されたときに通知する
 };
 
 #endif //__RGY_QUEUE_H__
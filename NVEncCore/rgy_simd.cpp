@@ -55,5 +55,14 @@ unsigned int get_availableSIMD() {
     __cpuid(CPUInfo, 7);
     if ((simd & AVX) && (CPUInfo[1] & 0x00000020))
         simd |= AVX2;
+    //opmask, zmm0-15上位, zmm16-31 の状態保存がOSで有効になっているか
+    if ((simd & AVX) && ((xgetbv >> 5) & 0x07) == 0x07) {
+        if (CPUInfo[1] & 0x00010000) simd |= AVX512F;
+        if (simd & AVX512F) {
+            if (CPUInfo[1] & 0x00020000) simd |= AVX512DQ;
+            if (CPUInfo[1] & 0x40000000) simd |= AVX512BW;
+            if (CPUInfo[1] & 0x80000000) simd |= AVX512VL;
+        }
+    }
     return simd;
 }
@@ -0,0 +1,172 @@
+﻿// -----------------------------------------------------------------------------------------
+// QSVEnc/NVEnc by rigaya
+// -----------------------------------------------------------------------------------------
+// The MIT License
+//
+// Copyright (c) 2011-2016 rigaya
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// --------------------------------------------------------------------------------------------
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#include "rgy_osdep.h"
+#include "rgy_slab_alloc.h"
+#if !(defined(_WIN32) || defined(_WIN64))
+#include <sys/mman.h>
+#endif
+
+static const int    RGY_SLAB_MIN_CLASS_SHIFT = 12; //4KB
+static const int    RGY_SLAB_MAX_CLASS_SHIFT = 26; //64MB
+static const int    RGY_SLAB_CLASS_NUM = RGY_SLAB_MAX_CLASS_SHIFT - RGY_SLAB_MIN_CLASS_SHIFT + 1;
+static const size_t RGY_SLAB_HUGE_PAGE_SIZE = (size_t)2 << 20;
+static const size_t RGY_SLAB_ALIGN = 64;
+static const size_t RGY_SLAB_LOCAL_CACHE_BYTES = (size_t)16 << 20;  //スレッドローカルのキャッシュのクラスごとの上限
+static const size_t RGY_SLAB_GLOBAL_CACHE_BYTES = (size_t)64 << 20; //共有キャッシュのクラスごとの上限
+static const int    RGY_SLAB_LOCAL_CACHE_MAX = 16; //スレッドローカルのキャッシュのクラスごとの最大個数
+
+static std::atomic<uint64_t> g_slabAllocCount(0);
+static std::atomic<uint64_t> g_slabReuseCount(0);
+static std::atomic<uint64_t> g_slabSysAllocCount(0);
+static std::atomic<uint64_t> g_slabSysAllocBytes(0);
+
+static inline size_t slab_class_size(int cls) {
+    return (size_t)1 << (cls + RGY_SLAB_MIN_CLASS_SHIFT);
+}
+
+//クラスごとにキャッシュできる個数
+static inline int slab_class_cache_max(int cls, size_t cache_bytes, int cache_max) {
+    return (int)std::max<size_t>(1, std::min<size_t>(cache_max, cache_bytes / slab_class_size(cls)));
+}
+
+static void *slab_sys_alloc(size_t size) {
+    const bool huge = size >= RGY_SLAB_HUGE_PAGE_SIZE;
+    void *ptr = _aligned_malloc(size, (huge) ? RGY_SLAB_HUGE_PAGE_SIZE : RGY_SLAB_ALIGN);
+#if !(defined(_WIN32) || defined(_WIN64)) && defined(MADV_HUGEPAGE)
+    if (ptr && huge) {
+        madvise(ptr, size, MADV_HUGEPAGE);
+    }
+#endif
+    if (ptr) {
+        g_slabSysAllocCount++;
+        g_slabSysAllocBytes += size;
+    }
+    return ptr;
+}
+
+//全スレッドで共有するキャッシュ
+struct RGYSlabGlobalCache {
+    std::mutex mtx;
+    std::vector<void *> blocks;
+};
+static RGYSlabGlobalCache g_slabGlobalCache[RGY_SLAB_CLASS_NUM];
+
+//スレッドローカルのキャッシュ
+//いっぱいになったら半分を共有キャッシュに戻し、空になったら共有キャッシュからまとめて取得する
+struct RGYSlabLocalCache {
+    void *blocks[RGY_SLAB_CLASS_NUM][RGY_SLAB_LOCAL_CACHE_MAX];
+    int count[RGY_SLAB_CLASS_NUM];
+
+    RGYSlabLocalCache() : blocks(), count() {};
+    ~RGYSlabLocalCache() {
+        //スレッド終了時には、すべて共有キャッシュに戻す
+        for (int cls = 0; cls < RGY_SLAB_CLASS_NUM; cls++) {
+            flush(cls, count[cls]);
+        }
+    }
+    //n個を共有キャッシュに戻す (共有キャッシュがいっぱいなら解放する)
+    void flush(int cls, int n) {
+        if (n <= 0) return;
+        auto& global = g_slabGlobalCache[cls];
+        const int global_max = slab_class_cache_max(cls, RGY_SLAB_GLOBAL_CACHE_BYTES, INT32_MAX);
+        std::lock_guard<std::mutex> lock(global.mtx);
+        for (int i = 0; i < n; i++) {
+            void *ptr = blocks[cls][--count[cls]];
+            if ((int)global.blocks.size() < global_max) {
+                global.blocks.push_back(ptr);
+            } else {
+                _aligned_free(ptr);
+            }
+        }
+    }
+    //共有キャッシュから最大n個を取得する
+    void refill(int cls, int n) {
+        auto& global = g_slabGlobalCache[cls];
+        std::lock_guard<std::mutex> lock(global.mtx);
+        while (n-- > 0 && !global.blocks.empty()) {
+            blocks[cls][count[cls]++] = global.blocks.back();
+            global.blocks.pop_back();
+        }
+    }
+};
+static thread_local RGYSlabLocalCache g_slabLocalCache;
+
+void *rgy_slab_alloc(size_t size, size_t *allocated_size) {
+    g_slabAllocCount++;
+    if (size > slab_class_size(RGY_SLAB_CLASS_NUM - 1)) {
+        *allocated_size = size;
+        return slab_sys_alloc(size);
+    }
+    int cls = 0;
+    while (slab_class_size(cls) < size) {
+        cls++;
+    }
+    *allocated_size = slab_class_size(cls);
+    auto& local = g_slabLocalCache;
+    if (local.count[cls] == 0) {
+        local.refill(cls, (slab_class_cache_max(cls, RGY_SLAB_LOCAL_CACHE_BYTES, RGY_SLAB_LOCAL_CACHE_MAX) + 1) / 2);
+    }
+    if (local.count[cls] > 0) {
+        g_slabReuseCount++;
+        return local.blocks[cls][--local.count[cls]];
+    }
+    return slab_sys_alloc(slab_class_size(cls));
+}
+
+void rgy_slab_free(void *ptr, size_t allocated_size) {
+    if (ptr == nullptr) {
+        return;
+    }
+    if (allocated_size > slab_class_size(RGY_SLAB_CLASS_NUM - 1)) {
+        _aligned_free(ptr);
+        return;
+    }
+    int cls = 0;
+    while (slab_class_size(cls) < allocated_size) {
+        cls++;
+    }
+    auto& local = g_slabLocalCache;
+    const int local_max = slab_class_cache_max(cls, RGY_SLAB_LOCAL_CACHE_BYTES, RGY_SLAB_LOCAL_CACHE_MAX);
+    if (local.count[cls] >= local_max) {
+        local.flush(cls, (local_max + 1) / 2);
+    }
+    local.blocks[cls][local.count[cls]++] = ptr;
+}
+
+RGYSlabAllocStats rgy_slab_alloc_stats() {
+    RGYSlabAllocStats stats;
+    stats.alloc_count     = g_slabAllocCount.load();
+    stats.reuse_count     = g_slabReuseCount.load();
+    stats.sys_alloc_count = g_slabSysAllocCount.load();
+    stats.sys_alloc_bytes = g_slabSysAllocBytes.load();
+    return stats;
+}
@@ -0,0 +1,59 @@
+﻿// -----------------------------------------------------------------------------------------
+// QSVEnc/NVEnc by rigaya
+// -----------------------------------------------------------------------------------------
+// The MIT License
+//
+// Copyright (c) 2011-2016 rigaya
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// --------------------------------------------------------------------------------------------
+
+#pragma once
+#ifndef __RGY_SLAB_ALLOC_H__
+#define __RGY_SLAB_ALLOC_H__
+
+#include <cstdint>
+#include <cstddef>
+
+//RGYBitstreamなどのバッファ用の、サイズクラス別のスラブアロケータ
+//要求サイズを2の累乗のサイズクラスに切り上げ、解放されたバッファはクラスごとにキャッシュして再利用する
+//P/Bフレームは小さいクラス、Iフレームは大きいクラスに自然に分かれるので、互いのバッファを奪い合うことはない
+//キャッシュはスレッドローカルのものと全体で共有するものの2段で、スレッドローカルのキャッシュはロックなしで使用できる
+//大きいクラス(2MB以上)は、可能であればhuge pageで確保する
+//最大のサイズクラスを超える要求は、キャッシュせずに直接確保・解放する
+
+struct RGYSlabAllocStats {
+    uint64_t alloc_count;     //確保要求の回数
+    uint64_t reuse_count;     //キャッシュから再利用した回数 (システムからの確保を回避できた回数)
+    uint64_t sys_alloc_count; //システムから確保した回数
+    uint64_t sys_alloc_bytes; //システムから確保したバイト数
+};
+
+//sizeバイト以上のバッファを確保する (64byteアライン)
+//allocated_sizeには実際に確保されたサイズが返り、解放時にはこの値を渡す必要がある
+void *rgy_slab_alloc(size_t size, size_t *allocated_size);
+
+//rgy_slab_allocで確保したバッファを解放する
+void rgy_slab_free(void *ptr, size_t allocated_size);
+
+//プロセス全体での統計を取得する
+RGYSlabAllocStats rgy_slab_alloc_stats();
+
+#endif //__RGY_SLAB_ALLOC_H__
@@ -62,6 +62,7 @@ typedef char TCHAR;
 #define _tcserror strerror
 #define _fgetts fgets
 #define _tcscpy strcpy
+#define _tremove remove
 
 #define _SH_DENYRW      0x10    // deny read/write mode
 #define _SH_DENYWR      0x20    // deny write mode
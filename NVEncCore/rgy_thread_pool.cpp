@@ -0,0 +1,314 @@
+﻿// -----------------------------------------------------------------------------------------
+// QSVEnc/NVEnc by rigaya
+// -----------------------------------------------------------------------------------------
+// The MIT License
+//
+// Copyright (c) 2011-2016 rigaya
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// --------------------------------------------------------------------------------------------
+
+#include <algorithm>
+#include "rgy_thread_pool.h"
+#include "rgy_thread.h"
+#include "cpu_info.h"
+#if defined(_WIN32) || defined(_WIN64)
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+//ジョブがなくなってから待機状態に入るまでのスピン回数
+static const int RGY_THREAD_POOL_SPIN_COUNT = 2048;
+
+static void set_thread_affinity(uint32_t processor_id) {
+#if defined(_WIN32) || defined(_WIN64)
+    SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << processor_id);
+#else
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(processor_id, &cpuset);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+#endif
+}
+
+static int get_current_processor() {
+#if defined(_WIN32) || defined(_WIN64)
+    return (int)GetCurrentProcessorNumber();
+#else
+    return sched_getcpu();
+#endif
+}
+
+static inline uint64_t range_pack(uint32_t begin, uint32_t end) {
+    return ((uint64_t)end << 32) | (uint64_t)begin;
+}
+static inline uint32_t range_begin(uint64_t range) {
+    return (uint32_t)(range & 0xffffffffu);
+}
+static inline uint32_t range_end(uint64_t range) {
+    return (uint32_t)(range >> 32);
+}
+
+RGYThreadPool::Job::Job() :
+    state(JOB_FREE),
+    refs(0),
+    participants(0),
+    remaining(0),
+    max_parallel(0),
+    node(-1),
+    func(nullptr),
+    ranges() {
+    for (auto& range : ranges) {
+        range.store(0);
+    }
+}
+
+RGYThreadPool::RGYThreadPool(int workers) :
+    m_workers(),
+    m_processors(),
+    m_workerProcessor(),
+    m_nodeWorkers(),
+    m_affinity(false),
+    m_jobs(),
+    m_jobSeq(0),
+    m_sleeping(0),
+    m_abort(false),
+    m_mtx(),
+    m_cv() {
+    workers = std::min(std::max(workers, 0), RGY_THREAD_POOL_MAX_PARALLEL - 1);
+
+    //同じNUMAノードのワーカーが連続し、物理コアに1スレッドずつ先に割り当てられるよう並べ替える
+    cpu_logical_processor_t processors[256];
+    const int processor_count = get_cpu_logical_processors(processors, (int)_countof(processors));
+    m_processors.assign(processors, processors + processor_count);
+    std::stable_sort(m_processors.begin(), m_processors.end(), [](const cpu_logical_processor_t& a, const cpu_logical_processor_t& b) {
+        if (a.node != b.node) return a.node < b.node;
+        if (a.smt != b.smt) return a.smt < b.smt;
+        return a.core < b.core;
+    });
+    for (int i = 0; i < workers; i++) {
+        //先頭の論理プロセッサは呼び出し元のスレッドのために空けておく
+        const int idx = (m_processors.size() > 0) ? (i + 1) % (int)m_processors.size() : -1;
+        m_workerProcessor.push_back(idx);
+        if (idx >= 0) {
+            const int node = (int)m_processors[idx].node;
+            if ((int)m_nodeWorkers.size() <= node) {
+                m_nodeWorkers.resize(node + 1, 0);
+            }
+            m_nodeWorkers[node]++;
+        }
+    }
+    for (int i = 0; i < workers; i++) {
+        m_workers.push_back(std::thread(&RGYThreadPool::workerFunc, this, i));
+    }
+}
+
+RGYThreadPool::~RGYThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_abort = true;
+    }
+    m_cv.notify_all();
+    for (auto& th : m_workers) {
+        if (th.joinable()) {
+            th.join();
+        }
+    }
+    m_workers.clear();
+}
+
+RGYThreadPool *RGYThreadPool::get() {
+    //終了時にワーカーの終了待ちを行うと、dll(auo)のアンロード時にデッドロックする可能性があるので、
+    //あえて破棄せず、プロセスの終了とともに破棄させる
+    static RGYThreadPool *pool = new RGYThreadPool((int)get_cpu_info().logical_cores - 1);
+    return pool;
+}
+
+void RGYThreadPool::enableAffinity() {
+    m_affinity = true;
+    if (m_sleeping.load() > 0) {
+        //待機中のワーカーを起床させ、固定を反映させる
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_jobSeq.fetch_add(1);
+        m_cv.notify_all();
+    }
+}
+
+int RGYThreadPool::currentNode() const {
+    const int processor = get_current_processor();
+    for (const auto& p : m_processors) {
+        if ((int)p.id == processor) {
+            return (int)p.node;
+        }
+    }
+    return -1;
+}
+
+bool RGYThreadPool::runOwn(Job *job, int idx) {
+    bool worked = false;
+    auto& range = job->ranges[idx];
+    uint64_t current = range.load();
+    for (;;) {
+        const auto begin = range_begin(current);
+        const auto end = range_end(current);
+        if (begin >= end) {
+            break;
+        }
+        //自分の範囲は先頭から取り出す
+        if (range.compare_exchange_weak(current, range_pack(begin + 1, end))) {
+            (*job->func)((int)begin);
+            job->remaining.fetch_sub(1);
+            worked = true;
+            current = range.load();
+        }
+    }
+    return worked;
+}
+
+bool RGYThreadPool::runSteal(Job *job, int idx) {
+    bool worked = false;
+    for (int i = 1; i < job->max_parallel; i++) {
+        auto& range = job->ranges[(idx + i) % job->max_parallel];
+        uint64_t current = range.load();
+        for (;;) {
+            const auto begin = range_begin(current);
+            const auto end = range_end(current);
+            if (begin >= end) {
+                break;
+            }
+            //ほかのスレッドの範囲は末尾から奪う
+            if (range.compare_exchange_weak(current, range_pack(begin, end - 1))) {
+                (*job->func)((int)(end - 1));
+                job->remaining.fetch_sub(1);
+                worked = true;
+                current = range.load();
+            }
+        }
+    }
+    return worked;
+}
+
+bool RGYThreadPool::participate(Job *job, int idx) {
+    bool worked = runOwn(job, idx);
+    worked |= runSteal(job, idx);
+    return worked;
+}
+
+void RGYThreadPool::workerFunc(int worker_id) {
+    const int processor_idx = m_workerProcessor[worker_id];
+    const int node = (processor_idx >= 0) ? (int)m_processors[processor_idx].node : -1;
+    bool pinned = false;
+    int spin = 0;
+    while (!m_abort) {
+        if (!pinned && m_affinity && processor_idx >= 0) {
+            set_thread_affinity(m_processors[processor_idx].id);
+            pinned = true;
+        }
+        const uint32_t seq = m_jobSeq.load();
+        bool worked = false;
+        for (auto& job : m_jobs) {
+            if (job.state.load() != JOB_ACTIVE) {
+                continue;
+            }
+            //refsを増やしてから再度状態を確認することで、処理中にジョブが解放されないようにする
+            job.refs.fetch_add(1);
+            if (job.state.load() == JOB_ACTIVE && job.remaining.load() > 0
+                && (job.node < 0 || job.node == node)) {
+                const int idx = job.participants.fetch_add(1);
+                if (idx < job.max_parallel) {
+                    worked |= participate(&job, idx);
+                }
+            }
+            job.refs.fetch_sub(1);
+        }
+        if (worked) {
+            spin = 0;
+        } else if (spin < RGY_THREAD_POOL_SPIN_COUNT) {
+            _mm_pause();
+            spin++;
+        } else {
+            //新しいジョブが投入されるまで待機
+            std::unique_lock<std::mutex> lock(m_mtx);
+            m_sleeping.fetch_add(1);
+            m_cv.wait(lock, [&]() { return m_abort || m_jobSeq.load() != seq; });
+            m_sleeping.fetch_sub(1);
+            spin = 0;
+        }
+    }
+}
+
+void RGYThreadPool::parallel_for(int task_n, int max_parallel, const std::function<void(int task_id)>& func, bool numa_local) {
+    int node = -1;
+    if (numa_local && m_affinity && m_nodeWorkers.size() > 1) {
+        node = currentNode();
+        if (node >= 0) {
+            max_parallel = std::min(max_parallel, ((node < (int)m_nodeWorkers.size()) ? m_nodeWorkers[node] : 0) + 1);
+        }
+    }
+    max_parallel = std::min(std::min(max_parallel, task_n), threadCount());
+    if (max_parallel <= 1) {
+        for (int i = 0; i < task_n; i++) {
+            func(i);
+        }
+        return;
+    }
+    Job *job = nullptr;
+    for (auto& j : m_jobs) {
+        int expected = JOB_FREE;
+        if (j.state.compare_exchange_strong(expected, JOB_RESERVED)) {
+            job = &j;
+            break;
+        }
+    }
+    if (job == nullptr) {
+        //空きがなければ自スレッドで処理する
+        for (int i = 0; i < task_n; i++) {
+            func(i);
+        }
+        return;
+    }
+    job->func = &func;
+    job->max_parallel = max_parallel;
+    job->node = node;
+    job->remaining.store(task_n);
+    job->participants.store(1); //0番は呼び出し元
+    for (int i = 0; i < max_parallel; i++) {
+        job->ranges[i].store(range_pack(task_n * i / max_parallel, task_n * (i + 1) / max_parallel));
+    }
+    job->state.store(JOB_ACTIVE);
+    m_jobSeq.fetch_add(1);
+    if (m_sleeping.load() > 0) {
+        //待機中のワーカーがいる場合のみ起床させる
+        std::lock_guard<std::mutex> lock(m_mtx);
+        m_cv.notify_all();
+    }
+
+    participate(job, 0);
+    for (int count = 0; job->remaining.load() > 0; count++) {
+        sleep_hybrid(count);
+    }
+    job->state.store(JOB_RESERVED);
+    for (int count = 0; job->refs.load() > 0; count++) {
+        sleep_hybrid(count);
+    }
+    job->state.store(JOB_FREE);
+}
@@ -0,0 +1,110 @@
+﻿// -----------------------------------------------------------------------------------------
+// QSVEnc/NVEnc by rigaya
+// -----------------------------------------------------------------------------------------
+// The MIT License
+//
+// Copyright (c) 2011-2016 rigaya
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+// --------------------------------------------------------------------------------------------
+
+#pragma once
+#ifndef __RGY_THREAD_POOL_H__
+#define __RGY_THREAD_POOL_H__
+
+#include <cstdint>
+#include <atomic>
+#include <array>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "rgy_osdep.h"
+#include "cpu_info.h"
+
+static const int RGY_THREAD_POOL_MAX_PARALLEL = 64; //1ジョブを同時に処理できるスレッド数の上限
+static const int RGY_THREAD_POOL_MAX_JOBS     = 16; //同時に投入できるジョブ数の上限
+
+//プロセス全体で共有するワーカースレッドプール
+//ジョブはtask_n個のバンドに分割され、各参加スレッドに連続したバンドの範囲を割り当てる
+//自分の範囲を処理し終えたスレッドは、ほかのスレッドの範囲の末尾からバンドを奪って処理する
+//ジョブの受け渡しはatomicのみで行い、ワーカーが待機状態に入っている場合のみ起床させる
+//enableAffinity()を呼ぶと、ワーカーはNUMAノードごと・物理コアごとに論理プロセッサへ固定される
+class RGYThreadPool {
+public:
+    RGYThreadPool(int workers);
+    ~RGYThreadPool();
+
+    //プロセス全体で共有するプールを取得する (初回呼び出し時に作成)
+    static RGYThreadPool *get();
+
+    //呼び出し元を含めて処理に参加できるスレッド数
+    int threadCount() const { return (int)m_workers.size() + 1; }
+
+    //ワーカーを論理プロセッサに固定する (以降、各ワーカーが次に起床した時点で反映される)
+    void enableAffinity();
+
+    //func(task_id)をtask_id = 0 ～ task_n-1 について並列に実行し、すべて終了するまで待機する
+    //呼び出し元のスレッドも処理に参加する
+    //max_parallel : 呼び出し元を含め、同時にこのジョブを処理するスレッド数の上限
+    //numa_local   : 呼び出し元と同じNUMAノードに固定されたワーカーのみで処理する (enableAffinity()時のみ有効)
+    void parallel_for(int task_n, int max_parallel, const std::function<void(int task_id)>& func, bool numa_local = false);
+
+protected:
+    struct Job {
+        std::atomic<int> state;        //JOB_FREE / JOB_RESERVED / JOB_ACTIVE
+        std::atomic<int> refs;         //このジョブを参照中のワーカー数
+        std::atomic<int> participants; //参加したスレッド数 (担当範囲の番号の払い出しに使用)
+        std::atomic<int> remaining;    //未完了のバンド数
+        int max_parallel;
+        int node;                      //処理を行うNUMAノード (-1なら制限なし)
+        const std::function<void(int task_id)> *func;
+        std::array<std::atomic<uint64_t>, RGY_THREAD_POOL_MAX_PARALLEL> ranges; //各参加スレッドの担当範囲 [begin, end)
+
+        Job();
+    };
+    enum {
+        JOB_FREE = 0,
+        JOB_RESERVED,
+        JOB_ACTIVE,
+    };
+    void workerFunc(int worker_id);
+    //現在のスレッドが実行されているNUMAノード
+    int currentNode() const;
+    //ジョブに参加し、処理できるバンドがなくなるまで処理する
+    bool participate(Job *job, int idx);
+    static bool runOwn(Job *job, int idx);
+    static bool runSteal(Job *job, int idx);
+
+    std::vector<std::thread> m_workers;
+    std::vector<cpu_logical_processor_t> m_processors; //NUMAノード→SMT→物理コアの順に並べた論理プロセッサ
+    std::vector<int> m_workerProcessor; //各ワーカーを固定する論理プロセッサ (m_processorsのindex)
+    std::vector<int> m_nodeWorkers;     //NUMAノードごとのワーカー数
+    std::atomic<bool> m_affinity;
+    std::array<Job, RGY_THREAD_POOL_MAX_JOBS> m_jobs;
+    std::atomic<uint32_t> m_jobSeq;  //ジョブが投入されるたびに更新
+    std::atomic<int> m_sleeping;     //待機状態のワーカー数
+    std::atomic<bool> m_abort;
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+};
+
+#endif //__RGY_THREAD_POOL_H__
@@ -588,6 +588,23 @@ bool rgy_get_filesize(const char *filepath, uint64_t *filesize) {
 #endif //#if defined(_WIN32) || defined(_WIN64)
 }
 
+//キャッシュが入力ファイルと一致しているかの確認に使用する更新時刻 (取得できない場合は-1)
+int64_t rgy_get_file_mtime(FILE *fp) {
+#if defined(_WIN32) || defined(_WIN64)
+    FILETIME ft = { 0 };
+    if (!GetFileTime((HANDLE)_get_osfhandle(_fileno(fp)), nullptr, nullptr, &ft)) {
+        return -1;
+    }
+    return ((int64_t)ft.dwHighDateTime << 32) | (int64_t)ft.dwLowDateTime;
+#else
+    struct stat st = { 0 };
+    if (fstat(fileno(fp), &st) != 0) {
+        return -1;
+    }
+    return (int64_t)st.st_mtime;
+#endif
+}
+
 #if defined(_WIN32) || defined(_WIN64)
 bool rgy_get_filesize(const WCHAR *filepath, uint64_t *filesize) {
     WIN32_FILE_ATTRIBUTE_DATA fd = { 0 };
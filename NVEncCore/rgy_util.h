@@ -541,6 +541,7 @@ std::vector<std::string> sep_cmd(const std::string &cmd);
 std::string str_replace(std::string str, const std::string& from, const std::string& to);
 std::string GetFullPath(const char *path);
 bool rgy_get_filesize(const char *filepath, uint64_t *filesize);
+int64_t rgy_get_file_mtime(FILE *fp);
 std::pair<int, std::string> PathRemoveFileSpecFixed(const std::string& path);
 std::string PathRemoveExtensionS(const std::string& path);
 bool CreateDirectoryRecursive(const char *dir);
@@ -579,6 +580,17 @@ static inline uint32_t popcnt64(uint64_t bits) {
     return (uint32_t)bits;
 }
 
+//最下位の立っているビットの位置を返す (bits != 0であること)
+static inline uint32_t ctz32(uint32_t bits) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, bits);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctz(bits);
+#endif
+}
+
 template<typename type>
 static std::basic_string<type> repeatStr(std::basic_string<type> str, int count) {
     std::basic_string<type> ret;
@@ -1185,46 +1197,104 @@ public:
     vector<vector<int>> m_nCombinationList;
 };
 
+//使い回すオブジェクトのプール
+//空きオブジェクトはロックフリーのスタック(free-list)で管理し、取得・返却ともにO(1)で、任意のスレッドから呼び出せる
+//取得したオブジェクトはshared_ptrで返し、参照がなくなった時点でプールに返却される
+//オブジェクトはプールの破棄まで解放されないので、プールより先にすべての参照を破棄すること
 template<typename T>
-class RGYListRef {
+class RGYObjectPool {
 private:
-    std::vector<std::unique_ptr<T>> m_objs;
-    std::unordered_map<T *, std::atomic<int>> m_refCounts;
-public:
-    RGYListRef() : m_objs(), m_refCounts() {};
-    ~RGYListRef() {
-        m_refCounts.clear();
-        m_objs.clear();
-    }
-    std::shared_ptr<T> get(T *ptr) {
-        if (ptr == nullptr || m_refCounts.count(ptr) == 0) {
-            return std::shared_ptr<T>();
+    static const uint32_t CHUNK_SIZE = 64;   //1チャンクあたりのオブジェクト数
+    static const uint32_t MAX_CHUNKS = 1024; //チャンク数の上限
+    struct Node {
+        std::unique_ptr<T> obj;
+        std::atomic<uint32_t> next; //free-listの次のノード (index+1, 0なら終端)
+        Node() : obj(), next(0) {};
+    };
+    std::array<std::atomic<Node *>, MAX_CHUNKS> m_chunks;
+    std::atomic<uint32_t> m_nodeCount;
+    std::atomic<uint64_t> m_freeHead; //上位32bit: ABA対策のタグ, 下位32bit: 先頭ノードのindex+1 (0なら空)
+
+    Node *node(uint32_t idx) {
+        return m_chunks[idx / CHUNK_SIZE].load() + (idx % CHUNK_SIZE);
+    }
+    //新しいノードを確保する (チャンクがなければ作成する)
+    Node *allocNode(uint32_t *pIdx) {
+        const uint32_t idx = m_nodeCount.fetch_add(1);
+        if (idx >= CHUNK_SIZE * MAX_CHUNKS) {
+            m_nodeCount.fetch_sub(1);
+            return nullptr;
+        }
+        auto& chunk = m_chunks[idx / CHUNK_SIZE];
+        if (chunk.load() == nullptr) {
+            Node *newChunk = new Node[CHUNK_SIZE];
+            Node *expected = nullptr;
+            if (!chunk.compare_exchange_strong(expected, newChunk)) {
+                delete[] newChunk; //ほかのスレッドが先に作成した
+            }
+        }
+        *pIdx = idx;
+        return node(idx);
+    }
+    void release(uint32_t idx) {
+        Node *ptr = node(idx);
+        uint64_t head = m_freeHead.load();
+        do {
+            ptr->next.store((uint32_t)head);
+        } while (!m_freeHead.compare_exchange_weak(head, (((head >> 32) + 1) << 32) | (idx + 1)));
+    }
+    bool acquire(uint32_t *pIdx) {
+        uint64_t head = m_freeHead.load();
+        for (;;) {
+            const uint32_t top = (uint32_t)head;
+            if (top == 0) {
+                return false;
+            }
+            const uint32_t next = node(top - 1)->next.load();
+            if (m_freeHead.compare_exchange_weak(head, (((head >> 32) + 1) << 32) | next)) {
+                *pIdx = top - 1;
+                return true;
+            }
         }
-        m_refCounts[ptr]++;
-        return std::shared_ptr<T>(ptr, [this](T *ptr) {
-            m_refCounts[ptr]--;
+    }
+    std::shared_ptr<T> wrap(uint32_t idx) {
+        return std::shared_ptr<T>(node(idx)->obj.get(), [this, idx](T *) {
+            release(idx);
         });
     }
+public:
+    RGYObjectPool() : m_chunks(), m_nodeCount(0), m_freeHead(0) {
+        for (auto& chunk : m_chunks) {
+            chunk.store(nullptr);
+        }
+    };
+    ~RGYObjectPool() {
+        for (auto& chunk : m_chunks) {
+            delete[] chunk.load();
+            chunk.store(nullptr);
+        }
+    }
+    //空いているオブジェクトを取得する
+    //空きがなければ新たに作成し、initFuncで初期化する (initFuncが0以外を返した場合は空のshared_ptrを返す)
     std::shared_ptr<T> get(std::function<int(T*)> initFunc = nullptr) {
-        for (auto &count : m_refCounts) {
-            if (count.second == 0) {
-                m_refCounts[count.first]++;
-                return std::shared_ptr<T>(count.first, [this](T *ptr) {
-                    m_refCounts[ptr]--;
-                });
-            }
+        uint32_t idx = 0;
+        if (acquire(&idx)) {
+            return wrap(idx);
         }
-
-        auto obj = std::make_unique<T>();
-        auto ptr = obj.get();
-        if (initFunc && initFunc(ptr)) {
+        Node *ptr = allocNode(&idx);
+        if (ptr == nullptr) {
             return std::shared_ptr<T>();
         }
-        m_refCounts[ptr] = 1;
-        m_objs.push_back(std::move(obj));
-        return std::shared_ptr<T>(ptr, [this](T *ptr) {
-            m_refCounts[ptr]--;
-        });
+        ptr->obj = std::make_unique<T>();
+        if (initFunc && initFunc(ptr->obj.get())) {
+            ptr->obj.reset(); //初期化に失敗したオブジェクトは破棄し、free-listにも戻さない
+            return std::shared_ptr<T>();
+        }
+        return wrap(idx);
+    }
+    //作成済みのオブジェクト数
+    uint32_t size() const {
+        return m_nodeCount.load();
     }
 };
 